@@ -0,0 +1,235 @@
+// Headless scaling benchmark for AnimationLoader::loadAnimationSequence:
+// loads the bundled sequence (Models/Anim/AnimatedObject 1..50 by default)
+// with 1, 2, 4, ... worker threads up to N and reports the median wall time,
+// speedup and parallel efficiency against one thread. Textures are decoded on
+// the workers but not uploaded (TEXTURES_DEFERRED), so no GL context is needed.
+// Speedup is bounded by the cores of the machine; N defaults to the hardware
+// thread count (at least 4, so the parallel path always runs).
+// The sequence's memory is reported with one topology per frame (the untimed
+// first load) and with the topology shared between frames (the timed loads).
+// A progressive load (setProgressiveLoading()) with the most threads is timed
+// last: until loadAnimationSequence() returns with the first frame, and until
+// finishLoading() has every frame.
+//
+// Usage: AnimLoadBench [-a base start end] [--threads N] [--reps N] [--json out.json] [--trace trace.json]
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <cstdlib>
+#include <chrono>
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+#include "AnimationLoader.h"
+#include "Trace.h"
+#include "BenchMemory.h"
+
+namespace {
+    struct ScalingResult {
+        int threads;
+        double medianMs;
+        double minMs;
+        double speedup;         // Median of one thread / median
+        double efficiency;      // speedup / threads
+        long long allocations;  // operator new calls in one load
+    };
+
+    double percentile(const std::vector<double>& sorted, double p) {
+        size_t rank = (size_t)(p * sorted.size() + 0.999999);
+        rank = std::min(std::max(rank, (size_t)1), sorted.size());
+        return sorted[rank - 1];
+    }
+
+    // Returns the load time in ms, or a negative value if a frame failed to load
+    double timeLoad(const std::string& base, int startFrame, int endFrame, int threads, bool shareTopology,
+                    int& frameCount, long long& allocations, MemoryUsage& memory) {
+        AnimationLoader animation;
+        animation.setVerbose(false);
+        animation.setLoadThreads(threads);
+        animation.setShareTopology(shareTopology);
+        animation.setTextureLoading(TEXTURES_DEFERRED);
+
+        long long allocationsBefore = BenchMemory::allocations();
+        auto start = std::chrono::steady_clock::now();
+        bool loaded = animation.loadAnimationSequence(base, startFrame, endFrame);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        allocations = BenchMemory::allocations() - allocationsBefore;
+        frameCount = animation.getTotalFrames();
+        memory = animation.getMemoryUsage();
+        if (!loaded || frameCount != endFrame - startFrame + 1) {
+            return -1.0;
+        }
+        return ms;
+    }
+
+    // Time to the first frame and to every frame of a progressive load; false if a frame failed
+    bool timeProgressiveLoad(const std::string& base, int startFrame, int endFrame, int threads,
+                             double& firstMs, double& allMs) {
+        AnimationLoader animation;
+        animation.setVerbose(false);
+        animation.setLoadThreads(threads);
+        animation.setTextureLoading(TEXTURES_DEFERRED);
+        animation.setProgressiveLoading(true);
+
+        auto start = std::chrono::steady_clock::now();
+        bool loaded = animation.loadAnimationSequence(base, startFrame, endFrame);
+        firstMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        animation.finishLoading();
+        allMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return loaded && animation.getKeptFrameCount() == endFrame - startFrame + 1;
+    }
+
+    bool writeJson(const std::string& filename, const std::string& base, int frameCount,
+                   const std::vector<ScalingResult>& results, const MemoryUsage& separate, const MemoryUsage& shared,
+                   double firstFrameMs, double progressiveMs) {
+        std::ofstream out(filename);
+        if (!out.is_open()) {
+            return false;
+        }
+        out << std::fixed << std::setprecision(3);
+        out << "{\n  \"benchmark\": \"anim_load\",\n  \"sequence\": \"" << base << "\", \"frames\": " << frameCount
+            << ", \"hardware_threads\": " << std::thread::hardware_concurrency()
+            << ", \"peak_rss_kb\": " << BenchMemory::peakResidentKb() << ",\n";
+        out << "  \"memory\": {\"separate_cpu_bytes\": " << separate.getCpuBytes()
+            << ", \"shared_cpu_bytes\": " << shared.getCpuBytes()
+            << ", \"separate_gpu_bytes\": " << separate.getGpuBytes()
+            << ", \"shared_gpu_bytes\": " << shared.getGpuBytes() << "},\n";
+        out << "  \"progressive\": {\"first_frame_ms\": " << firstFrameMs << ", \"all_frames_ms\": " << progressiveMs
+            << "},\n";
+        out << "  \"results\": [\n";
+        for (size_t i = 0; i < results.size(); i++) {
+            const ScalingResult& r = results[i];
+            out << "    {\"threads\": " << r.threads << ", \"median_ms\": " << r.medianMs << ", \"min_ms\": " << r.minMs
+                << ", \"speedup\": " << r.speedup << ", \"efficiency\": " << r.efficiency
+                << ", \"allocations\": " << r.allocations << "}"
+                << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        out << "  ]\n}\n";
+        return true;
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string base = "Models/Anim/AnimatedObject";
+    int startFrame = 1;
+    int endFrame = 50;
+    int maxThreads = std::max(4, (int)std::thread::hardware_concurrency());
+    int repetitions = 3;
+    std::string jsonFile;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-a" && i + 3 < argc) {
+            base = argv[++i];
+            startFrame = std::atoi(argv[++i]);
+            endFrame = std::atoi(argv[++i]);
+        }
+        else if (arg == "--threads" && i + 1 < argc) {
+            maxThreads = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "--reps" && i + 1 < argc) {
+            repetitions = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "--json" && i + 1 < argc) {
+            jsonFile = argv[++i];
+        }
+        else if (arg == "--trace" && i + 1 < argc) {
+            traceRecorder.start(argv[++i]);
+        }
+        else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<int> threadCounts;
+    for (int threads = 1; threads < maxThreads; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(maxThreads);
+
+    std::cout << "Loading " << base << " " << startFrame << ".." << endFrame << ", "
+              << repetitions << " timed runs per thread count (" << std::thread::hardware_concurrency()
+              << " hardware threads)" << std::endl << std::endl;
+
+    // Untimed load first so every thread count sees a warm file cache
+    int frameCount = 0;
+    long long allocations = 0;
+    MemoryUsage separate;
+    MemoryUsage shared;
+    if (timeLoad(base, startFrame, endFrame, 1, false, frameCount, allocations, separate) < 0.0) {
+        std::cerr << "Error: Failed to load the sequence" << std::endl;
+        return 1;
+    }
+
+    std::cout << std::right << std::setw(8) << "threads" << std::setw(12) << "median ms"
+              << std::setw(10) << "min ms" << std::setw(10) << "speedup" << std::setw(12) << "efficiency"
+              << std::setw(10) << "frames/s" << std::endl;
+    std::cout << std::fixed;
+
+    std::vector<ScalingResult> results;
+    for (int threads : threadCounts) {
+        std::vector<double> times;
+        for (int run = 0; run < repetitions; run++) {
+            double ms = timeLoad(base, startFrame, endFrame, threads, true, frameCount, allocations, shared);
+            if (ms < 0.0) {
+                std::cerr << "Error: Failed to load the sequence with " << threads << " threads" << std::endl;
+                return 1;
+            }
+            times.push_back(ms);
+        }
+        std::sort(times.begin(), times.end());
+
+        ScalingResult r;
+        r.threads = threads;
+        r.medianMs = percentile(times, 0.5);
+        r.minMs = times.front();
+        r.speedup = results.empty() ? 1.0 : results.front().medianMs / std::max(r.medianMs, 1e-6);
+        r.efficiency = r.speedup / threads;
+        r.allocations = allocations;
+        results.push_back(r);
+
+        std::cout << std::setw(8) << threads << std::setprecision(1) << std::setw(12) << r.medianMs
+                  << std::setw(10) << r.minMs << std::setprecision(2) << std::setw(10) << r.speedup
+                  << std::setw(12) << r.efficiency << std::setprecision(1)
+                  << std::setw(10) << frameCount / (r.medianMs / 1000.0) << std::endl;
+    }
+    std::vector<double> firstTimes;
+    std::vector<double> allTimes;
+    for (int run = 0; run < repetitions; run++) {
+        double firstMs = 0.0;
+        double allMs = 0.0;
+        if (!timeProgressiveLoad(base, startFrame, endFrame, maxThreads, firstMs, allMs)) {
+            std::cerr << "Error: Failed to load the sequence progressively" << std::endl;
+            return 1;
+        }
+        firstTimes.push_back(firstMs);
+        allTimes.push_back(allMs);
+    }
+    std::sort(firstTimes.begin(), firstTimes.end());
+    std::sort(allTimes.begin(), allTimes.end());
+    double firstFrameMs = percentile(firstTimes, 0.5);
+    double progressiveMs = percentile(allTimes, 0.5);
+    std::cout << std::endl << "Progressive load, " << maxThreads << " threads: first frame after " << std::setprecision(1)
+              << firstFrameMs << " ms, every frame after " << progressiveMs << " ms (median)" << std::endl;
+
+    std::cout << std::endl << "Memory, one topology per frame:" << std::endl;
+    separate.print(std::cout);
+    std::cout << "Memory, topology shared between frames:" << std::endl;
+    shared.print(std::cout);
+    std::cout << "CPU memory reduced " << std::setprecision(1)
+              << (double)separate.getCpuBytes() / std::max(shared.getCpuBytes(), (size_t)1) << "x" << std::endl;
+    std::cout << "Peak RSS: " << BenchMemory::peakResidentKb() / 1024 << " MB" << std::endl;
+
+    traceRecorder.stop();
+    if (!jsonFile.empty()) {
+        if (!writeJson(jsonFile, base, frameCount, results, separate, shared, firstFrameMs, progressiveMs)) {
+            std::cerr << "Error: Cannot write " << jsonFile << std::endl;
+            return 1;
+        }
+        std::cout << "Results written to " << jsonFile << std::endl;
+    }
+    return 0;
+}
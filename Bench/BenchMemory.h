@@ -0,0 +1,67 @@
+#ifndef BENCH_MEMORY_H
+#define BENCH_MEMORY_H
+
+// Heap allocation counting and peak resident set size for the benchmark
+// programs. Replaces the global operator new/delete, so include it from
+// exactly one translation unit (the benchmark's main file).
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace BenchMemory {
+    inline std::atomic<long long>& allocationCounter() {
+        static std::atomic<long long> count(0);
+        return count;
+    }
+
+    inline std::atomic<long long>& allocatedBytesCounter() {
+        static std::atomic<long long> bytes(0);
+        return bytes;
+    }
+
+    // operator new calls since the program started
+    inline long long allocations() { return allocationCounter().load(std::memory_order_relaxed); }
+    inline long long allocatedBytes() { return allocatedBytesCounter().load(std::memory_order_relaxed); }
+
+    // Peak resident set size of the process in KB
+    inline long long peakResidentKb() {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters;
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+            return (long long)(counters.PeakWorkingSetSize / 1024);
+        }
+        return 0;
+#else
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss;  // KB on Linux
+#endif
+    }
+
+    inline void* allocate(std::size_t size) {
+        allocationCounter().fetch_add(1, std::memory_order_relaxed);
+        allocatedBytesCounter().fetch_add((long long)size, std::memory_order_relaxed);
+        void* p = std::malloc(size ? size : 1);
+        if (!p) {
+            throw std::bad_alloc();
+        }
+        return p;
+    }
+}
+
+void* operator new(std::size_t size) { return BenchMemory::allocate(size); }
+void* operator new[](std::size_t size) { return BenchMemory::allocate(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+#endif
@@ -0,0 +1,183 @@
+// Headless benchmark for the vertex-animation codec (VertexCodec.h): loads a
+// sequence (Models/Anim/AnimatedObject 1..50 by default) with shared topology,
+// encodes the per-frame positions and normals and reports the compression
+// ratio, the largest decoding error against the loaded floats, and the
+// decode speed for playback order and for random frame access.
+// Decode MB/s counts the float data produced (positions + normals).
+//
+// Usage: CodecBench [-a base start end] [--position-bits N] [--normal-bits N]
+//                   [--keyframes N] [--reps N] [--json out.json]
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "AnimationLoader.h"
+#include "VertexCodec.h"
+
+namespace {
+    struct ErrorStats {
+        double maxPosition;
+        double maxNormal;
+        ErrorStats() : maxPosition(0.0), maxNormal(0.0) {}
+    };
+
+    double maxComponentError(const std::vector<Vec3>& a, const std::vector<Vec3>& b) {
+        double worst = 0.0;
+        for (size_t i = 0; i < a.size(); i++) {
+            worst = std::max(worst, (double)std::fabs(a[i].x - b[i].x));
+            worst = std::max(worst, (double)std::fabs(a[i].y - b[i].y));
+            worst = std::max(worst, (double)std::fabs(a[i].z - b[i].z));
+        }
+        return worst;
+    }
+
+    double secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string base = "Models/Anim/AnimatedObject";
+    int startFrame = 1;
+    int endFrame = 50;
+    int repetitions = 20;
+    VertexCodecSettings settings;
+    std::string jsonFile;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-a" && i + 3 < argc) {
+            base = argv[++i];
+            startFrame = std::atoi(argv[++i]);
+            endFrame = std::atoi(argv[++i]);
+        }
+        else if (arg == "--position-bits" && i + 1 < argc) {
+            settings.positionBits = std::atoi(argv[++i]);
+        }
+        else if (arg == "--normal-bits" && i + 1 < argc) {
+            settings.normalBits = std::atoi(argv[++i]);
+        }
+        else if (arg == "--keyframes" && i + 1 < argc) {
+            settings.keyframeInterval = std::atoi(argv[++i]);
+        }
+        else if (arg == "--reps" && i + 1 < argc) {
+            repetitions = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "--json" && i + 1 < argc) {
+            jsonFile = argv[++i];
+        }
+        else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    AnimationLoader animation;
+    animation.setVerbose(false);
+    animation.setTextureLoading(TEXTURES_SKIP);
+    if (!animation.loadAnimationSequence(base, startFrame, endFrame)) {
+        return 1;
+    }
+    int frameCount = animation.getTotalFrames();
+
+    std::vector<const ObjLoader*> frames;
+    for (int f = 0; f < frameCount; f++) {
+        frames.push_back(animation.getFrame(f));
+    }
+
+    CompressedAnimation compressed;
+    compressed.reset(settings);
+    auto encodeStart = std::chrono::steady_clock::now();
+    for (const ObjLoader* frame : frames) {
+        if (!compressed.addFrame(frame->getVertices(), frame->getNormals())) {
+            std::cerr << "Error: Frames differ in vertex or normal count" << std::endl;
+            return 1;
+        }
+    }
+    double encodeSeconds = secondsSince(encodeStart);
+
+    // Accuracy, in playback order
+    VertexDecoder decoder(compressed);
+    std::vector<Vec3> positions;
+    std::vector<Vec3> normals;
+    ErrorStats error;
+    for (int f = 0; f < frameCount; f++) {
+        decoder.decodeFrame(f, positions, normals);
+        error.maxPosition = std::max(error.maxPosition, maxComponentError(positions, frames[f]->getVertices()));
+        error.maxNormal = std::max(error.maxNormal, maxComponentError(normals, frames[f]->getNormals()));
+    }
+
+    // Playback: every frame in order, looping
+    auto sequentialStart = std::chrono::steady_clock::now();
+    for (int run = 0; run < repetitions; run++) {
+        for (int f = 0; f < frameCount; f++) {
+            decoder.decodeFrame(f, positions, normals);
+        }
+    }
+    double sequentialSeconds = secondsSince(sequentialStart);
+
+    // Scrubbing: a fixed pseudo-random order, each frame decoded from its keyframe
+    std::vector<int> order;
+    unsigned int seed = 12345;
+    for (int i = 0; i < frameCount * repetitions; i++) {
+        seed = seed * 1103515245u + 12345u;
+        order.push_back((seed >> 8) % frameCount);
+    }
+    auto randomStart = std::chrono::steady_clock::now();
+    for (int f : order) {
+        decoder.decodeFrame(f, positions, normals);
+    }
+    double randomSeconds = secondsSince(randomStart);
+
+    double rawMb = compressed.getRawBytes() / (1024.0 * 1024.0);
+    double encodedMb = compressed.getEncodedBytes() / (1024.0 * 1024.0);
+    double ratio = (double)compressed.getRawBytes() / std::max(compressed.getEncodedBytes(), (size_t)1);
+    double frameMb = rawMb / frameCount;
+    double sequentialMs = sequentialSeconds * 1000.0 / (frameCount * repetitions);
+    double randomMs = randomSeconds * 1000.0 / order.size();
+    double sequentialMbPerSecond = frameMb / (sequentialMs / 1000.0);
+    double randomMbPerSecond = frameMb / (randomMs / 1000.0);
+
+    std::cout << std::fixed;
+    std::cout << "Sequence: " << base << " " << startFrame << ".." << endFrame << ", " << frameCount << " frames, "
+              << compressed.getVertexCount() << " positions + " << compressed.getNormalCount() << " normals per frame"
+              << std::endl;
+    std::cout << "Settings: " << settings.positionBits << "-bit positions, " << settings.normalBits
+              << "-bit normals, keyframe every " << compressed.getSettings().keyframeInterval << " frames" << std::endl;
+    std::cout << std::setprecision(2) << "Size: " << rawMb << " MB -> " << encodedMb << " MB (ratio "
+              << std::setprecision(1) << ratio << ":1), encoded in " << std::setprecision(0)
+              << encodeSeconds * 1000.0 << " ms" << std::endl;
+    std::cout << std::setprecision(6) << "Max error: position " << error.maxPosition << " (step "
+              << compressed.getPositionStep() << "), normal component " << error.maxNormal << " (step "
+              << compressed.getNormalStep() << ")" << std::endl;
+    std::cout << std::setprecision(3) << "Decode, playback order: " << sequentialMs << " ms/frame, "
+              << std::setprecision(0) << sequentialMbPerSecond << " MB/s" << std::endl;
+    std::cout << std::setprecision(3) << "Decode, random frames:  " << randomMs << " ms/frame, "
+              << std::setprecision(0) << randomMbPerSecond << " MB/s" << std::endl;
+
+    if (!jsonFile.empty()) {
+        std::ofstream out(jsonFile);
+        if (!out.is_open()) {
+            std::cerr << "Error: Cannot write " << jsonFile << std::endl;
+            return 1;
+        }
+        out << std::fixed << std::setprecision(6);
+        out << "{\n  \"benchmark\": \"codec\",\n  \"frames\": " << frameCount
+            << ", \"position_bits\": " << settings.positionBits << ", \"normal_bits\": " << settings.normalBits
+            << ", \"keyframe_interval\": " << compressed.getSettings().keyframeInterval << ",\n"
+            << "  \"raw_bytes\": " << compressed.getRawBytes() << ", \"encoded_bytes\": " << compressed.getEncodedBytes()
+            << ", \"ratio\": " << ratio << ",\n"
+            << "  \"max_position_error\": " << error.maxPosition << ", \"max_normal_error\": " << error.maxNormal << ",\n"
+            << "  \"encode_ms\": " << encodeSeconds * 1000.0
+            << ", \"sequential_ms_per_frame\": " << sequentialMs << ", \"sequential_mb_per_s\": " << sequentialMbPerSecond
+            << ", \"random_ms_per_frame\": " << randomMs << ", \"random_mb_per_s\": " << randomMbPerSecond << "\n}\n";
+        std::cout << "Results written to " << jsonFile << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,230 @@
+// Headless comparison of the two ways to load a vertex animation: the OBJ
+// sequence (one .obj and .mtl per frame, parsed) and a .anim container
+// (AnimContainer.h, memory-mapped and copied). Packs the sequence
+// (Models/Anim/AnimatedObject 1..50 by default) into <base>.anim first, then
+// reports the median time to the first displayable frame, the time to load
+// every frame, the cost of a random frame from the container and the sizes
+// on disk. Files are read from a warm cache; textures are decoded but not
+// uploaded (TEXTURES_DEFERRED), so no GL context is needed.
+//
+// Usage: ContainerBench [-a base start end] [--anim out.anim] [--reps N] [--json out.json]
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <chrono>
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+#include "AnimationLoader.h"
+#include "AnimContainer.h"
+#include "BenchMemory.h"
+
+namespace {
+    struct Timing {
+        double medianMs;
+        double minMs;
+    };
+
+    double millisecondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Runs 'body' (which returns false on failure) 'repetitions' times
+    template <typename Body>
+    bool timeRuns(int repetitions, Timing& timing, Body body) {
+        std::vector<double> times;
+        for (int run = 0; run < repetitions; run++) {
+            auto start = std::chrono::steady_clock::now();
+            if (!body()) {
+                return false;
+            }
+            times.push_back(millisecondsSince(start));
+        }
+        std::sort(times.begin(), times.end());
+        timing.medianMs = times[times.size() / 2];
+        timing.minMs = times.front();
+        return true;
+    }
+
+    long long fileSize(const std::string& filename) {
+        std::ifstream file(filename, std::ios::binary | std::ios::ate);
+        return file.is_open() ? (long long)file.tellg() : 0;
+    }
+
+    void printRow(const std::string& name, const Timing& timing) {
+        std::cout << "  " << std::left << std::setw(28) << name << std::right << std::setprecision(2)
+                  << std::setw(10) << timing.medianMs << " ms  (min " << timing.minMs << ")" << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string base = "Models/Anim/AnimatedObject";
+    int startFrame = 1;
+    int endFrame = 50;
+    int repetitions = 5;
+    std::string animFile;
+    std::string jsonFile;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-a" && i + 3 < argc) {
+            base = argv[++i];
+            startFrame = std::atoi(argv[++i]);
+            endFrame = std::atoi(argv[++i]);
+        }
+        else if (arg == "--anim" && i + 1 < argc) {
+            animFile = argv[++i];
+        }
+        else if (arg == "--reps" && i + 1 < argc) {
+            repetitions = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "--json" && i + 1 < argc) {
+            jsonFile = argv[++i];
+        }
+        else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (animFile.empty()) {
+        animFile = base + ".anim";  // Beside the sequence, so texture names still resolve
+    }
+
+    // Packing loads the whole sequence once, which also warms the file cache
+    std::vector<std::string> objFiles;
+    long long objBytes = 0;
+    {
+        AnimationLoader sequence;
+        sequence.setVerbose(false);
+        sequence.setTextureLoading(TEXTURES_SKIP);
+        if (!sequence.loadAnimationSequence(base, startFrame, endFrame)) {
+            return 1;
+        }
+        std::vector<const ObjLoader*> frames;
+        std::vector<int> frameNumbers;
+        for (int i = 0; i < sequence.getKeptFrameCount(); i++) {
+            frames.push_back(sequence.getFrame(i));
+            frameNumbers.push_back(sequence.getFrameNumber(i));
+        }
+        if (!writeAnimContainer(animFile, frames, frameNumbers)) {
+            return 1;
+        }
+    }
+    for (int f = startFrame; f <= endFrame; f++) {
+        std::ostringstream name;
+        name << base << std::setw(4) << std::setfill('0') << f;
+        if (fileSize(name.str() + ".obj") > 0) {
+            objFiles.push_back(name.str() + ".obj");
+            objBytes += fileSize(name.str() + ".obj") + fileSize(name.str() + ".mtl");
+        }
+    }
+    long long animBytes = fileSize(animFile);
+    int frameCount = objFiles.size();
+    int threads = std::min((int)std::thread::hardware_concurrency(), 8);
+
+    std::cout << "Sequence: " << base << " " << startFrame << ".." << endFrame << ", " << frameCount
+              << " frames, " << repetitions << " timed runs each" << std::endl;
+    std::cout << std::fixed << std::setprecision(1) << "On disk: OBJ + MTL " << objBytes / (1024.0 * 1024.0)
+              << " MB, " << animFile << " " << animBytes / (1024.0 * 1024.0) << " MB" << std::endl;
+
+    // Time to first frame: everything needed before frame 0 can be drawn
+    Timing objFirst, animFirst;
+    bool ok = timeRuns(repetitions, objFirst, [&]() {
+        ObjLoader model;
+        model.setVerbose(false);
+        model.setTextureLoading(TEXTURES_DEFERRED);
+        return model.loadObj(objFiles.front());
+    });
+    ok = ok && timeRuns(repetitions, animFirst, [&]() {
+        AnimContainer container;
+        ObjLoader model;
+        model.setTextureLoading(TEXTURES_DEFERRED);
+        if (!container.open(animFile) ||
+            !model.readTopology(container.getTopologyData(), container.getTopologySize(), container.getDirectory())) {
+            return false;
+        }
+        model.setFrameVertices(container.getPositions(0), container.getVertexCount(),
+                               container.getNormals(0), container.getNormalCount());
+        return true;
+    });
+
+    // Every frame
+    auto loadSequence = [&](int loadThreads) {
+        AnimationLoader animation;
+        animation.setVerbose(false);
+        animation.setLoadThreads(loadThreads);
+        animation.setTextureLoading(TEXTURES_DEFERRED);
+        return animation.loadAnimationSequence(base, startFrame, endFrame) && animation.getTotalFrames() == frameCount;
+    };
+    Timing objAll, objAllThreaded, animAll;
+    ok = ok && timeRuns(repetitions, objAll, [&]() { return loadSequence(1); });
+    ok = ok && (threads <= 1 || timeRuns(repetitions, objAllThreaded, [&]() { return loadSequence(threads); }));
+    ok = ok && timeRuns(repetitions, animAll, [&]() {
+        AnimationLoader animation;
+        animation.setVerbose(false);
+        animation.setTextureLoading(TEXTURES_DEFERRED);
+        return animation.loadAnimationContainer(animFile) && animation.getKeptFrameCount() == frameCount;
+    });
+
+    // Random frames into one model, as a stream slot would get them
+    Timing animRandom;
+    int randomFrames = frameCount * 20;
+    AnimContainer container;
+    ObjLoader model;
+    model.setTextureLoading(TEXTURES_SKIP);
+    ok = ok && container.open(animFile) &&
+         model.readTopology(container.getTopologyData(), container.getTopologySize(), container.getDirectory());
+    ok = ok && timeRuns(repetitions, animRandom, [&]() {
+        unsigned int seed = 12345;
+        for (int i = 0; i < randomFrames; i++) {
+            seed = seed * 1103515245u + 12345u;
+            int frame = (seed >> 8) % container.getFrameCount();
+            model.setFrameVertices(container.getPositions(frame), container.getVertexCount(),
+                                   container.getNormals(frame), container.getNormalCount());
+        }
+        return true;
+    });
+    if (!ok) {
+        std::cerr << "Error: A timed load failed" << std::endl;
+        return 1;
+    }
+    double randomFrameMs = animRandom.medianMs / randomFrames;
+
+    std::cout << "Time to first frame:" << std::endl;
+    printRow("OBJ (parse frame 0)", objFirst);
+    printRow(".anim (map + topology)", animFirst);
+    std::cout << "  speedup " << std::setprecision(1) << objFirst.medianMs / std::max(animFirst.medianMs, 1e-6)
+              << "x" << std::endl;
+    std::cout << "All frames:" << std::endl;
+    printRow("OBJ, 1 thread", objAll);
+    if (threads > 1) {
+        printRow("OBJ, " + std::to_string(threads) + " threads", objAllThreaded);
+    }
+    printRow(".anim", animAll);
+    std::cout << "  speedup " << std::setprecision(1) << objAll.medianMs / std::max(animAll.medianMs, 1e-6)
+              << "x over one thread" << std::endl;
+    std::cout << "Random .anim frame: " << std::setprecision(3) << randomFrameMs << " ms" << std::endl;
+    std::cout << "Peak RSS: " << BenchMemory::peakResidentKb() / 1024 << " MB" << std::endl;
+
+    if (!jsonFile.empty()) {
+        std::ofstream out(jsonFile);
+        if (!out.is_open()) {
+            std::cerr << "Error: Cannot write " << jsonFile << std::endl;
+            return 1;
+        }
+        out << std::fixed << std::setprecision(3);
+        out << "{\n  \"benchmark\": \"container\",\n  \"sequence\": \"" << base << "\", \"frames\": " << frameCount
+            << ",\n  \"obj_bytes\": " << objBytes << ", \"anim_bytes\": " << animBytes << ",\n"
+            << "  \"first_frame_ms\": {\"obj\": " << objFirst.medianMs << ", \"anim\": " << animFirst.medianMs << "},\n"
+            << "  \"all_frames_ms\": {\"obj\": " << objAll.medianMs << ", \"obj_threads\": " << threads
+            << ", \"obj_threaded\": " << (threads > 1 ? objAllThreaded.medianMs : objAll.medianMs)
+            << ", \"anim\": " << animAll.medianMs << "},\n"
+            << "  \"random_frame_ms\": " << randomFrameMs << "\n}\n";
+        std::cout << "Results written to " << jsonFile << std::endl;
+    }
+    return 0;
+}
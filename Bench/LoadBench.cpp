@@ -0,0 +1,285 @@
+// Headless benchmark for ObjLoader::loadObj: loads every .obj in the given
+// directories (Models/ and Models/Anim/ by default) with warmup runs and
+// repetitions, once per texture mode that works without a GL context, and
+// reports median/p95 load time, MB/s of OBJ text and triangles/s.
+// A fresh ObjLoader is used for every run; only loadObj() itself is timed.
+// Heap allocations per load, the model's memory (ObjLoader::getMemoryUsage())
+// and the peak RSS are reported as well.
+//
+// Usage: LoadBench [--reps N] [--warmup N] [--json out.json] [--trace trace.json] [dir ...]
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "ObjLoader.h"
+#include "Trace.h"
+#include "BenchMemory.h"
+
+namespace {
+    struct LoadMode {
+        const char* name;
+        TextureLoading textures;
+    };
+
+    // TEXTURES_UPLOAD needs a context and is left out
+    const LoadMode kModes[] = {
+        { "deferred", TEXTURES_DEFERRED },
+        { "skip", TEXTURES_SKIP }
+    };
+
+    struct LoadResult {
+        std::string file;
+        std::string mode;
+        long long bytes;
+        int triangles;
+        long long allocations;      // operator new calls in one loadObj()
+        MemoryUsage memory;         // Of the loaded model
+        int repetitions;
+        double medianMs;
+        double p95Ms;
+        double minMs;
+        double megabytesPerSecond;  // At the median
+        double trianglesPerSecond;
+    };
+
+    std::vector<std::string> listObjFiles(const std::string& directory) {
+        std::vector<std::string> files;
+        DIR* dir = opendir(directory.c_str());
+        if (!dir) {
+            std::cerr << "Warning: Cannot open directory " << directory << std::endl;
+            return files;
+        }
+        while (dirent* entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            if (name.size() > 4 && name.compare(name.size() - 4, 4, ".obj") == 0) {
+                files.push_back(directory + "/" + name);
+            }
+        }
+        closedir(dir);
+        std::sort(files.begin(), files.end());
+        return files;
+    }
+
+    long long fileSize(const std::string& filename) {
+        struct stat info;
+        return stat(filename.c_str(), &info) == 0 ? (long long)info.st_size : 0;
+    }
+
+    // Nearest-rank percentile of an ascending list
+    double percentile(const std::vector<double>& sorted, double p) {
+        size_t rank = (size_t)(p * sorted.size() + 0.999999);
+        rank = std::min(std::max(rank, (size_t)1), sorted.size());
+        return sorted[rank - 1];
+    }
+
+    // Returns the load time in ms, or a negative value if loading failed
+    double timeLoad(const std::string& filename, TextureLoading textures, int& triangles,
+                    long long& allocations, MemoryUsage& memory) {
+        ObjLoader loader;
+        loader.setVerbose(false);
+        loader.setTextureLoading(textures);
+
+        long long allocationsBefore = BenchMemory::allocations();
+        auto start = std::chrono::steady_clock::now();
+        bool loaded = loader.loadObj(filename);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        allocations = BenchMemory::allocations() - allocationsBefore;
+        if (!loaded) {
+            return -1.0;
+        }
+
+        triangles = 0;
+        for (const auto& range : loader.getDrawRanges()) {
+            triangles += range.triangleCount;
+        }
+        memory = loader.getMemoryUsage();
+        return ms;
+    }
+
+    std::string jsonEscape(const std::string& text) {
+        std::string out;
+        for (char c : text) {
+            if (c == '"' || c == '\\') out += '\\';
+            out += c;
+        }
+        return out;
+    }
+
+    bool writeJson(const std::string& filename, const std::vector<LoadResult>& results, int warmup,
+                   const double* totalMedianMs, long long totalAllocations, const MemoryUsage& totalMemory) {
+        std::ofstream out(filename);
+        if (!out.is_open()) {
+            return false;
+        }
+        out << std::fixed << std::setprecision(3);
+        out << "{\n  \"benchmark\": \"load\",\n  \"warmup\": " << warmup << ",\n";
+        out << "  \"totals\": {\"deferred_ms\": " << totalMedianMs[0] << ", \"skip_ms\": " << totalMedianMs[1]
+            << ", \"allocations\": " << totalAllocations
+            << ", \"model_cpu_bytes\": " << totalMemory.getCpuBytes()
+            << ", \"model_slack_bytes\": " << totalMemory.slack
+            << ", \"peak_rss_kb\": " << BenchMemory::peakResidentKb() << "},\n";
+        out << "  \"results\": [\n";
+        for (size_t i = 0; i < results.size(); i++) {
+            const LoadResult& r = results[i];
+            out << "    {\"file\": \"" << jsonEscape(r.file) << "\", \"mode\": \"" << r.mode << "\""
+                << ", \"bytes\": " << r.bytes << ", \"triangles\": " << r.triangles
+                << ", \"allocations\": " << r.allocations
+                << ", \"memory\": {\"positions\": " << r.memory.positions << ", \"normals\": " << r.memory.normals
+                << ", \"tex_coords\": " << r.memory.texCoords << ", \"face_indices\": " << r.memory.faceIndices
+                << ", \"face_records\": " << r.memory.faceRecords << ", \"materials\": " << r.memory.materials
+                << ", \"mesh_tables\": " << r.memory.meshTables << ", \"strings\": " << r.memory.strings
+                << ", \"texture_cpu\": " << r.memory.textureCpu << ", \"slack\": " << r.memory.slack
+                << ", \"cpu_total\": " << r.memory.getCpuBytes() << "}"
+                << ", \"repetitions\": " << r.repetitions
+                << ", \"median_ms\": " << r.medianMs << ", \"p95_ms\": " << r.p95Ms << ", \"min_ms\": " << r.minMs
+                << ", \"mb_per_s\": " << r.megabytesPerSecond
+                << ", \"triangles_per_s\": " << r.trianglesPerSecond << "}"
+                << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        out << "  ]\n}\n";
+        return true;
+    }
+}
+
+int main(int argc, char** argv) {
+    int repetitions = 10;
+    int warmup = 2;
+    std::string jsonFile;
+    std::vector<std::string> directories;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--reps" && i + 1 < argc) {
+            repetitions = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "--warmup" && i + 1 < argc) {
+            warmup = std::max(0, std::atoi(argv[++i]));
+        }
+        else if (arg == "--json" && i + 1 < argc) {
+            jsonFile = argv[++i];
+        }
+        else if (arg == "--trace" && i + 1 < argc) {
+            traceRecorder.start(argv[++i]);
+        }
+        else {
+            directories.push_back(arg);
+        }
+    }
+    if (directories.empty()) {
+        directories.push_back("Models");
+        directories.push_back("Models/Anim");
+    }
+
+    std::vector<std::string> files;
+    for (const auto& directory : directories) {
+        std::vector<std::string> found = listObjFiles(directory);
+        files.insert(files.end(), found.begin(), found.end());
+    }
+    if (files.empty()) {
+        std::cerr << "Error: No .obj files found" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Loading " << files.size() << " files, " << warmup << " warmup + "
+              << repetitions << " timed runs each" << std::endl << std::endl;
+    std::cout << std::left << std::setw(36) << "file" << std::setw(10) << "mode" << std::right
+              << std::setw(10) << "MB" << std::setw(10) << "tris"
+              << std::setw(11) << "median ms" << std::setw(10) << "p95 ms"
+              << std::setw(9) << "MB/s" << std::setw(12) << "Mtris/s" << std::endl;
+    std::cout << std::fixed;
+
+    std::vector<LoadResult> results;
+    double totalMedianMs[2] = { 0.0, 0.0 };
+    long long totalBytes = 0;
+    long long totalAllocations = 0;     // One load of every file (deferred mode)
+    MemoryUsage totalMemory;
+    bool failed = false;
+
+    for (const auto& file : files) {
+        long long bytes = fileSize(file);
+        totalBytes += bytes;
+
+        for (int m = 0; m < 2; m++) {
+            const LoadMode& mode = kModes[m];
+            int triangles = 0;
+            long long allocations = 0;
+            MemoryUsage memory;
+            std::vector<double> times;
+            for (int run = 0; run < warmup + repetitions; run++) {
+                double ms = timeLoad(file, mode.textures, triangles, allocations, memory);
+                if (ms < 0.0) {
+                    break;
+                }
+                if (run >= warmup) {
+                    times.push_back(ms);
+                }
+            }
+            if ((int)times.size() != repetitions) {
+                std::cerr << "Error: Failed to load " << file << std::endl;
+                failed = true;
+                break;
+            }
+            std::sort(times.begin(), times.end());
+
+            LoadResult r;
+            r.file = file;
+            r.mode = mode.name;
+            r.bytes = bytes;
+            r.triangles = triangles;
+            r.allocations = allocations;
+            r.memory = memory;
+            r.repetitions = repetitions;
+            r.medianMs = percentile(times, 0.5);
+            r.p95Ms = percentile(times, 0.95);
+            r.minMs = times.front();
+            double seconds = std::max(r.medianMs, 1e-6) / 1000.0;
+            r.megabytesPerSecond = bytes / (1024.0 * 1024.0) / seconds;
+            r.trianglesPerSecond = triangles / seconds;
+            results.push_back(r);
+            totalMedianMs[m] += r.medianMs;
+            if (m == 0) {
+                totalAllocations += allocations;
+                totalMemory += memory;
+            }
+
+            std::string shown = file.size() > 35 ? "..." + file.substr(file.size() - 32) : file;
+            std::cout << std::left << std::setw(36) << shown << std::setw(10) << mode.name << std::right
+                      << std::setprecision(2) << std::setw(10) << bytes / (1024.0 * 1024.0)
+                      << std::setw(10) << triangles
+                      << std::setw(11) << r.medianMs << std::setw(10) << r.p95Ms
+                      << std::setprecision(1) << std::setw(9) << r.megabytesPerSecond
+                      << std::setprecision(2) << std::setw(12) << r.trianglesPerSecond / 1e6 << std::endl;
+        }
+    }
+
+    std::cout << std::endl;
+    for (int m = 0; m < 2; m++) {
+        std::cout << "Total (" << kModes[m].name << "): " << std::setprecision(1) << totalMedianMs[m]
+                  << " ms for " << std::setprecision(2) << totalBytes / (1024.0 * 1024.0) << " MB ("
+                  << std::setprecision(1) << totalBytes / (1024.0 * 1024.0) / std::max(totalMedianMs[m] / 1000.0, 1e-6)
+                  << " MB/s)" << std::endl;
+    }
+    std::cout << "Allocations per corpus load: " << totalAllocations
+              << " | peak RSS: " << BenchMemory::peakResidentKb() / 1024 << " MB" << std::endl;
+    std::cout << "Memory of all models loaded at once:" << std::endl;
+    totalMemory.print(std::cout);
+
+    traceRecorder.stop();
+    if (!jsonFile.empty()) {
+        if (!writeJson(jsonFile, results, warmup, totalMedianMs, totalAllocations, totalMemory)) {
+            std::cerr << "Error: Cannot write " << jsonFile << std::endl;
+            return 1;
+        }
+        std::cout << "Results written to " << jsonFile << std::endl;
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,141 @@
+// Headless benchmark for OcclusionCuller: orbits the camera around a model
+// (same view transform as the viewer's display()) and reports occlusion rate
+// and CPU cost per frame for several thread counts. No GL context is needed.
+//
+// Usage: OcclusionBench [model.obj] [frames] [maxThreads]
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <cmath>
+#include <thread>
+#include <vector>
+#include "ObjLoader.h"
+#include "Frustum.h"
+#include "OcclusionCuller.h"
+
+namespace {
+    const float kPi = 3.14159265f;
+
+    // Column-major 4x4 helpers mirroring the fixed-function matrix calls
+    void identity(float* m) {
+        for (int i = 0; i < 16; i++) m[i] = (i % 5 == 0) ? 1.0f : 0.0f;
+    }
+
+    void multiply(float* m, const float* r) {
+        float out[16];
+        for (int col = 0; col < 4; col++) {
+            for (int row = 0; row < 4; row++) {
+                out[col * 4 + row] = m[0 * 4 + row] * r[col * 4 + 0] + m[1 * 4 + row] * r[col * 4 + 1] +
+                                     m[2 * 4 + row] * r[col * 4 + 2] + m[3 * 4 + row] * r[col * 4 + 3];
+            }
+        }
+        for (int i = 0; i < 16; i++) m[i] = out[i];
+    }
+
+    void translate(float* m, float x, float y, float z) {
+        float t[16];
+        identity(t);
+        t[12] = x; t[13] = y; t[14] = z;
+        multiply(m, t);
+    }
+
+    void scale(float* m, float s) {
+        float t[16];
+        identity(t);
+        t[0] = t[5] = t[10] = s;
+        multiply(m, t);
+    }
+
+    void rotate(float* m, float degrees, float x, float y, float z) {
+        float c = std::cos(degrees * kPi / 180.0f), s = std::sin(degrees * kPi / 180.0f);
+        float t[16];
+        identity(t);
+        t[0] = x * x * (1 - c) + c;     t[4] = x * y * (1 - c) - z * s; t[8] = x * z * (1 - c) + y * s;
+        t[1] = y * x * (1 - c) + z * s; t[5] = y * y * (1 - c) + c;     t[9] = y * z * (1 - c) - x * s;
+        t[2] = x * z * (1 - c) - y * s; t[6] = y * z * (1 - c) + x * s; t[10] = z * z * (1 - c) + c;
+        multiply(m, t);
+    }
+
+    void perspective(float* m, float fovY, float aspect, float zNear, float zFar) {
+        float f = 1.0f / std::tan(fovY * kPi / 360.0f);
+        for (int i = 0; i < 16; i++) m[i] = 0.0f;
+        m[0] = f / aspect;
+        m[5] = f;
+        m[10] = (zFar + zNear) / (zNear - zFar);
+        m[11] = -1.0f;
+        m[14] = 2.0f * zFar * zNear / (zNear - zFar);
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string filename = argc > 1 ? argv[1] : "Models/All.obj";
+    int frames = argc > 2 ? std::atoi(argv[2]) : 120;
+    unsigned int hw = std::thread::hardware_concurrency();
+    int maxThreads = argc > 3 ? std::atoi(argv[3]) : (int)std::max(1u, hw);
+
+    ObjLoader model;
+    if (!model.loadObj(filename)) {
+        return 1;
+    }
+
+    std::vector<int> threadCounts;
+    for (int t = 1; t <= maxThreads && t <= 8; t *= 2) {
+        threadCounts.push_back(t);
+    }
+
+    const float zooms[] = { -5.0f, -2.0f, -0.5f };
+    float projection[16];
+    perspective(projection, 45.0f, 800.0f / 600.0f, 0.1f, 100.0f);
+
+    std::cout << "\n=== Occlusion benchmark: " << filename << " (" << model.getObjectCount()
+              << " objects, " << frames << " frames per run) ===" << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+
+    for (float zoom : zooms) {
+        for (int threads : threadCounts) {
+            OcclusionCuller culler;
+            culler.setThreadCount(threads);
+
+            long long frustumTriangles = 0, occludedTriangles = 0;
+            long long frustumObjects = 0, occludedObjects = 0;
+            double rasterMs = 0.0, testMs = 0.0;
+
+            for (int i = 0; i < frames; i++) {
+                float modelview[16];
+                identity(modelview);
+                translate(modelview, 0.0f, 0.0f, zoom);
+                rotate(modelview, 20.0f, 1.0f, 0.0f, 0.0f);
+                rotate(modelview, 360.0f * i / frames, 0.0f, 1.0f, 0.0f);
+                scale(modelview, model.getScale());
+                translate(modelview, -model.getCenter().x, -model.getCenter().y, -model.getCenter().z);
+
+                Frustum frustum;
+                frustum.extract(modelview, projection);
+                culler.beginFrame(modelview, projection);
+                culler.renderOccluders(model);
+
+                for (const ObjectGroup& object : model.getObjects()) {
+                    if (!frustum.isBoxVisible(object.minBounds, object.maxBounds)) continue;
+                    frustumObjects++;
+                    frustumTriangles += object.triangleCount;
+                    if (!culler.isBoxVisible(object.minBounds, object.maxBounds)) {
+                        occludedObjects++;
+                        occludedTriangles += object.triangleCount;
+                    }
+                }
+
+                rasterMs += culler.getStats().rasterMs;
+                testMs += culler.getStats().testMs;
+            }
+
+            std::cout << "zoom " << std::setw(6) << zoom << " | threads " << threads
+                      << " | occluded objects " << std::setw(6) << (frustumObjects ? 100.0 * occludedObjects / frustumObjects : 0.0) << "%"
+                      << " | occluded triangles " << std::setw(6) << (frustumTriangles ? 100.0 * occludedTriangles / frustumTriangles : 0.0) << "%"
+                      << " | raster " << rasterMs / frames << " ms"
+                      << " | test " << testMs / frames << " ms/frame" << std::endl;
+        }
+    }
+
+    return 0;
+}
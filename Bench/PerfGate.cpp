@@ -0,0 +1,355 @@
+// Performance regression gate: runs LoadBench and RenderBench (static model
+// and animation) several times, takes the median of every tracked metric
+// (load time, frame time, heap allocations, model memory, peak RSS) and
+// compares it with a stored baseline. A metric fails when it is worse than the baseline by more
+// than its tolerance, which is the larger of a fixed per-metric floor and
+// twice the run-to-run spread seen in the baseline or the current runs, so
+// noisy metrics get proportionally more room. Exits with 1 on a regression.
+// Linux only, like RenderBench; run from the repository root after bench.sh.
+//
+// Usage: PerfGate [--update] [--runs N] [--baseline file] [--bin dir]
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+#include <cctype>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+    const int kBaselineVersion = 1;
+
+    struct BenchCommand {
+        const char* name;
+        const char* program;
+        const char* arguments;
+    };
+
+    const BenchCommand kCommands[] = {
+        { "load", "LoadBench", "--reps 2 --warmup 1" },
+        { "render", "RenderBench", "Models/All.obj --frames 300" },
+        { "render_anim", "RenderBench", "-a Models/Anim/AnimatedObject 1 50 --frames 300" }
+    };
+
+    // Lower is better for every metric. A regression has to exceed both the
+    // relative tolerance and the absolute slack (which covers values near zero).
+    struct MetricSpec {
+        const char* name;
+        const char* bench;
+        const char* key;         // Path in the benchmark's JSON output
+        double minTolerance;     // Relative floor, e.g. 0.10 = 10%
+        double slack;            // Absolute, in the metric's unit
+    };
+
+    const MetricSpec kMetrics[] = {
+        { "load.total_ms", "load", "totals.deferred_ms", 0.10, 5.0 },
+        { "load.allocations", "load", "totals.allocations", 0.01, 0.0 },
+        { "load.peak_rss_kb", "load", "totals.peak_rss_kb", 0.05, 1024.0 },
+        { "load.model_cpu_bytes", "load", "totals.model_cpu_bytes", 0.01, 0.0 },
+        { "render.frame_median_ms", "render", "frame_ms.median", 0.10, 0.2 },
+        { "render.frame_p95_ms", "render", "frame_ms.p95", 0.25, 0.5 },
+        { "render.allocations_per_frame", "render", "allocations_per_frame", 0.01, 0.5 },
+        { "render.peak_rss_kb", "render", "peak_rss_kb", 0.05, 1024.0 },
+        { "render_anim.frame_median_ms", "render_anim", "frame_ms.median", 0.10, 0.2 },
+        { "render_anim.frame_p95_ms", "render_anim", "frame_ms.p95", 0.25, 0.5 },
+        { "render_anim.allocations_per_frame", "render_anim", "allocations_per_frame", 0.01, 0.5 },
+        { "render_anim.peak_rss_kb", "render_anim", "peak_rss_kb", 0.05, 1024.0 }
+    };
+
+    struct MetricValue {
+        double value;   // Median over the runs
+        double noise;   // (max - min) / median over the runs
+        MetricValue() : value(0.0), noise(0.0) {}
+    };
+
+    // Flattened JSON document: "a.b.0.c" -> value
+    struct JsonValues {
+        std::map<std::string, double> numbers;
+        std::map<std::string, std::string> strings;
+    };
+
+    // Just enough JSON for the files the benchmarks and this gate write
+    class JsonReader {
+    private:
+        const std::string& text;
+        size_t pos;
+        JsonValues& values;
+
+        void skipSpace() {
+            while (pos < text.size() && std::isspace((unsigned char)text[pos])) pos++;
+        }
+
+        bool readString(std::string& out) {
+            if (text[pos] != '"') return false;
+            pos++;
+            out.clear();
+            while (pos < text.size() && text[pos] != '"') {
+                if (text[pos] == '\\' && pos + 1 < text.size()) pos++;
+                out += text[pos++];
+            }
+            pos++;
+            return pos <= text.size();
+        }
+
+        bool readValue(const std::string& path) {
+            skipSpace();
+            if (pos >= text.size()) return false;
+            char c = text[pos];
+            if (c == '{' || c == '[') {
+                char close = (c == '{') ? '}' : ']';
+                pos++;
+                int index = 0;
+                skipSpace();
+                if (pos < text.size() && text[pos] == close) {
+                    pos++;
+                    return true;
+                }
+                while (pos < text.size()) {
+                    std::string key;
+                    if (c == '{') {
+                        skipSpace();
+                        if (!readString(key)) return false;
+                        skipSpace();
+                        if (text[pos++] != ':') return false;
+                    }
+                    else {
+                        key = std::to_string(index++);
+                    }
+                    if (!readValue(path.empty() ? key : path + "." + key)) return false;
+                    skipSpace();
+                    if (text[pos] == ',') {
+                        pos++;
+                    }
+                    else if (text[pos] == close) {
+                        pos++;
+                        return true;
+                    }
+                    else {
+                        return false;
+                    }
+                }
+                return false;
+            }
+            if (c == '"') {
+                std::string value;
+                if (!readString(value)) return false;
+                values.strings[path] = value;
+                return true;
+            }
+            size_t end = pos;
+            while (end < text.size() && std::string(",}] \t\r\n").find(text[end]) == std::string::npos) end++;
+            std::string token = text.substr(pos, end - pos);
+            pos = end;
+            if (token == "true" || token == "false" || token == "null") {
+                values.numbers[path] = (token == "true") ? 1.0 : 0.0;
+                return true;
+            }
+            char* parsedEnd = nullptr;
+            double number = std::strtod(token.c_str(), &parsedEnd);
+            if (token.empty() || *parsedEnd != '\0') return false;
+            values.numbers[path] = number;
+            return true;
+        }
+
+    public:
+        JsonReader(const std::string& text, JsonValues& values) : text(text), pos(0), values(values) {}
+        bool read() { return readValue(""); }
+    };
+
+    bool readJsonFile(const std::string& filename, JsonValues& values) {
+        std::ifstream file(filename);
+        if (!file.is_open()) {
+            return false;
+        }
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        std::string text = buffer.str();
+        JsonReader reader(text, values);
+        return reader.read();
+    }
+
+    MetricValue summarize(std::vector<double> samples) {
+        MetricValue result;
+        std::sort(samples.begin(), samples.end());
+        result.value = samples[samples.size() / 2];
+        if (samples.size() % 2 == 0) {
+            result.value = 0.5 * (samples[samples.size() / 2 - 1] + samples[samples.size() / 2]);
+        }
+        if (result.value > 0.0) {
+            result.noise = (samples.back() - samples.front()) / result.value;
+        }
+        return result;
+    }
+
+    // Runs every benchmark 'runs' times; false if one of them failed
+    bool collectMetrics(const std::string& binDirectory, int runs, std::map<std::string, MetricValue>& metrics,
+                        std::string& renderer) {
+        std::map<std::string, std::vector<double> > samples;
+        for (const BenchCommand& command : kCommands) {
+            for (int run = 0; run < runs; run++) {
+                std::string jsonFile = binDirectory + "/perfgate_" + command.name + ".json";
+                std::string logFile = binDirectory + "/perfgate_" + command.name + ".log";
+                std::string commandLine = binDirectory + "/" + command.program + " " + command.arguments +
+                                          " --json " + jsonFile + " > " + logFile + " 2>&1";
+                std::cout << "  " << command.name << " run " << (run + 1) << "/" << runs << "..." << std::endl;
+                std::remove(jsonFile.c_str());
+                int status = std::system(commandLine.c_str());
+
+                JsonValues values;
+                if (status != 0 || !readJsonFile(jsonFile, values)) {
+                    std::cerr << "Error: " << command.program << " failed (exit " << status
+                              << "), see " << logFile << std::endl;
+                    return false;
+                }
+                if (values.strings.count("renderer")) {
+                    renderer = values.strings["renderer"];
+                }
+                for (const MetricSpec& spec : kMetrics) {
+                    if (std::string(spec.bench) != command.name) continue;
+                    if (!values.numbers.count(spec.key)) {
+                        std::cerr << "Error: " << jsonFile << " has no " << spec.key << std::endl;
+                        return false;
+                    }
+                    samples[spec.name].push_back(values.numbers[spec.key]);
+                }
+            }
+        }
+        for (const auto& entry : samples) {
+            metrics[entry.first] = summarize(entry.second);
+        }
+        return true;
+    }
+
+    bool writeBaseline(const std::string& filename, const std::map<std::string, MetricValue>& metrics,
+                       const std::string& renderer, int runs) {
+        std::ofstream out(filename);
+        if (!out.is_open()) {
+            return false;
+        }
+        out << std::fixed << std::setprecision(4);
+        out << "{\n  \"version\": " << kBaselineVersion << ",\n"
+            << "  \"renderer\": \"" << renderer << "\",\n"
+            << "  \"runs\": " << runs << ",\n  \"metrics\": {\n";
+        size_t written = 0;
+        for (const MetricSpec& spec : kMetrics) {
+            const MetricValue& metric = metrics.find(spec.name)->second;
+            out << "    \"" << spec.name << "\": {\"value\": " << metric.value << ", \"noise\": " << metric.noise << "}"
+                << (++written < sizeof(kMetrics) / sizeof(kMetrics[0]) ? "," : "") << "\n";
+        }
+        out << "  }\n}\n";
+        return true;
+    }
+}
+
+int main(int argc, char** argv) {
+    bool update = false;
+    int runs = 3;
+    std::string baselineFile = "Bench/perf_baseline.json";
+    std::string binDirectory = "bench_build";
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--update") {
+            update = true;
+        }
+        else if (arg == "--runs" && i + 1 < argc) {
+            runs = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "--baseline" && i + 1 < argc) {
+            baselineFile = argv[++i];
+        }
+        else if (arg == "--bin" && i + 1 < argc) {
+            binDirectory = argv[++i];
+        }
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--update] [--runs N] [--baseline file] [--bin dir]" << std::endl;
+            return 2;
+        }
+    }
+
+    JsonValues baseline;
+    bool haveBaseline = readJsonFile(baselineFile, baseline);
+    if (!update) {
+        if (!haveBaseline) {
+            std::cerr << "Error: No baseline at " << baselineFile << "; create one with --update" << std::endl;
+            return 2;
+        }
+        int version = (int)baseline.numbers["version"];
+        if (version != kBaselineVersion) {
+            std::cerr << "Error: " << baselineFile << " is format version " << version << ", expected "
+                      << kBaselineVersion << "; recreate it with --update" << std::endl;
+            return 2;
+        }
+    }
+
+    std::cout << "Running benchmarks (" << runs << " runs each)" << std::endl;
+    std::map<std::string, MetricValue> metrics;
+    std::string renderer;
+    if (!collectMetrics(binDirectory, runs, metrics, renderer)) {
+        return 2;
+    }
+
+    if (update) {
+        if (!writeBaseline(baselineFile, metrics, renderer, runs)) {
+            std::cerr << "Error: Cannot write " << baselineFile << std::endl;
+            return 2;
+        }
+        std::cout << "Baseline written to " << baselineFile << std::endl;
+        return 0;
+    }
+
+    if (baseline.strings["renderer"] != renderer) {
+        std::cout << "Warning: Baseline was recorded on \"" << baseline.strings["renderer"]
+                  << "\", this run uses \"" << renderer << "\"" << std::endl;
+    }
+
+    std::cout << std::endl << std::left << std::setw(36) << "metric" << std::right
+              << std::setw(14) << "baseline" << std::setw(14) << "current"
+              << std::setw(10) << "change" << std::setw(10) << "allowed" << "  status" << std::endl;
+    std::cout << std::fixed;
+
+    int regressions = 0;
+    for (const MetricSpec& spec : kMetrics) {
+        std::string prefix = std::string("metrics.") + spec.name;
+        if (!baseline.numbers.count(prefix + ".value")) {
+            std::cout << std::left << std::setw(36) << spec.name << std::right
+                      << std::setw(14) << "-" << "  not in baseline" << std::endl;
+            continue;
+        }
+        double baseValue = baseline.numbers[prefix + ".value"];
+        double baseNoise = baseline.numbers[prefix + ".noise"];
+        const MetricValue& current = metrics[spec.name];
+
+        double tolerance = std::max(spec.minTolerance, 2.0 * std::max(baseNoise, current.noise));
+        double limit = std::max(baseValue * (1.0 + tolerance), baseValue + spec.slack);
+        double change = baseValue > 0.0 ? (current.value - baseValue) / baseValue : 0.0;
+
+        const char* status = "ok";
+        if (current.value > limit) {
+            status = "REGRESSED";
+            regressions++;
+        }
+        else if (current.value < baseValue * (1.0 - tolerance) && baseValue - current.value > spec.slack) {
+            status = "improved";
+        }
+
+        std::cout << std::left << std::setw(36) << spec.name << std::right << std::setprecision(2)
+                  << std::setw(14) << baseValue << std::setw(14) << current.value
+                  << std::setprecision(1) << std::setw(9) << change * 100.0 << "%"
+                  << std::setw(9) << tolerance * 100.0 << "%" << "  " << status << std::endl;
+    }
+
+    std::cout << std::endl;
+    if (regressions > 0) {
+        std::cout << "FAILED: " << regressions << " metric(s) regressed beyond tolerance" << std::endl;
+        return 1;
+    }
+    std::cout << "PASSED (rerun with --update after an intended change to accept the new numbers)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,519 @@
+// Headless render benchmark: creates an EGL surfaceless context (Mesa's
+// llvmpipe/softpipe when there is no GPU), renders a static model or an
+// animation sequence into an offscreen framebuffer along a fixed camera orbit
+// and reports the frame time distribution. Camera, projection and lights
+// mirror the viewer's default state (reshape(), initLighting(), renderScene()
+// in main.cpp); every frame ends with glFinish so the time covers the whole
+// rasterization. Animations advance exactly one frame per rendered frame
+// and warm up for at least one full cycle. Heap allocations per timed frame,
+// the model's memory (getMemoryUsage()) and the peak RSS are reported as well.
+// A .anim container (Tools/AnimPack) is played like an animation. With
+// --stream N it is streamed through a window of N frames instead and plays at
+// its FPS in wall-clock time; frames the prefetch thread did not deliver in
+// time are reported as dropped. OBJ sequences are not streamed (a frame
+// parses far slower than it plays). --decimate T drops frames
+// that interpolation reproduces within T (AnimationLoader::decimateFrames());
+// --interpolate N draws the blend of the kept frames and advances 1/N of a
+// frame per rendered frame.
+// Linux only (EGL_MESA_platform_surfaceless); build with bench.sh.
+//
+// Usage: RenderBench [model.obj | file.anim | -a base start end] [--frames N] [--warmup N]
+//                    [--size WxH] [--backend immediate|arrays|lists|vbo]
+//                    [--stream N] [--decimate T] [--interpolate N] [--json out.json] [--ppm last.ppm] [--trace trace.json]
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <cstdlib>
+#include <cstdio>
+#include <chrono>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "ObjLoader.h"
+#include "AnimationLoader.h"
+#include "GLExtensions.h"
+#include "GLStateCache.h"
+#include "Trace.h"
+#include "BenchMemory.h"
+
+namespace {
+    struct RenderOptions {
+        std::string model;
+        bool animation;
+        int startFrame;
+        int endFrame;
+        int frames;
+        int warmup;
+        int width;
+        int height;
+        RenderBackendType backend;
+        int streamWindow;       // 0: load every frame
+        float decimateTolerance;
+        int interpolateSteps;   // Rendered frames per animation frame, 0: no interpolation
+        std::string jsonFile;
+        std::string ppmFile;
+        std::string traceFile;
+        RenderOptions() : model("Models/All.obj"), animation(false), startFrame(1), endFrame(50),
+                          frames(240), warmup(10), width(800), height(600), backend(RENDER_BUFFERS),
+                          streamWindow(0), decimateTolerance(0.0f), interpolateSteps(0) {}
+    };
+
+    struct FrameTimes {
+        double minMs;
+        double medianMs;
+        double p95Ms;
+        double p99Ms;
+        double maxMs;
+        double meanMs;
+    };
+
+    GLProc getEglProc(const char* name) {
+        return (GLProc)eglGetProcAddress(name);
+    }
+
+    bool createContext(EGLDisplay& display, EGLContext& context) {
+        PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+            (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        display = getPlatformDisplay
+            ? getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr)
+            : eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        EGLint major, minor;
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+            std::cerr << "Error: Cannot initialize EGL" << std::endl;
+            return false;
+        }
+        eglBindAPI(EGL_OPENGL_API);
+
+        const EGLint configAttributes[] = {
+            EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE
+        };
+        EGLConfig config;
+        EGLint configCount = 0;
+        if (!eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount == 0) {
+            std::cerr << "Error: No EGL config with desktop OpenGL" << std::endl;
+            return false;
+        }
+        context = eglCreateContext(display, config, EGL_NO_CONTEXT, nullptr);
+        if (context == EGL_NO_CONTEXT ||
+            !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+            std::cerr << "Error: Cannot create a surfaceless OpenGL context" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Color + depth renderbuffers; there is no default framebuffer without a surface
+    bool createTarget(int width, int height) {
+        if (!hasFramebufferObjects()) {
+            std::cerr << "Error: Framebuffer objects not supported" << std::endl;
+            return false;
+        }
+        GLuint framebuffer, renderbuffers[2];
+        extGenRenderbuffers(2, renderbuffers);
+        extBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+        extRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+        extBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+        extRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+        extGenFramebuffers(1, &framebuffer);
+        extBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        extFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+        extFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+        if (extCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cerr << "Error: Offscreen framebuffer incomplete" << std::endl;
+            return false;
+        }
+        glViewport(0, 0, width, height);
+        return true;
+    }
+
+    void setLight(GLenum light, const GLfloat* diffuse, const GLfloat* specular, const GLfloat* position,
+                  float constant, float linear, float quadratic) {
+        glEnable(light);
+        if (diffuse) glLightfv(light, GL_DIFFUSE, diffuse);
+        if (specular) glLightfv(light, GL_SPECULAR, specular);
+        if (position) glLightfv(light, GL_POSITION, position);
+        glLightf(light, GL_CONSTANT_ATTENUATION, constant);
+        glLightf(light, GL_LINEAR_ATTENUATION, linear);
+        glLightf(light, GL_QUADRATIC_ATTENUATION, quadratic);
+    }
+
+    // Same lights and defaults as the viewer's initLighting()
+    void initLighting() {
+        glEnable(GL_LIGHTING);
+        glDisable(GL_COLOR_MATERIAL);
+        glLightModeli(GL_LIGHT_MODEL_TWO_SIDE, GL_TRUE);
+        glLightModeli(GL_LIGHT_MODEL_LOCAL_VIEWER, GL_TRUE);
+
+        const GLfloat keyDiffuse[] = { 0.6f, 0.6f, 0.7f, 1.0f }, keySpecular[] = { 0.4f, 0.4f, 0.5f, 1.0f };
+        const GLfloat keyPosition[] = { 3.0f, 4.0f, 5.0f, 1.0f };
+        setLight(GL_LIGHT0, keyDiffuse, keySpecular, keyPosition, 1.0f, 0.05f, 0.01f);
+        const GLfloat fillDiffuse[] = { 0.15f, 0.15f, 0.18f, 1.0f }, noSpecular[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+        const GLfloat fillPosition[] = { -3.0f, 2.0f, 4.0f, 1.0f };
+        setLight(GL_LIGHT1, fillDiffuse, noSpecular, fillPosition, 1.0f, 0.1f, 0.05f);
+        const GLfloat rimDiffuse[] = { 0.25f, 0.20f, 0.15f, 1.0f }, rimSpecular[] = { 0.2f, 0.15f, 0.1f, 1.0f };
+        const GLfloat rimPosition[] = { 0.0f, 2.0f, -8.0f, 1.0f };
+        setLight(GL_LIGHT2, rimDiffuse, rimSpecular, rimPosition, 1.0f, 0.07f, 0.03f);
+        const GLfloat pointDiffuse[] = { 0.5f, 0.4f, 0.3f, 1.0f };
+        setLight(GL_LIGHT3, pointDiffuse, noSpecular, nullptr, 0.8f, 0.5f, 0.8f);
+        setLight(GL_LIGHT4, nullptr, nullptr, nullptr, 0.5f, 0.1f, 0.08f);
+        const GLfloat point2Diffuse[] = { 0.3f, 0.5f, 1.0f, 1.0f };
+        setLight(GL_LIGHT5, point2Diffuse, noSpecular, nullptr, 0.8f, 0.5f, 0.8f);
+
+        const GLfloat matSpecular[] = { 0.7f, 0.7f, 0.7f, 1.0f };
+        glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, matSpecular);
+        glMaterialf(GL_FRONT_AND_BACK, GL_SHININESS, 80.0f);
+
+        glShadeModel(GL_SMOOTH);
+        glDisable(GL_CULL_FACE);
+        glEnable(GL_NORMALIZE);
+        glEnable(GL_DEPTH_TEST);
+        glState.invalidate();
+    }
+
+    // renderScene() with the default zoom and light positions; the camera orbits once per 'orbitFrames'
+    void renderFrame(ObjLoader* model, AnimationLoader* animation, int frame, int orbitFrames) {
+        const GLfloat globalAmbient[] = { 0.05f, 0.05f, 0.05f, 1.0f };
+        const GLfloat light3Position[] = { -0.5f, -0.2f, -0.2f, 1.0f };
+        const GLfloat light5Position[] = { 0.1f, 0.5f, -0.8f, 1.0f };
+        const GLfloat spotPosition[] = { 0.0f, 8.0f, 0.0f, 1.0f };
+        const GLfloat spotDirection[] = { 0.0f, -1.0f, 0.0f };
+        const GLfloat spotDiffuse[] = { 2.8f, 2.8f, 2.52f, 1.0f };
+        const GLfloat spotSpecular[] = { 1.4f, 1.4f, 1.26f, 1.0f };
+
+        glState.resetStats();
+        glClearColor(0.1f, 0.1f, 0.15f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glState.lightModelAmbient(globalAmbient);
+
+        glMatrixMode(GL_MODELVIEW);
+        glLoadIdentity();
+        glTranslatef(0.0f, 0.0f, -5.0f);
+        glRotatef(20.0f, 1.0f, 0.0f, 0.0f);
+        glRotatef(360.0f * (frame % orbitFrames) / orbitFrames, 0.0f, 1.0f, 0.0f);
+
+        glState.lightfv(GL_LIGHT3, GL_POSITION, light3Position);
+        glState.lightfv(GL_LIGHT5, GL_POSITION, light5Position);
+        glState.lightfv(GL_LIGHT4, GL_POSITION, spotPosition);
+        glState.lightfv(GL_LIGHT4, GL_SPOT_DIRECTION, spotDirection);
+        glState.lightf(GL_LIGHT4, GL_SPOT_CUTOFF, 5.0f);
+        glState.lightf(GL_LIGHT4, GL_SPOT_EXPONENT, 30.0f);
+        glState.lightfv(GL_LIGHT4, GL_DIFFUSE, spotDiffuse);
+        glState.lightfv(GL_LIGHT4, GL_SPECULAR, spotSpecular);
+        glState.enable(GL_LIGHTING);
+
+        if (animation) {
+            animation->drawWithMaterials();
+        }
+        else if (model->hasMaterials()) {
+            model->drawWithMaterials();
+        }
+        else {
+            glColor3f(0.7f, 0.7f, 0.9f);
+            model->draw();
+        }
+    }
+
+    FrameTimes summarize(std::vector<double> times) {
+        std::sort(times.begin(), times.end());
+        FrameTimes result;
+        double sum = 0.0;
+        for (double t : times) sum += t;
+        // Nearest-rank percentiles
+        auto rank = [&times](double p) {
+            size_t r = (size_t)(p * times.size() + 0.999999);
+            return times[std::min(std::max(r, (size_t)1), times.size()) - 1];
+        };
+        result.minMs = times.front();
+        result.medianMs = rank(0.5);
+        result.p95Ms = rank(0.95);
+        result.p99Ms = rank(0.99);
+        result.maxMs = times.back();
+        result.meanMs = sum / times.size();
+        return result;
+    }
+
+    bool writePpm(const std::string& filename, int width, int height) {
+        std::vector<unsigned char> pixels(width * height * 3);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, &pixels[0]);
+        std::ofstream out(filename, std::ios::binary);
+        if (!out.is_open()) {
+            return false;
+        }
+        out << "P6\n" << width << " " << height << "\n255\n";
+        for (int y = height - 1; y >= 0; y--) {
+            out.write((const char*)&pixels[y * width * 3], width * 3);
+        }
+        return true;
+    }
+
+    bool isContainerFile(const std::string& filename) {
+        return filename.size() > 5 && filename.compare(filename.size() - 5, 5, ".anim") == 0;
+    }
+
+    bool parseArguments(int argc, char** argv, RenderOptions& options) {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "-a" && i + 3 < argc) {
+                options.animation = true;
+                options.model = argv[++i];
+                options.startFrame = std::atoi(argv[++i]);
+                options.endFrame = std::atoi(argv[++i]);
+            }
+            else if (arg == "--frames" && hasValue) {
+                options.frames = std::max(1, std::atoi(argv[++i]));
+            }
+            else if (arg == "--warmup" && hasValue) {
+                options.warmup = std::max(0, std::atoi(argv[++i]));
+            }
+            else if (arg == "--size" && hasValue) {
+                if (std::sscanf(argv[++i], "%dx%d", &options.width, &options.height) != 2 ||
+                    options.width <= 0 || options.height <= 0) {
+                    std::cerr << "Error: --size expects WxH, e.g. 800x600" << std::endl;
+                    return false;
+                }
+            }
+            else if (arg == "--backend" && hasValue) {
+                if (!parseRenderBackend(argv[++i], options.backend)) {
+                    std::cerr << "Error: Unknown backend " << argv[i] << std::endl;
+                    return false;
+                }
+            }
+            else if (arg == "--stream" && hasValue) {
+                options.streamWindow = std::max(1, std::atoi(argv[++i]));
+            }
+            else if (arg == "--decimate" && hasValue) {
+                options.decimateTolerance = (float)std::atof(argv[++i]);
+            }
+            else if (arg == "--interpolate" && hasValue) {
+                options.interpolateSteps = std::max(1, std::atoi(argv[++i]));
+            }
+            else if (arg == "--json" && hasValue) {
+                options.jsonFile = argv[++i];
+            }
+            else if (arg == "--ppm" && hasValue) {
+                options.ppmFile = argv[++i];
+            }
+            else if (arg == "--trace" && hasValue) {
+                options.traceFile = argv[++i];
+            }
+            else if (arg[0] != '-') {
+                options.model = arg;
+                options.animation = isContainerFile(arg);
+            }
+            else {
+                std::cerr << "Error: Unknown option " << arg << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+int main(int argc, char** argv) {
+    RenderOptions options;
+    if (!parseArguments(argc, argv, options)) {
+        return 1;
+    }
+
+    EGLDisplay display;
+    EGLContext context;
+    if (!createContext(display, context)) {
+        return 1;
+    }
+    loadGLExtensions(getEglProc);
+    if (!createTarget(options.width, options.height)) {
+        return 1;
+    }
+    std::cout << "Renderer: " << glGetString(GL_RENDERER) << std::endl;
+
+    if (!options.traceFile.empty()) {
+        traceRecorder.start(options.traceFile);
+    }
+
+    ObjLoader* model = nullptr;
+    AnimationLoader* animation = nullptr;
+    if (options.animation) {
+        animation = new AnimationLoader();
+        animation->setVerbose(false);
+        bool loaded;
+        if (isContainerFile(options.model)) {
+            loaded = options.streamWindow > 0 ? animation->openContainerStream(options.model, options.streamWindow)
+                                              : animation->loadAnimationContainer(options.model);
+        }
+        else if (options.streamWindow > 0) {
+            std::cerr << "Error: --stream needs a .anim file (pack the sequence with AnimPack)" << std::endl;
+            return 1;
+        }
+        else {
+            loaded = animation->loadAnimationSequence(options.model, options.startFrame, options.endFrame);
+        }
+        if (!loaded) {
+            return 1;
+        }
+        if (options.decimateTolerance > 0.0f) {
+            animation->decimateFrames(options.decimateTolerance);
+        }
+        if (options.interpolateSteps > 0) {
+            animation->setInterpolation(true);
+        }
+        animation->setRenderBackend(options.backend);
+        animation->setFPS(30.0f);
+        animation->setLoop(true);
+        animation->play();
+        // Every animation frame has its own backend, so warm up a full cycle
+        // (a stream keeps only a window, so there is nothing lasting to warm up)
+        if (!animation->isStreaming()) {
+            options.warmup = std::max(options.warmup, animation->getTotalFrames() * std::max(1, options.interpolateSteps));
+        }
+    }
+    else {
+        model = new ObjLoader();
+        model->setVerbose(false);
+        if (!model->loadObj(options.model)) {
+            return 1;
+        }
+        model->setRenderBackend(options.backend);
+    }
+
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    gluPerspective(45.0, (double)options.width / options.height, 0.1, 100.0);
+    initLighting();
+
+    // Warmup frames build the backend (welding, uploads, list compilation) and are not timed
+    int totalFrames = options.warmup + options.frames;
+    std::vector<double> frameMs;
+    std::vector<double> submitMs;
+    long long trianglesDrawn = 0;
+    int drawCalls = 0;
+    long long timedAllocations = 0;
+    int droppedBefore = 0;
+    int timelineFrames = 0;     // Animation frames played during the timed frames
+    auto lastUpdate = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < totalFrames; frame++) {
+        if (animation && animation->isStreaming() && frame == options.warmup) {
+            droppedBefore = animation->getStream()->getDroppedFrames();
+        }
+        long long allocationsBefore = BenchMemory::allocations();
+        auto start = std::chrono::steady_clock::now();
+        {
+            TRACE_SCOPE("frame");
+            renderFrame(model, animation, frame, options.frames);
+            TRACE_SCOPE("finish");
+            glFinish();
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        ObjLoader* drawn = animation ? animation->getCurrentModel() : model;
+        if (frame >= options.warmup) {
+            timedAllocations += BenchMemory::allocations() - allocationsBefore;
+            frameMs.push_back(ms);
+            submitMs.push_back(drawn->getDrawStats().submitMs);
+            trianglesDrawn += drawn->getDrawStats().trianglesDrawn;
+            drawCalls = drawn->getDrawStats().drawCalls;
+        }
+        if (animation) {
+            TRACE_SCOPE("animation update");
+            int frameBefore = animation->getCurrentFrame();
+            if (animation->isStreaming()) {
+                auto now = std::chrono::steady_clock::now();
+                animation->update(std::chrono::duration<float>(now - lastUpdate).count());
+                lastUpdate = now;
+            }
+            else {
+                animation->update(1.0f / (animation->getFPS() * std::max(1, options.interpolateSteps)));
+            }
+            if (frame >= options.warmup && animation->getCurrentFrame() != frameBefore) {
+                timelineFrames++;
+            }
+        }
+    }
+    int droppedFrames = animation && animation->isStreaming()
+        ? animation->getStream()->getDroppedFrames() - droppedBefore : 0;
+
+    FrameTimes frameTimes = summarize(frameMs);
+    FrameTimes submitTimes = summarize(submitMs);
+    double totalSeconds = 0.0;
+    for (double t : frameMs) totalSeconds += t / 1000.0;
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << (options.animation ? "Animation: " : "Model: ") << options.model
+              << " | " << options.width << "x" << options.height
+              << " | backend " << getRenderBackendName(options.backend)
+              << " | " << options.frames << " frames (+" << options.warmup << " warmup)" << std::endl;
+    std::cout << "Frame ms:  min " << frameTimes.minMs << "  median " << frameTimes.medianMs
+              << "  p95 " << frameTimes.p95Ms << "  p99 " << frameTimes.p99Ms
+              << "  max " << frameTimes.maxMs << "  mean " << frameTimes.meanMs << std::endl;
+    std::cout << "Submit ms: median " << submitTimes.medianMs << "  p95 " << submitTimes.p95Ms << std::endl;
+    std::cout << "FPS: " << std::setprecision(1) << options.frames / totalSeconds
+              << " | draw calls/frame: " << drawCalls
+              << " | triangles/frame: " << trianglesDrawn / options.frames << std::endl;
+    double allocationsPerFrame = (double)timedAllocations / options.frames;
+    long long peakRssKb = BenchMemory::peakResidentKb();
+    std::cout << "Allocations/frame: " << allocationsPerFrame
+              << " | peak RSS: " << peakRssKb / 1024 << " MB" << std::endl;
+    if (animation && animation->isStreaming()) {
+        const AnimationStream* stream = animation->getStream();
+        std::cout << "Stream: window " << stream->getWindowFrames() << ", " << stream->getResidentFrames()
+                  << " frames resident, " << droppedFrames << " of " << timelineFrames
+                  << " played frames dropped, " << stream->getLoadedFrames() << " prefetched" << std::endl;
+    }
+    if (animation && !animation->isStreaming()) {
+        std::cout << "Frames: " << animation->getKeptFrameCount() << " of " << animation->getTotalFrames()
+                  << " kept, " << animation->getUniqueFrameCount() << " unique"
+                  << (animation->isInterpolating() ? ", interpolated" : "") << std::endl;
+    }
+    MemoryUsage memory = animation ? animation->getMemoryUsage() : model->getMemoryUsage();
+    std::cout << "Memory:" << std::endl;
+    memory.print(std::cout);
+
+    if (!options.ppmFile.empty() && !writePpm(options.ppmFile, options.width, options.height)) {
+        std::cerr << "Error: Cannot write " << options.ppmFile << std::endl;
+    }
+
+    if (!options.jsonFile.empty()) {
+        std::ofstream out(options.jsonFile);
+        if (!out.is_open()) {
+            std::cerr << "Error: Cannot write " << options.jsonFile << std::endl;
+            return 1;
+        }
+        out << std::fixed << std::setprecision(3);
+        out << "{\n  \"benchmark\": \"render\",\n  \"model\": \"" << options.model << "\",\n"
+            << "  \"animation\": " << (options.animation ? "true" : "false") << ",\n"
+            << "  \"width\": " << options.width << ",\n  \"height\": " << options.height << ",\n"
+            << "  \"backend\": \"" << getRenderBackendName(options.backend) << "\",\n"
+            << "  \"renderer\": \"" << glGetString(GL_RENDERER) << "\",\n"
+            << "  \"frames\": " << options.frames << ",\n  \"warmup\": " << options.warmup << ",\n"
+            << "  \"frame_ms\": {\"min\": " << frameTimes.minMs << ", \"median\": " << frameTimes.medianMs
+            << ", \"p95\": " << frameTimes.p95Ms << ", \"p99\": " << frameTimes.p99Ms
+            << ", \"max\": " << frameTimes.maxMs << ", \"mean\": " << frameTimes.meanMs << "},\n"
+            << "  \"submit_ms\": {\"median\": " << submitTimes.medianMs << ", \"p95\": " << submitTimes.p95Ms << "},\n"
+            << "  \"fps\": " << options.frames / totalSeconds << ",\n"
+            << "  \"draw_calls\": " << drawCalls << ",\n"
+            << "  \"triangles_per_frame\": " << trianglesDrawn / options.frames << ",\n"
+            << "  \"allocations_per_frame\": " << allocationsPerFrame << ",\n"
+            << "  \"peak_rss_kb\": " << peakRssKb << ",\n"
+            << "  \"stream_window\": " << options.streamWindow << ", \"played_frames\": " << timelineFrames
+            << ", \"dropped_frames\": " << droppedFrames << ",\n"
+            << "  \"kept_frames\": " << (animation ? animation->getKeptFrameCount() : 1)
+            << ", \"unique_frames\": " << (animation && !animation->isStreaming() ? animation->getUniqueFrameCount() : 1)
+            << ", \"interpolate_steps\": " << options.interpolateSteps << ",\n"
+            << "  \"memory\": {\"cpu_total\": " << memory.getCpuBytes() << ", \"gpu_total\": " << memory.getGpuBytes()
+            << ", \"slack\": " << memory.slack << ", \"backend_cpu\": " << memory.backendCpu
+            << ", \"backend_gpu\": " << memory.backendGpu << ", \"texture_gpu\": " << memory.textureGpu << "}\n}\n";
+        std::cout << "Results written to " << options.jsonFile << std::endl;
+    }
+
+    traceRecorder.stop();
+    delete model;
+    delete animation;
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(display, context);
+    eglTerminate(display);
+    return 0;
+}
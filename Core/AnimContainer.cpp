@@ -0,0 +1,223 @@
+#include "AnimContainer.h"
+#include "Trace.h"
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <map>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    const char kMagic[8] = { 'O', 'B', 'J', 'A', 'N', 'I', 'M', '\0' };
+    const uint32_t kVersion = 1;
+    const uint64_t kBlockAlignment = 16;
+
+    static_assert(sizeof(Vec3) == 3 * sizeof(float), "Frame blocks are read as packed Vec3 arrays");
+
+    uint64_t alignUp(uint64_t value) {
+        return (value + kBlockAlignment - 1) / kBlockAlignment * kBlockAlignment;
+    }
+
+    void writePadding(std::ofstream& out, uint64_t& written) {
+        static const char zeros[kBlockAlignment] = {};
+        uint64_t padding = alignUp(written) - written;
+        out.write(zeros, padding);
+        written += padding;
+    }
+
+    std::string directoryOf(const std::string& filename) {
+        size_t lastSlash = filename.find_last_of("/\\");
+        return lastSlash != std::string::npos ? filename.substr(0, lastSlash + 1) : "";
+    }
+}
+
+bool writeAnimContainer(const std::string& filename, const std::vector<const ObjLoader*>& frames,
+                        const std::vector<int>& frameNumbers) {
+    TRACE_SCOPE_DETAIL("write anim container", filename);
+    if (frames.empty() || frames.size() != frameNumbers.size()) {
+        std::cerr << "Error: No frames to pack" << std::endl;
+        return false;
+    }
+    const ObjLoader* first = frames.front();
+    for (size_t i = 1; i < frames.size(); i++) {
+        if (!frames[i]->sharesTopologyWith(*first)) {
+            std::cerr << "Error: Frame " << frameNumbers[i] << " does not share the first frame's topology" << std::endl;
+            return false;
+        }
+    }
+
+    std::vector<char> topology;
+    first->writeTopology(topology);
+
+    AnimContainerHeader header;
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.frameCount = frames.size();
+    header.vertexCount = first->getVertices().size();
+    header.normalCount = first->getNormals().size();
+    header.indexOffset = sizeof(AnimContainerHeader);
+    header.topologyOffset = header.indexOffset + frames.size() * sizeof(AnimFrameEntry);
+    header.topologySize = topology.size();
+
+    // A model listed more than once (deduplicated frames) is stored once
+    uint64_t blockBytes = (uint64_t)(header.vertexCount + header.normalCount) * sizeof(Vec3);
+    std::vector<AnimFrameEntry> index(frames.size());
+    std::vector<const ObjLoader*> blocks;
+    std::map<const ObjLoader*, uint64_t> blockOffsets;
+    uint64_t offset = alignUp(header.topologyOffset + header.topologySize);
+    for (size_t i = 0; i < frames.size(); i++) {
+        auto stored = blockOffsets.find(frames[i]);
+        if (stored == blockOffsets.end()) {
+            stored = blockOffsets.insert(std::make_pair(frames[i], offset)).first;
+            blocks.push_back(frames[i]);
+            offset = alignUp(offset + blockBytes);
+        }
+        index[i].offset = stored->second;
+        index[i].frameNumber = frameNumbers[i];
+        index[i].reserved = 0;
+    }
+
+    std::ofstream out(filename, std::ios::binary);
+    if (!out.is_open()) {
+        std::cerr << "Error: Cannot write " << filename << std::endl;
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(&index[0]), index.size() * sizeof(AnimFrameEntry));
+    out.write(topology.data(), topology.size());
+    uint64_t written = header.topologyOffset + header.topologySize;
+    for (const ObjLoader* frame : blocks) {
+        writePadding(out, written);
+        const std::vector<Vec3>& positions = frame->getVertices();
+        const std::vector<Vec3>& normals = frame->getNormals();
+        if (!positions.empty()) out.write(reinterpret_cast<const char*>(&positions[0]), positions.size() * sizeof(Vec3));
+        if (!normals.empty()) out.write(reinterpret_cast<const char*>(&normals[0]), normals.size() * sizeof(Vec3));
+        written += blockBytes;
+    }
+    writePadding(out, written);
+
+    if (!out.good()) {
+        std::cerr << "Error: Failed writing " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+AnimContainer::AnimContainer()
+    : data(nullptr), size(0), mapping(nullptr), header(nullptr), index(nullptr) {
+}
+
+AnimContainer::~AnimContainer() {
+    close();
+}
+
+bool AnimContainer::open(const std::string& filename) {
+    TRACE_SCOPE_DETAIL("open anim container", filename);
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        std::cerr << "Error: Cannot open file " << filename << std::endl;
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0) {
+        HANDLE fileMapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (fileMapping) {
+            data = static_cast<const char*>(MapViewOfFile(fileMapping, FILE_MAP_READ, 0, 0, 0));
+            if (data) {
+                size = (size_t)fileSize.QuadPart;
+                mapping = fileMapping;
+            }
+            else {
+                CloseHandle(fileMapping);
+            }
+        }
+    }
+    CloseHandle(file);  // The mapping keeps the file open
+#else
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Error: Cannot open file " << filename << std::endl;
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (view != MAP_FAILED) {
+            data = static_cast<const char*>(view);
+            size = (size_t)info.st_size;
+        }
+    }
+    ::close(fd);  // The mapping keeps the file open
+#endif
+
+    if (!data) {
+        std::cerr << "Error: Cannot map " << filename << std::endl;
+        return false;
+    }
+    if (!validate()) {
+        std::cerr << "Error: " << filename << " is not a valid .anim container" << std::endl;
+        close();
+        return false;
+    }
+    directory = directoryOf(filename);
+    return true;
+}
+
+// Every offset and size the accessors use must lie inside the mapping
+bool AnimContainer::validate() {
+    if (size < sizeof(AnimContainerHeader)) {
+        return false;
+    }
+    const AnimContainerHeader* h = reinterpret_cast<const AnimContainerHeader*>(data);
+    if (std::memcmp(h->magic, kMagic, sizeof(kMagic)) != 0 || h->version != kVersion || h->frameCount == 0) {
+        return false;
+    }
+    uint64_t indexBytes = (uint64_t)h->frameCount * sizeof(AnimFrameEntry);
+    if (h->indexOffset % sizeof(uint64_t) != 0 || h->indexOffset > size || indexBytes > size - h->indexOffset ||
+        h->topologyOffset > size || h->topologySize > size - h->topologyOffset) {
+        return false;
+    }
+
+    uint64_t blockBytes = ((uint64_t)h->vertexCount + h->normalCount) * sizeof(Vec3);
+    const AnimFrameEntry* entries = reinterpret_cast<const AnimFrameEntry*>(data + h->indexOffset);
+    for (uint32_t i = 0; i < h->frameCount; i++) {
+        const AnimFrameEntry& entry = entries[i];
+        if (entry.offset % sizeof(float) != 0 || entry.offset > size || blockBytes > size - entry.offset ||
+            (i == 0 ? entry.frameNumber < 0 : entry.frameNumber <= entries[i - 1].frameNumber)) {
+            return false;
+        }
+    }
+    header = h;
+    index = entries;
+    return true;
+}
+
+void AnimContainer::close() {
+    if (data) {
+#ifdef _WIN32
+        UnmapViewOfFile(data);
+        CloseHandle(static_cast<HANDLE>(mapping));
+#else
+        munmap(const_cast<char*>(data), size);
+#endif
+    }
+    data = nullptr;
+    size = 0;
+    mapping = nullptr;
+    header = nullptr;
+    index = nullptr;
+    directory.clear();
+}
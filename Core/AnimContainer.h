@@ -0,0 +1,84 @@
+#ifndef ANIM_CONTAINER_H
+#define ANIM_CONTAINER_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include "ObjLoader.h"
+
+// Packed vertex animation (.anim): the topology shared by all frames and the
+// positions and normals of every frame in one file, written by
+// writeAnimContainer() and read through a memory mapping by AnimContainer.
+//
+// Layout (little-endian): AnimContainerHeader, the frame index (frameCount
+// AnimFrameEntry records), the topology block (ObjLoader::writeTopology()),
+// then one block per frame: vertexCount positions followed by normalCount
+// normals as packed floats, each block starting on a 16-byte boundary.
+// Identical frames may point at the same block.
+// Texture names are resolved relative to the container's directory.
+struct AnimContainerHeader {
+    char magic[8];              // "OBJANIM" and a zero byte
+    uint32_t version;
+    uint32_t frameCount;
+    uint32_t vertexCount;
+    uint32_t normalCount;
+    uint64_t indexOffset;
+    uint64_t topologyOffset;
+    uint64_t topologySize;
+};
+
+struct AnimFrameEntry {
+    uint64_t offset;            // Start of the frame block
+    int32_t frameNumber;        // Position on the timeline; frames may be missing after decimation
+    uint32_t reserved;
+};
+
+// Packs frames that share one topology (ObjLoader::shareTopology()) with
+// their timeline numbers, ascending. False (with a message) if the frames do
+// not share a topology or the file cannot be written.
+bool writeAnimContainer(const std::string& filename, const std::vector<const ObjLoader*>& frames,
+                        const std::vector<int>& frameNumbers);
+
+// Read-only view of a .anim file. open() maps the file and checks the
+// header and every index entry, so any frame is then two pointer additions
+// away; pages are read in by the OS on first touch.
+class AnimContainer {
+private:
+    const char* data;
+    size_t size;
+    void* mapping;              // File mapping handle (Windows only)
+    const AnimContainerHeader* header;
+    const AnimFrameEntry* index;
+    std::string directory;
+
+    bool validate();
+
+    AnimContainer(const AnimContainer&);
+    AnimContainer& operator=(const AnimContainer&);
+
+public:
+    AnimContainer();
+    ~AnimContainer();
+
+    // False (with a message) if the file is missing or not a valid container
+    bool open(const std::string& filename);
+    void close();
+    bool isOpen() const { return data != nullptr; }
+
+    int getFrameCount() const { return header ? header->frameCount : 0; }
+    int getVertexCount() const { return header ? header->vertexCount : 0; }
+    int getNormalCount() const { return header ? header->normalCount : 0; }
+    int getFrameNumber(int frame) const { return index[frame].frameNumber; }
+    const Vec3* getPositions(int frame) const {
+        return reinterpret_cast<const Vec3*>(data + index[frame].offset);
+    }
+    const Vec3* getNormals(int frame) const { return getPositions(frame) + header->vertexCount; }
+    const char* getTopologyData() const { return data + header->topologyOffset; }
+    size_t getTopologySize() const { return header->topologySize; }
+    // Directory of the file, with a trailing separator (texture lookups)
+    const std::string& getDirectory() const { return directory; }
+    size_t getFileSize() const { return size; }
+};
+
+#endif
@@ -1,75 +1,319 @@
 #include "AnimationLoader.h"
+#include "AnimContainer.h"
+#include "Trace.h"
 #include <iostream>
+#include <fstream>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace {
+    // Default worker count; parsing is mostly memory bound past a few threads
+    const int kMaxDefaultLoadThreads = 8;
+    // Frames parsed ahead of the one being handed over, per worker thread
+    const int kFramesInFlightPerThread = 2;
+
+    // "<dir>/<name>0001.obj" for every frame number; 'baseFilename' may carry a frame number and extension
+    std::vector<std::string> frameFilenames(const std::string& baseFilename, int startFrame, int endFrame) {
+        // Extract directory and base name from the filename
+        size_t lastSlash = baseFilename.find_last_of("/\\");
+        std::string directory = "";
+        std::string baseName = baseFilename;
+    
+        if (lastSlash != std::string::npos) {
+            directory = baseFilename.substr(0, lastSlash + 1);
+            baseName = baseFilename.substr(lastSlash + 1);
+        }
+    
+        // Remove the frame number and extension from base name if present
+        // e.g., "Allanim0000.obj" -> "Allanim"
+        size_t lastDigit = baseName.find_last_not_of("0123456789");
+        if (lastDigit != std::string::npos) {
+            size_t dotPos = baseName.find('.', lastDigit);
+            if (dotPos != std::string::npos) {
+                baseName = baseName.substr(0, lastDigit + 1);
+            }
+        }
+    
+        std::vector<std::string> filenames;
+        for (int i = startFrame; i <= endFrame; i++) {
+            std::ostringstream oss;
+            oss << directory << baseName << std::setw(4) << std::setfill('0') << i << ".obj";
+            filenames.push_back(oss.str());
+        }
+        return filenames;
+    }
+
+    // Whether lerp(from, to, t) stays within 'tolerance' of 'actual' in every component
+    bool interpolatesWithin(const std::vector<Vec3>& from, const std::vector<Vec3>& to,
+                            const std::vector<Vec3>& actual, float t, float tolerance) {
+        if (from.size() != actual.size() || to.size() != actual.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < actual.size(); i++) {
+            Vec3 blended = lerp(from[i], to[i], t);
+            if (std::fabs(blended.x - actual[i].x) > tolerance || std::fabs(blended.y - actual[i].y) > tolerance ||
+                std::fabs(blended.z - actual[i].z) > tolerance) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
 
 AnimationLoader::AnimationLoader() 
     : currentFrame(0), totalFrames(0), fps(30.0f), 
       frameTime(1.0f/30.0f), elapsedTime(0.0f), 
-      isPlaying(false), loop(true) {
+      isPlaying(false), loop(true), verbose(true),
+      loadThreads(1), textureLoading(TEXTURES_UPLOAD), shareTopology(true),
+      direction(1), stream(nullptr), interpolate(false), blendModel(nullptr), shownModel(nullptr),
+      blendPosition(-1.0f), progressiveLoading(false), cancelLoad(false), collectedFiles(0), sharedFrames(0),
+      deduplicate(true) {
+    setLoadThreads(0);
 }
 
 AnimationLoader::~AnimationLoader() {
-    for (auto frame : frames) {
-        delete frame;
-    }
-    frames.clear();
+    clearFrames();
 }
 
-bool AnimationLoader::loadAnimationSequence(const std::string& baseFilename, int startFrame, int endFrame) {
-    // Clear existing frames
-    for (auto frame : frames) {
+// Stops a progressive load, then deletes the frames, the blend and the stream (GL thread only)
+void AnimationLoader::clearFrames() {
+    if (loaderThread.joinable()) {
+        cancelLoad = true;
+        loaderThread.join();
+        cancelLoad = false;
+    }
+    for (auto frame : arrivedFrames) {
+        delete frame;
+    }
+    arrivedFrames.clear();
+    loadingFiles.clear();
+    collectedFiles = 0;
+    for (auto frame : distinctFrames()) {
         delete frame;
     }
     frames.clear();
+    frameNumbers.clear();
+    frameHashes.clear();
+    delete blendModel;
+    blendModel = nullptr;
+    shownModel = nullptr;
+    blendPosition = -1.0f;
+    delete stream;
+    stream = nullptr;
+}
+
+// Workers only parse; textures are decoded there and uploaded by the caller,
+// on the thread that owns the GL context. Frames are handed over in order, and
+// a worker waits before running more than 'window' frames ahead of the
+// hand-over, so a slow frame cannot let the whole sequence pile up unclaimed.
+// Once cancelLoad is set no further frames are claimed or handed over.
+void AnimationLoader::parseFrames(const std::vector<std::string>& filenames, TextureLoading workerTextures,
+                                  bool quiet, const std::function<void(int, ObjLoader*)>& handOver) {
+    int frameCount = (int)filenames.size();
+    int threadCount = std::max(1, std::min(loadThreads, frameCount));
+    bool parallel = threadCount > 1;
+    int window = threadCount * kFramesInFlightPerThread;
+    std::vector<ObjLoader*> loaded(frameCount, nullptr);
+    std::vector<char> done(frameCount, 0);
+    std::mutex mutex;
+    std::condition_variable frameDone;
+    std::condition_variable windowMoved;
+    int nextToClaim = 0;
+    int nextToHandOver = 0;
     
-    std::cout << "Loading animation sequence..." << std::endl;
+    auto loadFrame = [&](int index) {
+        ObjLoader* frame = new ObjLoader();
+        // Per-file summaries from several threads would interleave
+        frame->setVerbose(!quiet && !parallel);
+        frame->setTextureLoading(workerTextures);
+        TRACE_SCOPE_DETAIL("load frame", filenames[index]);
+        bool ok = frame->loadObj(filenames[index]);
+        std::lock_guard<std::mutex> lock(mutex);
+        loaded[index] = frame;
+        done[index] = ok ? 1 : 2;
+        frameDone.notify_all();
+    };
     
-    // Extract directory and base name from the filename
-    size_t lastSlash = baseFilename.find_last_of("/\\");
-    std::string directory = "";
-    std::string baseName = baseFilename;
+    auto worker = [&]() {
+        while (true) {
+            int index;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                windowMoved.wait(lock, [&]() {
+                    return nextToClaim >= frameCount || nextToClaim < nextToHandOver + window;
+                });
+                if (nextToClaim >= frameCount) {
+                    return;
+                }
+                index = nextToClaim++;
+            }
+            loadFrame(index);
+        }
+    };
     
-    if (lastSlash != std::string::npos) {
-        directory = baseFilename.substr(0, lastSlash + 1);
-        baseName = baseFilename.substr(lastSlash + 1);
+    std::vector<std::thread> workers;
+    if (parallel) {
+        for (int t = 0; t < threadCount; t++) {
+            workers.emplace_back(worker);
+        }
     }
     
-    // Remove the frame number and extension from base name if present
-    // e.g., "Allanim0000.obj" -> "Allanim"
-    size_t lastDigit = baseName.find_last_not_of("0123456789");
-    if (lastDigit != std::string::npos) {
-        size_t dotPos = baseName.find('.', lastDigit);
-        if (dotPos != std::string::npos) {
-            baseName = baseName.substr(0, lastDigit + 1);
+    for (int index = 0; index < frameCount && !cancelLoad; index++) {
+        if (parallel) {
+            std::unique_lock<std::mutex> lock(mutex);
+            frameDone.wait(lock, [&]() { return done[index] != 0; });
+        } else {
+            loadFrame(index);
         }
+        
+        ObjLoader* frame = loaded[index];
+        loaded[index] = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            nextToHandOver = index + 1;
+        }
+        windowMoved.notify_all();
+        if (done[index] != 1) {
+            // Never drawn, so no GL objects: safe to delete on any thread
+            delete frame;
+            frame = nullptr;
+        }
+        handOver(index, frame);
+    }
+    
+    if (cancelLoad) {
+        std::lock_guard<std::mutex> lock(mutex);
+        nextToClaim = frameCount;
+    }
+    windowMoved.notify_all();
+    for (auto& thread : workers) {
+        thread.join();
+    }
+    // Claimed ahead of a cancelled hand-over
+    for (auto frame : loaded) {
+        delete frame;
+    }
+}
+
+bool AnimationLoader::loadAnimationSequence(const std::string& baseFilename, int startFrame, int endFrame) {
+    TRACE_SCOPE_DETAIL("load animation", baseFilename);
+    clearFrames();
+    totalFrames = 0;
+    currentFrame = 0;
+    elapsedTime = 0.0f;
+    sharedFrames = 0;
+    loadStart = std::chrono::steady_clock::now();
+    
+    if (verbose) {
+        std::cout << "Loading animation sequence..." << std::endl;
     }
     
-    int loadedFrames = 0;
+    std::vector<std::string> filenames = frameFilenames(baseFilename, startFrame, endFrame);
+    TextureLoading workerTextures = textureLoading == TEXTURES_UPLOAD ? TEXTURES_DEFERRED : textureLoading;
     
-    // Load each frame
-    for (int i = startFrame; i <= endFrame; i++) {
-        std::ostringstream oss;
-        oss << directory << baseName << std::setw(4) << std::setfill('0') << i << ".obj";
-        std::string filename = oss.str();
+    if (progressiveLoading) {
+        // Missing files are left out up front, so the timeline length is known now
+        std::vector<std::string> existing;
+        for (const auto& filename : filenames) {
+            if (std::ifstream(filename).good()) {
+                existing.push_back(filename);
+            }
+            else {
+                std::cerr << "  Missing frame: " << filename << std::endl;
+            }
+        }
         
-        ObjLoader* frame = new ObjLoader();
-        if (frame->loadObj(filename)) {
+        // The first frame that loads is shown right away; the loader thread only reads it
+        size_t first = 0;
+        for (; first < existing.size() && frames.empty(); first++) {
+            ObjLoader* frame = new ObjLoader();
+            frame->setVerbose(verbose);
+            frame->setTextureLoading(textureLoading);
+            TRACE_SCOPE_DETAIL("load frame", existing[first]);
+            if (frame->loadObj(existing[first])) {
+                frames.push_back(frame);
+                frameNumbers.push_back(0);
+                frameHashes.insert(std::make_pair(frame->hashVertexData(), frame));
+            }
+            else {
+                delete frame;
+                std::cerr << "  Failed to load frame: " << existing[first] << std::endl;
+            }
+        }
+        if (frames.empty()) {
+            std::cerr << "Failed to load any animation frames!" << std::endl;
+            return false;
+        }
+        
+        totalFrames = existing.size() - first + 1;
+        loadingFiles.assign(existing.begin() + first, existing.end());
+        collectedFiles = 0;
+        if (verbose) {
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+            std::cout << "First frame ready after " << (int)ms << " ms; loading " << loadingFiles.size()
+                      << " more in the background" << std::endl;
+        }
+        if (loadingFiles.empty()) {
+            return true;
+        }
+        
+        const ObjLoader* firstFrame = frames.front();
+        loaderThread = std::thread([this, firstFrame, workerTextures]() {
+            parseFrames(loadingFiles, workerTextures, true, [&](int, ObjLoader* frame) {
+                // Only the first frame's topology is read, which no longer changes
+                if (frame && shareTopology) {
+                    frame->shareTopology(*firstFrame);
+                }
+                std::lock_guard<std::mutex> lock(arrivedMutex);
+                arrivedFrames.push_back(frame);
+                frameArrived.notify_all();
+            });
+        });
+        return true;
+    }
+    
+    parseFrames(filenames, workerTextures, !verbose, [&](int index, ObjLoader* frame) {
+        // Frames are created and deleted here only: the destructor touches GL state
+        int i = startFrame + index;
+        if (frame) {
+            // Before the upload, so frames that share never upload their own copy of the textures
+            if (shareTopology && !frames.empty() && frame->shareTopology(*frames.front())) {
+                sharedFrames++;
+                frame = uniqueFrame(frame);
+            }
+            else {
+                frameHashes.insert(std::make_pair(frame->hashVertexData(), frame));
+            }
+            if (textureLoading == TEXTURES_UPLOAD) {
+                frame->uploadPendingTextures();
+            }
+            frameNumbers.push_back(frames.size());
             frames.push_back(frame);
-            loadedFrames++;
-            std::cout << "  Loaded frame " << i << ": " << filename << std::endl;
+            if (verbose) {
+                std::cout << "  Loaded frame " << i << ": " << filenames[index] << std::endl;
+            }
         } else {
-            delete frame;
-            std::cerr << "  Failed to load frame " << i << ": " << filename << std::endl;
+            std::cerr << "  Failed to load frame " << i << ": " << filenames[index] << std::endl;
         }
-    }
+    });
     
     totalFrames = frames.size();
-    currentFrame = 0;
     
     if (totalFrames > 0) {
-        std::cout << "Animation loaded: " << totalFrames << " frames" << std::endl;
-        std::cout << "FPS: " << fps << std::endl;
+        if (verbose) {
+            std::cout << "Animation loaded: " << totalFrames << " frames" << std::endl;
+            if (shareTopology) {
+                std::cout << "Shared topology: " << sharedFrames << " of " << totalFrames - 1
+                          << " frames reuse the faces and materials of the first" << std::endl;
+            }
+            printUniqueFrames();
+            std::cout << "FPS: " << fps << std::endl;
+        }
         return true;
     } else {
         std::cerr << "Failed to load any animation frames!" << std::endl;
@@ -77,6 +321,166 @@ bool AnimationLoader::loadAnimationSequence(const std::string& baseFilename, int
     }
 }
 
+// Moves frames the loader thread finished into 'frames' (GL thread: uploads textures)
+void AnimationLoader::collectLoadedFrames() {
+    if (!loaderThread.joinable()) {
+        return;
+    }
+    std::vector<ObjLoader*> arrived;
+    {
+        std::lock_guard<std::mutex> lock(arrivedMutex);
+        arrived.swap(arrivedFrames);
+    }
+    const ObjLoader* first = frames.front();
+    for (auto frame : arrived) {
+        if (!frame) {
+            std::cerr << "  Failed to load frame: " << loadingFiles[collectedFiles] << std::endl;
+            totalFrames--;  // Later frames move up, as in a full load
+        }
+        else {
+            size_t knownFrames = frameHashes.size();
+            if (frame->sharesTopologyWith(*first)) {
+                sharedFrames++;
+                frame = uniqueFrame(frame);
+            }
+            else {
+                frameHashes.insert(std::make_pair(frame->hashVertexData(), frame));
+                if (textureLoading == TEXTURES_UPLOAD) {
+                    frame->uploadPendingTextures();
+                }
+            }
+            if (frameHashes.size() != knownFrames) {
+                // Not a duplicate: those are earlier frames, possibly on screen with their backend built
+                frame->setFrustumCulling(first->isFrustumCulling());
+                frame->setOcclusionCuller(first->getOcclusionCuller());
+                frame->setRenderBackend(first->getRenderBackendType());
+            }
+            frameNumbers.push_back(frames.size());
+            frames.push_back(frame);
+        }
+        collectedFiles++;
+    }
+    if (collectedFiles < (int)loadingFiles.size()) {
+        return;
+    }
+    
+    loaderThread.join();
+    loadingFiles.clear();
+    if (currentFrame >= totalFrames) {
+        currentFrame = totalFrames - 1;
+    }
+    if (verbose) {
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+        std::cout << "Animation loaded: " << totalFrames << " frames in " << (int)ms << " ms" << std::endl;
+        if (shareTopology) {
+            std::cout << "Shared topology: " << sharedFrames << " of " << totalFrames - 1
+                      << " frames reuse the faces and materials of the first" << std::endl;
+        }
+        printUniqueFrames();
+    }
+}
+
+void AnimationLoader::finishLoading() {
+    if (!loaderThread.joinable()) {
+        return;
+    }
+    TRACE_SCOPE("finish loading");
+    {
+        std::unique_lock<std::mutex> lock(arrivedMutex);
+        frameArrived.wait(lock, [&]() {
+            return collectedFiles + (int)arrivedFrames.size() >= (int)loadingFiles.size();
+        });
+    }
+    collectLoadedFrames();
+}
+
+bool AnimationLoader::loadAnimationContainer(const std::string& filename) {
+    TRACE_SCOPE_DETAIL("load animation container", filename);
+    clearFrames();
+    totalFrames = 0;
+    currentFrame = 0;
+    elapsedTime = 0.0f;
+
+    AnimContainer container;
+    if (!container.open(filename)) {
+        std::cerr << "Failed to load any animation frames!" << std::endl;
+        return false;
+    }
+
+    // The first frame owns the topology (and textures); the others adopt it without comparing
+    for (int i = 0; i < container.getFrameCount(); i++) {
+        ObjLoader* frame = new ObjLoader();
+        frame->setVerbose(false);
+        if (frames.empty()) {
+            frame->setTextureLoading(textureLoading);
+            if (!frame->readTopology(container.getTopologyData(), container.getTopologySize(),
+                                     container.getDirectory())) {
+                delete frame;
+                std::cerr << "Failed to load any animation frames!" << std::endl;
+                return false;
+            }
+        }
+        else {
+            frame->adoptTopology(*frames.front());
+        }
+        frame->setFrameVertices(container.getPositions(i), container.getVertexCount(),
+                                container.getNormals(i), container.getNormalCount());
+        if (frames.empty()) {
+            frameHashes.insert(std::make_pair(frame->hashVertexData(), frame));
+        }
+        else {
+            frame = uniqueFrame(frame);
+        }
+        frames.push_back(frame);
+        frameNumbers.push_back(container.getFrameNumber(i));
+    }
+    // Numbers are relative to the packed range, which starts at the first frame
+    int firstNumber = frameNumbers.front();
+    for (auto& number : frameNumbers) {
+        number -= firstNumber;
+    }
+    totalFrames = frameNumbers.back() + 1;
+
+    if (verbose) {
+        std::cout << "Animation loaded: " << frames.size() << " frames (" << totalFrames << " on the timeline) from "
+                  << filename << ", " << container.getFileSize() / 1024 << " KB" << std::endl;
+        printUniqueFrames();
+        std::cout << "FPS: " << fps << std::endl;
+    }
+    return true;
+}
+
+bool AnimationLoader::openContainerStream(const std::string& filename, int windowFrames) {
+    TRACE_SCOPE_DETAIL("open animation stream", filename);
+    clearFrames();
+    totalFrames = 0;
+    currentFrame = 0;
+    elapsedTime = 0.0f;
+
+    stream = new AnimationStream();
+    if (!stream->openContainer(filename, windowFrames, textureLoading)) {
+        delete stream;
+        stream = nullptr;
+        std::cerr << "Failed to load any animation frames!" << std::endl;
+        return false;
+    }
+    totalFrames = stream->getFrameCount();
+
+    if (verbose) {
+        std::cout << "Animation streaming: " << stream->getSourceFrames() << " frames (" << totalFrames
+                  << " on the timeline) from " << filename << ", " << stream->getWindowFrames()
+                  << " prefetched ahead" << std::endl;
+    }
+    return true;
+}
+
+void AnimationLoader::setLoadThreads(int count) {
+    if (count <= 0) {
+        count = std::min((int)std::thread::hardware_concurrency(), kMaxDefaultLoadThreads);
+    }
+    loadThreads = std::max(1, count);
+}
+
 void AnimationLoader::play() {
     if (totalFrames > 0) {
         isPlaying = true;
@@ -93,6 +497,9 @@ void AnimationLoader::stop() {
     isPlaying = false;
     currentFrame = 0;
     elapsedTime = 0.0f;
+    if (stream) {
+        stream->seek(currentFrame, direction, loop);
+    }
     std::cout << "Animation stopped" << std::endl;
 }
 
@@ -109,7 +516,196 @@ void AnimationLoader::setLoop(bool shouldLoop) {
     std::cout << "Loop: " << (loop ? "ON" : "OFF") << std::endl;
 }
 
+void AnimationLoader::setReverse(bool reverse) {
+    direction = reverse ? -1 : 1;
+    std::cout << "Playback: " << (reverse ? "backward" : "forward") << std::endl;
+}
+
+void AnimationLoader::setInterpolation(bool enabled) {
+    interpolate = enabled;
+    shownModel = nullptr;
+    blendPosition = -1.0f;
+    std::cout << "Interpolation: " << (interpolate ? "ON" : "OFF") << std::endl;
+}
+
+int AnimationLoader::decimateFrames(float tolerance) {
+    finishLoading();
+    int count = frames.size();
+    if (stream || count < 3) {
+        return 0;
+    }
+    TRACE_SCOPE("decimate frames");
+    const ObjLoader* first = frames.front();
+    float positionTolerance = tolerance * 2.0f / first->getScale();  // getScale() is 2 / largest extent
+    float normalTolerance = tolerance * 2.0f;
+
+    // Whether every frame strictly between kept frames 'from' and 'to' is reproduced by their blend
+    auto spanFits = [&](int from, int to) {
+        for (int i = from; i <= to; i++) {
+            if (!frames[i]->sharesTopologyWith(*first)) {
+                return false;
+            }
+        }
+        for (int i = from + 1; i < to; i++) {
+            float t = (float)(frameNumbers[i] - frameNumbers[from]) / (frameNumbers[to] - frameNumbers[from]);
+            if (!interpolatesWithin(frames[from]->getVertices(), frames[to]->getVertices(),
+                                    frames[i]->getVertices(), t, positionTolerance) ||
+                !interpolatesWithin(frames[from]->getNormals(), frames[to]->getNormals(),
+                                    frames[i]->getNormals(), t, normalTolerance)) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    // Greedy: stretch the span from the last kept frame until a frame inside no longer fits
+    std::vector<char> keep(count, 0);
+    keep[0] = keep[count - 1] = 1;
+    int anchor = 0;
+    for (int end = anchor + 2; end < count; end++) {
+        if (!spanFits(anchor, end)) {
+            anchor = end - 1;
+            keep[anchor] = 1;
+        }
+    }
+
+    std::vector<ObjLoader*> before = distinctFrames();
+    std::vector<ObjLoader*> kept;
+    std::vector<int> keptNumbers;
+    for (int i = 0; i < count; i++) {
+        if (keep[i]) {
+            kept.push_back(frames[i]);
+            keptNumbers.push_back(frameNumbers[i]);
+        }
+    }
+    frames.swap(kept);
+    frameNumbers.swap(keptNumbers);
+    // A dropped frame may still be kept elsewhere as a duplicate
+    std::vector<ObjLoader*> after = distinctFrames();
+    for (auto frame : before) {
+        if (!std::binary_search(after.begin(), after.end(), frame)) {
+            for (auto entry = frameHashes.begin(); entry != frameHashes.end(); ++entry) {
+                if (entry->second == frame) {
+                    frameHashes.erase(entry);
+                    break;
+                }
+            }
+            delete frame;
+        }
+    }
+    shownModel = nullptr;
+    blendPosition = -1.0f;
+
+    int dropped = count - (int)frames.size();
+    if (verbose) {
+        std::cout << "Decimation: kept " << frames.size() << " of " << count << " frames (tolerance "
+                  << tolerance << ")" << std::endl;
+    }
+    return dropped;
+}
+
+// An earlier frame with the same positions and normals, deleting 'frame', or
+// 'frame' itself, remembered for later frames. 'frame' must share the
+// topology of the frames before it and never have been drawn.
+ObjLoader* AnimationLoader::uniqueFrame(ObjLoader* frame) {
+    uint64_t hash = frame->hashVertexData();
+    if (deduplicate) {
+        auto range = frameHashes.equal_range(hash);
+        for (auto entry = range.first; entry != range.second; ++entry) {
+            if (frame->hasSameVertexData(*entry->second)) {
+                delete frame;
+                return entry->second;
+            }
+        }
+    }
+    frameHashes.insert(std::make_pair(hash, frame));
+    return frame;
+}
+
+// Each model in 'frames' once, sorted by address
+std::vector<ObjLoader*> AnimationLoader::distinctFrames() const {
+    std::vector<ObjLoader*> distinct(frames);
+    std::sort(distinct.begin(), distinct.end());
+    distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+    return distinct;
+}
+
+void AnimationLoader::printUniqueFrames() const {
+    if (deduplicate && !frames.empty()) {
+        int unique = getUniqueFrameCount();
+        std::cout << "Unique frames: " << unique << " of " << frames.size() << " (" << frames.size() - unique
+                  << " identical frames share the memory and buffers of an earlier one)" << std::endl;
+    }
+}
+
+// Index in 'frames' of the last kept frame at or before 'position'
+int AnimationLoader::keptFrameAt(float position) const {
+    int index = (int)(std::upper_bound(frameNumbers.begin(), frameNumbers.end(), position) - frameNumbers.begin()) - 1;
+    return std::max(index, 0);
+}
+
+float AnimationLoader::getPlaybackPosition() const {
+    if (totalFrames == 0) {
+        return 0.0f;
+    }
+    float position = currentFrame + direction * std::min(elapsedTime / frameTime, 1.0f);
+    return std::max(0.0f, std::min(position, (float)(totalFrames - 1)));
+}
+
+// Points shownModel at the model for the current playback position, blending if it lies between kept frames
+void AnimationLoader::updateBlend() {
+    if (!isInterpolating()) {
+        return;
+    }
+    float position = getPlaybackPosition();
+    if (shownModel && position == blendPosition) {
+        return;
+    }
+    blendPosition = position;
+    int from = keptFrameAt(position);
+    int to = std::min(from + 1, (int)frames.size() - 1);
+    float t = to > from ? (position - frameNumbers[from]) / (frameNumbers[to] - frameNumbers[from]) : 0.0f;
+    if (t <= 0.0f) {
+        shownModel = frames[from];
+        return;
+    }
+
+    if (!blendModel) {
+        const ObjLoader* first = frames.front();
+        blendModel = new ObjLoader();
+        blendModel->setFrustumCulling(first->isFrustumCulling());
+        blendModel->setOcclusionCuller(first->getOcclusionCuller());
+        blendModel->setRenderBackend(first->getRenderBackendType());
+    }
+    shownModel = blendModel->interpolateFrames(*frames[from], *frames[to], t) ? blendModel : frames[from];
+}
+
+void AnimationLoader::setFrustumCulling(bool enabled) {
+    if (stream) stream->setFrustumCulling(enabled);
+    if (blendModel) blendModel->setFrustumCulling(enabled);
+    for (auto frame : frames) {
+        frame->setFrustumCulling(enabled);
+    }
+}
+
+void AnimationLoader::setOcclusionCuller(OcclusionCuller* culler) {
+    if (stream) stream->setOcclusionCuller(culler);
+    if (blendModel) blendModel->setOcclusionCuller(culler);
+    for (auto frame : frames) {
+        frame->setOcclusionCuller(culler);
+    }
+}
+
+void AnimationLoader::setRenderBackend(RenderBackendType type) {
+    if (stream) stream->setRenderBackend(type);
+    if (blendModel) blendModel->setRenderBackend(type);
+    for (auto frame : frames) {
+        frame->setRenderBackend(type);
+    }
+}
+
 void AnimationLoader::update(float deltaTime) {
+    collectLoadedFrames();
     if (!isPlaying || totalFrames == 0) {
         return;
     }
@@ -118,34 +714,79 @@ void AnimationLoader::update(float deltaTime) {
     
     // Check if it's time to advance to the next frame
     if (elapsedTime >= frameTime) {
-        elapsedTime -= frameTime;
-        currentFrame++;
+        int next = currentFrame + direction;
+        bool finished = false;
         
         // Handle looping
-        if (currentFrame >= totalFrames) {
+        if (next >= totalFrames || next < 0) {
             if (loop) {
-                currentFrame = 0;
+                next = direction > 0 ? 0 : totalFrames - 1;
             } else {
-                currentFrame = totalFrames - 1;
-                isPlaying = false;
-                std::cout << "Animation finished" << std::endl;
+                next = direction > 0 ? totalFrames - 1 : 0;
+                finished = true;
             }
         }
+        
+        // Frames of a progressive load arrive in order: wait on the current one until 'next' is there
+        if (isLoading() && next >= (int)frames.size()) {
+            elapsedTime = frameTime;
+            updateBlend();
+            return;
+        }
+        elapsedTime -= frameTime;
+        currentFrame = next;
+        if (finished) {
+            isPlaying = false;
+            std::cout << "Animation finished" << std::endl;
+        }
+        
+        if (stream) {
+            stream->seek(currentFrame, direction, loop);
+        }
     }
+    updateBlend();
 }
 
 void AnimationLoader::draw() {
-    if (totalFrames > 0 && currentFrame >= 0 && currentFrame < totalFrames) {
-        frames[currentFrame]->draw();
+    collectLoadedFrames();
+    if (stream) {
+        stream->refresh();
+    }
+    updateBlend();
+    if (ObjLoader* model = getCurrentModel()) {
+        model->draw();
     }
 }
 
 void AnimationLoader::drawWithMaterials() {
-    if (totalFrames > 0 && currentFrame >= 0 && currentFrame < totalFrames) {
-        if (frames[currentFrame]->hasMaterials()) {
-            frames[currentFrame]->drawWithMaterials();
+    collectLoadedFrames();
+    if (stream) {
+        stream->refresh();
+    }
+    updateBlend();
+    if (ObjLoader* model = getCurrentModel()) {
+        if (model->hasMaterials()) {
+            model->drawWithMaterials();
         } else {
-            frames[currentFrame]->draw();
+            model->draw();
         }
     }
 }
+
+MemoryUsage AnimationLoader::getMemoryUsage() const {
+    if (stream) {
+        return stream->getMemoryUsage();
+    }
+    MemoryUsage usage;
+    std::vector<ObjLoader*> distinct = distinctFrames();
+    for (auto frame : distinct) {
+        bool sharedTopology = frame != frames.front() && frame->sharesTopologyWith(*frames.front());
+        usage += frame->getMemoryUsage(!sharedTopology);
+    }
+    if (blendModel) {
+        usage += blendModel->getMemoryUsage(false);
+    }
+    usage.meshTables += distinct.size() * sizeof(ObjLoader) + frames.capacity() * sizeof(ObjLoader*) +
+                        frameNumbers.capacity() * sizeof(int);
+    return usage;
+}
@@ -3,11 +3,20 @@
 
 #include <vector>
 #include <string>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 #include "ObjLoader.h"
+#include "AnimationStream.h"
 
 class AnimationLoader {
 private:
     std::vector<ObjLoader*> frames;
+    std::vector<int> frameNumbers;      // Timeline frame of each entry in 'frames', ascending
     int currentFrame;
     int totalFrames;
     float fps;
@@ -15,6 +24,38 @@ private:
     float elapsedTime;
     bool isPlaying;
     bool loop;
+    bool verbose;
+    int loadThreads;
+    TextureLoading textureLoading;
+    bool shareTopology;
+    int direction;                      // +1 forward, -1 backward
+    AnimationStream* stream;            // Set while streaming instead of holding every frame
+    bool interpolate;
+    ObjLoader* blendModel;              // Interpolated positions, shares the frames' topology
+    ObjLoader* shownModel;              // blendModel or a kept frame; nullptr until updateBlend()
+    float blendPosition;                // Playback position shownModel was made for
+    bool progressiveLoading;
+    std::thread loaderThread;           // Loads frames 1.. after a progressive load returned
+    std::atomic<bool> cancelLoad;
+    std::mutex arrivedMutex;
+    std::condition_variable frameArrived;
+    std::vector<ObjLoader*> arrivedFrames;  // Loaded in order, not yet collected; nullptr if a frame failed
+    std::vector<std::string> loadingFiles;  // Files of the frames the loader thread works on
+    int collectedFiles;                 // Entries of loadingFiles collected so far
+    int sharedFrames;
+    bool deduplicate;
+    std::unordered_multimap<uint64_t, ObjLoader*> frameHashes;  // Distinct frames by hashVertexData()
+    std::chrono::steady_clock::time_point loadStart;
+
+    void clearFrames();
+    void parseFrames(const std::vector<std::string>& filenames, TextureLoading workerTextures, bool quiet,
+                     const std::function<void(int, ObjLoader*)>& handOver);
+    void collectLoadedFrames();
+    ObjLoader* uniqueFrame(ObjLoader* frame);
+    std::vector<ObjLoader*> distinctFrames() const;
+    void printUniqueFrames() const;
+    int keptFrameAt(float position) const;
+    void updateBlend();
 
 public:
     AnimationLoader();
@@ -22,6 +63,17 @@ public:
     
     // Load animation sequence
     bool loadAnimationSequence(const std::string& baseFilename, int startFrame, int endFrame);
+    // Every frame of a .anim container (see AnimContainer), copied from its
+    // memory mapping: no parsing, and the frame numbers of a decimated pack
+    // are kept. Textures follow setTextureLoading().
+    bool loadAnimationContainer(const std::string& filename);
+    // Streams a .anim container: only the first frame and 'windowFrames'
+    // frames around the playback position are resident (see AnimationStream).
+    // OBJ sequences are not streamed, because parsing a frame (about 160 ms)
+    // takes several frame times at playback rate.
+    bool openContainerStream(const std::string& filename, int windowFrames);
+    bool isStreaming() const { return stream != nullptr; }
+    const AnimationStream* getStream() const { return stream; }
     
     // Animation control
     void play();
@@ -29,7 +81,45 @@ public:
     void stop();
     void setFPS(float fps);
     void setLoop(bool loop);
+    void setReverse(bool reverse);
+    bool isReversed() const { return direction < 0; }
     void update(float deltaTime);
+    // Draws the linear blend of the two kept frames around the playback
+    // position instead of the frame at or before it; loaded sequences only
+    void setInterpolation(bool enabled);
+    bool isInterpolating() const { return interpolate && !stream && !frames.empty(); }
+    // Drops frames that linear interpolation between the kept neighbours
+    // reproduces within 'tolerance': a fraction of the first frame's largest
+    // extent for positions, of the [-1, 1] range for normal components. The
+    // first and last frame and frames that do not share the first frame's
+    // topology are always kept; the timeline keeps its length. Waits for a
+    // progressive load to finish first. Returns the number of frames dropped.
+    int decimateFrames(float tolerance);
+    void setFrustumCulling(bool enabled);
+    void setOcclusionCuller(OcclusionCuller* culler);
+    void setRenderBackend(RenderBackendType type);
+    // Load progress messages (on by default); applies to the next load
+    void setVerbose(bool enabled) { verbose = enabled; }
+    // Frames are parsed on this many threads; 0 = hardware threads (at most 8), 1 = sequential
+    void setLoadThreads(int count);
+    int getLoadThreads() const { return loadThreads; }
+    // TEXTURES_UPLOAD (default) uploads on the calling thread, which must own the GL context
+    void setTextureLoading(TextureLoading mode) { textureLoading = mode; }
+    // Frames whose faces and materials match the first frame's share them (on by default)
+    void setShareTopology(bool enabled) { shareTopology = enabled; }
+    // Frames whose positions and normals are identical to an earlier frame's
+    // (holds in exported sequences) are replaced by that frame, sharing its
+    // memory and render buffers (on by default). Needs shared topology.
+    void setDeduplicateFrames(bool enabled) { deduplicate = enabled; }
+    // loadAnimationSequence() returns once the first frame is loaded and the
+    // others load on a background thread; they are collected (and their
+    // textures uploaded) by update() and draw(), and playback waits on the
+    // last loaded frame until the next one arrives. Off by default.
+    void setProgressiveLoading(bool enabled) { progressiveLoading = enabled; }
+    // Frames are still arriving from a progressive load
+    bool isLoading() const { return loaderThread.joinable(); }
+    // Blocks until a progressive load has delivered every frame (GL thread)
+    void finishLoading();
     
     // Drawing
     void draw();
@@ -38,9 +128,38 @@ public:
     // Getters
     int getCurrentFrame() const { return currentFrame; }
     int getTotalFrames() const { return totalFrames; }
+    // Frames held in memory (fewer than getTotalFrames() after decimateFrames()
+    // or while a progressive load is running)
+    int getKeptFrameCount() const { return frames.size(); }
+    // Distinct models among the kept frames (fewer after deduplication)
+    int getUniqueFrameCount() const { return distinctFrames().size(); }
+    // Current frame plus the part of the frame time already played, within [0, total - 1]
+    float getPlaybackPosition() const;
     bool isAnimationPlaying() const { return isPlaying; }
-    bool hasFrames() const { return !frames.empty(); }
+    bool hasFrames() const { return !frames.empty() || stream; }
     float getFPS() const { return fps; }
+    // Seconds of playback left before update() advances to the next frame
+    float getTimeToNextFrame() const { return elapsedTime < frameTime ? frameTime - elapsedTime : 0.0f; }
+    // Sum over all frames plus the frame table; a shared topology and a deduplicated frame count once
+    MemoryUsage getMemoryUsage() const;
+    // While streaming, the last frame that was ready (see AnimationStream::seek());
+    // while interpolating, the blend of the last draw
+    ObjLoader* getCurrentModel() const {
+        if (stream) {
+            return stream->getDisplayedModel();
+        }
+        if (isInterpolating() && shownModel) {
+            return shownModel;
+        }
+        return frames.empty() ? nullptr : frames[keptFrameAt(currentFrame)];
+    }
+    // Kept frames (0 .. getKeptFrameCount() - 1), identical frames being the
+    // same model; nullptr while streaming
+    ObjLoader* getFrame(int index) const {
+        return (index >= 0 && index < (int)frames.size()) ? frames[index] : nullptr;
+    }
+    // Timeline position of a kept frame
+    int getFrameNumber(int index) const { return frameNumbers[index]; }
 };
 
 #endif
@@ -0,0 +1,316 @@
+#include "AnimationStream.h"
+#include "Trace.h"
+#include <iostream>
+#include <algorithm>
+
+AnimationStream::AnimationStream()
+    : base(nullptr), stopping(false), position(0), direction(1), loop(true),
+      displayedFrame(-1), displayedSource(-1), displayedModel(nullptr),
+      droppedFrames(0), loadedFrames(0),
+      frustumCulling(true), occlusionCuller(nullptr), renderBackend(RENDER_BUFFERS), hasRenderBackend(false) {
+}
+
+AnimationStream::~AnimationStream() {
+    close();
+}
+
+bool AnimationStream::openContainer(const std::string& filename, int windowFrames, TextureLoading textures) {
+    close();
+    if (!container.open(filename)) {
+        return false;
+    }
+
+    base = new ObjLoader();
+    base->setVerbose(false);
+    base->setTextureLoading(textures);
+    if (!base->readTopology(container.getTopologyData(), container.getTopologySize(), container.getDirectory())) {
+        delete base;
+        base = nullptr;
+        container.close();
+        return false;
+    }
+    base->setFrameVertices(container.getPositions(0), container.getVertexCount(),
+                           container.getNormals(0), container.getNormalCount());
+    // Numbers are relative to the packed range, which starts at the first frame
+    frameNumbers.clear();
+    for (int i = 0; i < container.getFrameCount(); i++) {
+        frameNumbers.push_back(container.getFrameNumber(i) - container.getFrameNumber(0));
+    }
+
+    configure(base);
+    slots.assign(std::max(1, windowFrames), Slot());
+    stopping = false;
+    position = 0;
+    direction = 1;
+    displayedFrame = 0;
+    displayedSource = 0;
+    displayedModel = base;
+    droppedFrames = 0;
+    loadedFrames = 0;
+    prefetchThread = std::thread(&AnimationStream::prefetchLoop, this);
+    return true;
+}
+
+void AnimationStream::close() {
+    if (prefetchThread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        prefetchThread.join();
+    }
+
+    for (auto& slot : slots) {
+        delete slot.model;
+    }
+    slots.clear();
+    deleteRetired();
+    delete base;
+    base = nullptr;
+    frameNumbers.clear();
+    container.close();
+    displayedFrame = -1;
+    displayedSource = -1;
+    displayedModel = nullptr;
+}
+
+int AnimationStream::getSourceFrameCount() const {
+    return container.getFrameCount();
+}
+
+// Stored frame at or before timeline frame 'frame'
+int AnimationStream::sourceFrameAt(int frame) const {
+    int source = std::upper_bound(frameNumbers.begin(), frameNumbers.end(), frame) - frameNumbers.begin() - 1;
+    return std::max(0, source);
+}
+
+// Source frame 'distance' frames ahead of the one shown at the playback
+// position, -1 past the end without looping
+int AnimationStream::wantedFrame(int distance) const {
+    int count = getSourceFrameCount();
+    int frame = sourceFrameAt(position) + distance * direction;
+    if (loop) {
+        return ((frame % count) + count) % count;
+    }
+    return (frame >= 0 && frame < count) ? frame : -1;
+}
+
+// Nearest wanted frame that is not resident and a slot to load it into:
+// an empty one, or one holding a frame behind playback (never the displayed one)
+bool AnimationStream::findWork(int& frame, int& slot) const {
+    int window = slots.size();
+    for (int distance = 0; distance < window; distance++) {
+        int wanted = wantedFrame(distance);
+        if (wanted < 0) {
+            return false;
+        }
+        if (wanted == 0) {
+            continue;  // Always resident (base)
+        }
+        bool resident = false;
+        for (const Slot& s : slots) {
+            resident = resident || s.frame == wanted;
+        }
+        if (resident) {
+            continue;
+        }
+
+        for (int i = 0; i < window; i++) {
+            const Slot& s = slots[i];
+            if (s.frame < 0) {
+                frame = wanted;
+                slot = i;
+                return true;
+            }
+        }
+        for (int i = 0; i < window; i++) {
+            const Slot& s = slots[i];
+            if (!s.ready || s.frame == displayedSource) {
+                continue;
+            }
+            bool stillWanted = false;
+            for (int d = 0; d < window && !stillWanted; d++) {
+                stillWanted = wantedFrame(d) == s.frame;
+            }
+            if (!stillWanted) {
+                frame = wanted;
+                slot = i;
+                return true;
+            }
+        }
+        return false;
+    }
+    return false;
+}
+
+void AnimationStream::configure(ObjLoader* model) const {
+    model->setFrustumCulling(frustumCulling);
+    model->setOcclusionCuller(occlusionCuller);
+    if (hasRenderBackend) {
+        model->setRenderBackend(renderBackend);
+    }
+}
+
+void AnimationStream::prefetchLoop() {
+    while (true) {
+        int frame = -1;
+        int slot = -1;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&]() { return stopping || findWork(frame, slot); });
+            if (stopping) {
+                return;
+            }
+            Slot& target = slots[slot];
+            if (target.model) {
+                retired.push_back(target.model);
+            }
+            target.frame = frame;
+            target.model = nullptr;
+            target.ready = false;
+        }
+
+        // The base frame's topology and objects are only read here, never changed after open
+        ObjLoader* model = new ObjLoader();
+        {
+            TRACE_SCOPE("prefetch frame");
+            model->setVerbose(false);
+            model->setTextureLoading(TEXTURES_SKIP);
+            model->adoptTopology(*base);
+            model->setFrameVertices(container.getPositions(frame), container.getVertexCount(),
+                                    container.getNormals(frame), container.getNormalCount());
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        Slot& target = slots[slot];
+        configure(model);
+        loadedFrames++;
+        target.model = model;
+        target.ready = true;
+    }
+}
+
+void AnimationStream::deleteRetired() {
+    std::vector<ObjLoader*> evicted;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        evicted.swap(retired);
+    }
+    for (auto model : evicted) {
+        delete model;
+    }
+}
+
+void AnimationStream::seek(int frame, int newDirection, bool shouldLoop) {
+    if (!base) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        position = frame;
+        direction = newDirection < 0 ? -1 : 1;
+        loop = shouldLoop;
+
+        int source = sourceFrameAt(frame);
+        ObjLoader* model = source == 0 ? base : nullptr;
+        bool ready = source == 0;
+        for (const Slot& slot : slots) {
+            if (slot.frame == source && slot.ready) {
+                model = slot.model;
+                ready = true;
+            }
+        }
+        if (model) {
+            displayedFrame = frame;
+            displayedSource = source;
+            displayedModel = model;
+        }
+        else if (!ready && source != displayedSource) {
+            droppedFrames++;
+        }
+    }
+    wake.notify_one();
+    deleteRetired();
+}
+
+void AnimationStream::refresh() {
+    if (!base || displayedFrame == position) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    int source = sourceFrameAt(position);
+    for (const Slot& slot : slots) {
+        if (slot.frame == source && slot.ready && slot.model) {
+            displayedFrame = position;
+            displayedSource = source;
+            displayedModel = slot.model;
+        }
+    }
+}
+
+int AnimationStream::getDroppedFrames() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return droppedFrames;
+}
+
+int AnimationStream::getLoadedFrames() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return loadedFrames;
+}
+
+int AnimationStream::getResidentFrames() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    int resident = base ? 1 : 0;
+    for (const Slot& slot : slots) {
+        if (slot.ready && slot.model) {
+            resident++;
+        }
+    }
+    return resident;
+}
+
+void AnimationStream::setFrustumCulling(bool enabled) {
+    std::lock_guard<std::mutex> lock(mutex);
+    frustumCulling = enabled;
+    if (base) base->setFrustumCulling(enabled);
+    for (const Slot& slot : slots) {
+        if (slot.ready && slot.model) slot.model->setFrustumCulling(enabled);
+    }
+}
+
+void AnimationStream::setOcclusionCuller(OcclusionCuller* culler) {
+    std::lock_guard<std::mutex> lock(mutex);
+    occlusionCuller = culler;
+    if (base) base->setOcclusionCuller(culler);
+    for (const Slot& slot : slots) {
+        if (slot.ready && slot.model) slot.model->setOcclusionCuller(culler);
+    }
+}
+
+void AnimationStream::setRenderBackend(RenderBackendType type) {
+    std::lock_guard<std::mutex> lock(mutex);
+    renderBackend = type;
+    hasRenderBackend = true;
+    if (base) base->setRenderBackend(type);
+    for (const Slot& slot : slots) {
+        if (slot.ready && slot.model) slot.model->setRenderBackend(type);
+    }
+}
+
+MemoryUsage AnimationStream::getMemoryUsage() const {
+    MemoryUsage usage;
+    if (!base) {
+        return usage;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    usage += base->getMemoryUsage();
+    for (const Slot& slot : slots) {
+        if (slot.ready && slot.model) {
+            usage += slot.model->getMemoryUsage(!slot.model->sharesTopologyWith(*base));
+        }
+    }
+    usage.meshTables += sizeof(AnimationStream) + slots.capacity() * sizeof(Slot) +
+                        (slots.size() + 1) * sizeof(ObjLoader);
+    return usage;
+}
@@ -0,0 +1,101 @@
+#ifndef ANIMATION_STREAM_H
+#define ANIMATION_STREAM_H
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "ObjLoader.h"
+#include "AnimContainer.h"
+
+// Streaming playback of a .anim container for AnimationLoader: only the first
+// frame (which holds the shared topology and the textures) and a ring of
+// 'window' further frames are resident. A background thread copies the frames
+// ahead of the playback position, in the direction of playback, from the
+// container's mapping into ring slots whose frames fell out of that range. Memory therefore depends on the window, not on the
+// length of the sequence. A frame that is not ready when playback reaches it
+// is counted as dropped and the last ready frame stays on screen.
+// Playback positions are timeline frames. A container may leave frames out
+// (decimation), and then a position shows the stored frame at or before it,
+// as AnimationLoader does when it loads the whole container.
+//
+// Everything except the prefetch thread runs on the GL thread, which also
+// deletes evicted frames (their render backends own GL objects).
+class AnimationStream {
+private:
+    struct Slot {
+        int frame;          // Container entry, -1 if empty
+        ObjLoader* model;   // nullptr while loading
+        bool ready;
+        Slot() : frame(-1), model(nullptr), ready(false) {}
+    };
+
+    AnimContainer container;
+    std::vector<int> frameNumbers;      // Timeline frame of each container entry, the first being 0
+    ObjLoader* base;                    // Frame 0, resident while the stream is open
+    std::vector<Slot> slots;
+    std::vector<ObjLoader*> retired;    // Evicted by the prefetch thread, deleted on the GL thread
+    std::thread prefetchThread;
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping;
+
+    int position;                       // Timeline frame playback wants to show
+    int direction;                      // +1 forward, -1 backward
+    bool loop;
+    int displayedFrame;                 // Timeline frame
+    int displayedSource;                // Container entry shown for it
+    ObjLoader* displayedModel;
+
+    int droppedFrames;
+    int loadedFrames;
+
+    // Settings applied to every frame as it becomes ready
+    bool frustumCulling;
+    OcclusionCuller* occlusionCuller;
+    RenderBackendType renderBackend;
+    bool hasRenderBackend;
+
+    int wantedFrame(int distance) const;
+    int getSourceFrameCount() const;
+    int sourceFrameAt(int frame) const;
+    bool findWork(int& frame, int& slot) const;
+    void configure(ObjLoader* model) const;
+    void prefetchLoop();
+    void deleteRetired();
+
+public:
+    AnimationStream();
+    ~AnimationStream();
+
+    // Maps the container, sets up frame 0 on the calling (GL) thread and
+    // starts prefetching the frames after it; false if either fails
+    bool openContainer(const std::string& filename, int windowFrames, TextureLoading textures);
+    void close();
+
+    // Moves playback to 'frame'. Shows it if it is ready, otherwise counts a
+    // dropped frame and keeps the previous one; also frees evicted frames.
+    void seek(int frame, int direction, bool loop);
+    // Shows the wanted frame if it arrived after seek(); cheap enough per draw
+    void refresh();
+
+    ObjLoader* getDisplayedModel() const { return displayedModel; }
+    int getDisplayedFrame() const { return displayedFrame; }
+    // Timeline length; larger than the stored frames if a container left some out
+    int getFrameCount() const { return frameNumbers.empty() ? 0 : frameNumbers.back() + 1; }
+    int getSourceFrames() const { return getSourceFrameCount(); }
+    int getWindowFrames() const { return slots.size(); }
+    int getDroppedFrames() const;
+    int getLoadedFrames() const;      // Copied by the prefetch thread
+    int getResidentFrames() const;    // First frame plus the ready ring slots
+
+    void setFrustumCulling(bool enabled);
+    void setOcclusionCuller(OcclusionCuller* culler);
+    void setRenderBackend(RenderBackendType type);
+
+    // First frame (with the topology) plus the resident window
+    MemoryUsage getMemoryUsage() const;
+};
+
+#endif
@@ -0,0 +1,177 @@
+#include "BackendBench.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+
+namespace {
+    const int kComparedViews = 8;
+}
+
+BackendBench::BackendBench(int width, int height, int viewCount)
+    : width(width), height(height), viewCount(std::max(1, viewCount)), tolerance(2),
+      maxMismatchRatio(0.001f), framebuffer(0), colorBuffer(0), depthBuffer(0) {
+}
+
+BackendBench::~BackendBench() {
+    destroyTarget();
+}
+
+bool BackendBench::createTarget() {
+    if (!hasFramebufferObjects()) {
+        return false;
+    }
+
+    extGenRenderbuffers(1, &colorBuffer);
+    extBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+    extRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    extGenRenderbuffers(1, &depthBuffer);
+    extBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+    extRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    extBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    extGenFramebuffers(1, &framebuffer);
+    extBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    extFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+    extFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+
+    if (extCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        destroyTarget();
+        return false;
+    }
+    return true;
+}
+
+void BackendBench::destroyTarget() {
+    if (framebuffer != 0) {
+        extBindFramebuffer(GL_FRAMEBUFFER, 0);
+        extDeleteFramebuffers(1, &framebuffer);
+        extDeleteRenderbuffers(1, &colorBuffer);
+        extDeleteRenderbuffers(1, &depthBuffer);
+    }
+    framebuffer = 0;
+    colorBuffer = 0;
+    depthBuffer = 0;
+}
+
+void BackendBench::readPixels(std::vector<unsigned char>& pixels) const {
+    pixels.resize(width * height * 3);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, &pixels[0]);
+}
+
+bool BackendBench::run(SetBackendFunc setBackend, RenderViewFunc renderView) {
+    results.clear();
+
+    bool offscreen = createTarget();
+    if (!offscreen) {
+        std::cerr << "Warning: No framebuffer objects, benchmarking the back buffer "
+                  << "(window must be visible for the pixel comparison)" << std::endl;
+        glDrawBuffer(GL_BACK);
+        glReadBuffer(GL_BACK);
+    }
+    glViewport(0, 0, width, height);
+
+    // Immediate mode renders the reference views; the other backends are compared to it
+    int compareEvery = std::max(1, viewCount / kComparedViews);
+    std::vector<std::vector<unsigned char> > reference;
+    std::vector<unsigned char> pixels;
+    std::vector<float> frameMs;
+    bool allPassed = true;
+
+    for (int t = 0; t < RENDER_BACKEND_COUNT; t++) {
+        BackendBenchResult result;
+        result.type = (RenderBackendType)t;
+        result.supported = isRenderBackendSupported(result.type);
+        if (!result.supported) {
+            results.push_back(result);
+            continue;
+        }
+
+        setBackend(result.type);
+        frameMs.clear();
+
+        for (int view = 0; view < viewCount; view++) {
+            auto start = std::chrono::high_resolution_clock::now();
+            renderView(view, viewCount);
+            glFinish();
+            frameMs.push_back(std::chrono::duration<float, std::milli>(
+                std::chrono::high_resolution_clock::now() - start).count());
+
+            if (view % compareEvery != 0) {
+                continue;
+            }
+            readPixels(pixels);
+            if (result.type == RENDER_IMMEDIATE) {
+                reference.push_back(pixels);
+                continue;
+            }
+
+            const std::vector<unsigned char>& expected = reference[view / compareEvery];
+            for (size_t p = 0; p < pixels.size(); p += 3) {
+                int diff = 0;
+                for (int c = 0; c < 3; c++) {
+                    diff = std::max(diff, std::abs((int)pixels[p + c] - (int)expected[p + c]));
+                }
+                result.maxChannelDiff = std::max(result.maxChannelDiff, diff);
+                if (diff > tolerance) {
+                    result.mismatchedPixels++;
+                }
+            }
+            result.comparedPixels += width * height;
+        }
+
+        result.firstMs = frameMs[0];
+        std::vector<float> sorted(frameMs.begin() + (frameMs.size() > 1 ? 1 : 0), frameMs.end());
+        std::sort(sorted.begin(), sorted.end());
+        float sum = 0.0f;
+        for (float ms : sorted) sum += ms;
+        result.avgMs = sum / sorted.size();
+        result.medianMs = sorted[sorted.size() / 2];
+        result.p95Ms = sorted[std::min(sorted.size() - 1, sorted.size() * 95 / 100)];
+        result.maxMs = sorted.back();
+
+        allPassed = allPassed && passed(result);
+        results.push_back(result);
+    }
+
+    destroyTarget();
+    return allPassed;
+}
+
+bool BackendBench::passed(const BackendBenchResult& result) const {
+    if (!result.supported || result.comparedPixels == 0) {
+        return true;
+    }
+    return result.mismatchedPixels <= result.comparedPixels * maxMismatchRatio;
+}
+
+void BackendBench::printReport(std::ostream& out) const {
+    char line[160];
+    out << "Render backends, " << viewCount << " views at " << width << "x" << height
+        << " (ms per view, glFinish included)" << std::endl;
+    snprintf(line, sizeof(line), "  %-10s %8s %8s %8s %8s %8s   %s",
+             "backend", "first", "avg", "median", "p95", "max", "vs immediate");
+    out << line << std::endl;
+
+    for (const BackendBenchResult& result : results) {
+        const char* name = getRenderBackendName(result.type);
+        if (!result.supported) {
+            snprintf(line, sizeof(line), "  %-10s not supported by this context", name);
+            out << line << std::endl;
+            continue;
+        }
+
+        char comparison[64];
+        if (result.type == RENDER_IMMEDIATE) {
+            snprintf(comparison, sizeof(comparison), "reference");
+        }
+        else {
+            snprintf(comparison, sizeof(comparison), "%s, %d px off (max diff %d)",
+                     passed(result) ? "match" : "MISMATCH", result.mismatchedPixels, result.maxChannelDiff);
+        }
+        snprintf(line, sizeof(line), "  %-10s %8.2f %8.2f %8.2f %8.2f %8.2f   %s", name, result.firstMs,
+                 result.avgMs, result.medianMs, result.p95Ms, result.maxMs, comparison);
+        out << line << std::endl;
+    }
+}
@@ -0,0 +1,67 @@
+#ifndef BACKEND_BENCH_H
+#define BACKEND_BENCH_H
+
+#include <vector>
+#include <iostream>
+#include "RenderBackend.h"
+
+struct BackendBenchResult {
+    RenderBackendType type;
+    bool supported;
+    float firstMs;          // First view, includes prepare() (welding, upload, list compilation)
+    float avgMs;            // Remaining views
+    float medianMs;
+    float p95Ms;
+    float maxMs;
+    int comparedPixels;
+    int mismatchedPixels;   // Differ from immediate mode by more than the tolerance
+    int maxChannelDiff;
+    BackendBenchResult() : type(RENDER_IMMEDIATE), supported(false), firstMs(0.0f), avgMs(0.0f),
+                           medianMs(0.0f), p95Ms(0.0f), maxMs(0.0f), comparedPixels(0),
+                           mismatchedPixels(0), maxChannelDiff(0) {}
+};
+
+// Renders the same camera orbit with every render backend into an offscreen
+// framebuffer, times each view (glFinish included) and compares a few views
+// of each backend pixel-wise against immediate mode. The caller supplies how
+// to switch backends and how to draw one view, so the viewer and headless
+// tools share it. Needs a current context; falls back to the back buffer
+// when framebuffer objects are missing.
+class BackendBench {
+public:
+    typedef void (*SetBackendFunc)(RenderBackendType type);
+    typedef void (*RenderViewFunc)(int view, int viewCount);
+
+private:
+    int width;
+    int height;
+    int viewCount;
+    int tolerance;              // Max per-channel difference still counted as a match
+    float maxMismatchRatio;     // Allowed fraction of mismatched pixels per backend
+    GLuint framebuffer;
+    GLuint colorBuffer;
+    GLuint depthBuffer;
+    std::vector<BackendBenchResult> results;
+
+    bool createTarget();
+    void destroyTarget();
+    void readPixels(std::vector<unsigned char>& pixels) const;
+
+public:
+    BackendBench(int width = 800, int height = 600, int viewCount = 120);
+    ~BackendBench();
+
+    void setTolerance(int channelDiff, float mismatchRatio) {
+        tolerance = channelDiff;
+        maxMismatchRatio = mismatchRatio;
+    }
+
+    // False if any supported backend does not match immediate mode
+    bool run(SetBackendFunc setBackend, RenderViewFunc renderView);
+    bool passed(const BackendBenchResult& result) const;
+
+    void printReport(std::ostream& out) const;
+    const std::vector<BackendBenchResult>& getResults() const { return results; }
+};
+
+#endif
@@ -0,0 +1,194 @@
+#include "Bvh.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    const int kLeafSize = 4;
+    const int kMaxStackDepth = 64;
+
+    inline Vec3 sub(const Vec3& a, const Vec3& b) { return Vec3(a.x - b.x, a.y - b.y, a.z - b.z); }
+    inline Vec3 cross(const Vec3& a, const Vec3& b) {
+        return Vec3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+    }
+    inline float dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+    inline float axis(const Vec3& v, int a) { return a == 0 ? v.x : (a == 1 ? v.y : v.z); }
+
+    inline void grow(Vec3& mn, Vec3& mx, const Vec3& p) {
+        mn.x = std::min(mn.x, p.x); mn.y = std::min(mn.y, p.y); mn.z = std::min(mn.z, p.z);
+        mx.x = std::max(mx.x, p.x); mx.y = std::max(mx.y, p.y); mx.z = std::max(mx.z, p.z);
+    }
+
+    // Slab test; returns the entry distance or a negative value on miss
+    inline float intersectBox(const Vec3& mn, const Vec3& mx, const Vec3& origin,
+                              const Vec3& invDir, float maxT) {
+        float tx1 = (mn.x - origin.x) * invDir.x, tx2 = (mx.x - origin.x) * invDir.x;
+        float tmin = std::min(tx1, tx2), tmax = std::max(tx1, tx2);
+        float ty1 = (mn.y - origin.y) * invDir.y, ty2 = (mx.y - origin.y) * invDir.y;
+        tmin = std::max(tmin, std::min(ty1, ty2)); tmax = std::min(tmax, std::max(ty1, ty2));
+        float tz1 = (mn.z - origin.z) * invDir.z, tz2 = (mx.z - origin.z) * invDir.z;
+        tmin = std::max(tmin, std::min(tz1, tz2)); tmax = std::min(tmax, std::max(tz1, tz2));
+        if (tmax >= std::max(tmin, 0.0f) && tmin < maxT) return std::max(tmin, 0.0f);
+        return -1.0f;
+    }
+}
+
+Bvh::Bvh() : source(nullptr), sourceVersion(0) {
+}
+
+void Bvh::clear() {
+    nodes.clear();
+    triangles.clear();
+    source = nullptr;
+}
+
+void Bvh::build(const ObjLoader& model) {
+    clear();
+    source = &model;
+    sourceVersion = model.getVertexVersion();
+
+    const std::vector<Vec3>& vertices = model.getVertices();
+    const std::vector<Face>& faces = model.getFaces();
+
+    // Fan-triangulate every face, skipping out-of-range indices like draw() does
+    for (size_t f = 0; f < faces.size(); f++) {
+        const std::vector<int>& idx = faces[f].vertexIndices;
+        for (size_t i = 1; i + 1 < idx.size(); i++) {
+            int a = idx[0], b = idx[i], c = idx[i + 1];
+            if (a < 0 || b < 0 || c < 0 ||
+                a >= (int)vertices.size() || b >= (int)vertices.size() || c >= (int)vertices.size()) {
+                continue;
+            }
+            Triangle tri;
+            tri.v0 = vertices[a];
+            tri.v1 = vertices[b];
+            tri.v2 = vertices[c];
+            tri.centroid = Vec3((tri.v0.x + tri.v1.x + tri.v2.x) / 3.0f,
+                                (tri.v0.y + tri.v1.y + tri.v2.y) / 3.0f,
+                                (tri.v0.z + tri.v1.z + tri.v2.z) / 3.0f);
+            tri.faceIndex = (int)f;
+            triangles.push_back(tri);
+        }
+    }
+
+    if (triangles.empty()) {
+        return;
+    }
+
+    nodes.reserve(2 * triangles.size() / kLeafSize + 1);
+    nodes.push_back(Node());
+    buildNode(0, 0, triangles.size());
+}
+
+void Bvh::buildNode(int nodeIndex, int first, int count) {
+    Vec3 mn(1e30f, 1e30f, 1e30f), mx(-1e30f, -1e30f, -1e30f);
+    Vec3 cmin(1e30f, 1e30f, 1e30f), cmax(-1e30f, -1e30f, -1e30f);
+    for (int i = first; i < first + count; i++) {
+        grow(mn, mx, triangles[i].v0);
+        grow(mn, mx, triangles[i].v1);
+        grow(mn, mx, triangles[i].v2);
+        grow(cmin, cmax, triangles[i].centroid);
+    }
+
+    nodes[nodeIndex].minBounds = mn;
+    nodes[nodeIndex].maxBounds = mx;
+
+    // Split on the longest centroid axis at the median
+    Vec3 extent = sub(cmax, cmin);
+    int splitAxis = 0;
+    if (extent.y > extent.x) splitAxis = 1;
+    if (extent.z > axis(extent, splitAxis)) splitAxis = 2;
+
+    if (count <= kLeafSize || axis(extent, splitAxis) <= 0.0f) {
+        nodes[nodeIndex].leftChild = -1;
+        nodes[nodeIndex].firstTriangle = first;
+        nodes[nodeIndex].triangleCount = count;
+        return;
+    }
+
+    int half = count / 2;
+    std::nth_element(triangles.begin() + first, triangles.begin() + first + half,
+                     triangles.begin() + first + count,
+                     [splitAxis](const Triangle& a, const Triangle& b) {
+                         return axis(a.centroid, splitAxis) < axis(b.centroid, splitAxis);
+                     });
+
+    int left = nodes.size();
+    nodes.push_back(Node());
+    nodes.push_back(Node());
+    nodes[nodeIndex].leftChild = left;
+    nodes[nodeIndex].firstTriangle = 0;
+    nodes[nodeIndex].triangleCount = 0;
+
+    buildNode(left, first, half);
+    buildNode(left + 1, first + half, count - half);
+}
+
+bool Bvh::intersectTriangle(const Triangle& tri, const Vec3& origin, const Vec3& direction, float& t) const {
+    // Moller-Trumbore, two-sided (the viewer renders with culling disabled)
+    Vec3 e1 = sub(tri.v1, tri.v0);
+    Vec3 e2 = sub(tri.v2, tri.v0);
+    Vec3 p = cross(direction, e2);
+    float det = dot(e1, p);
+    if (std::fabs(det) < 1e-12f) return false;
+
+    float invDet = 1.0f / det;
+    Vec3 s = sub(origin, tri.v0);
+    float u = dot(s, p) * invDet;
+    if (u < 0.0f || u > 1.0f) return false;
+
+    Vec3 q = cross(s, e1);
+    float v = dot(direction, q) * invDet;
+    if (v < 0.0f || u + v > 1.0f) return false;
+
+    t = dot(e2, q) * invDet;
+    return t >= 0.0f;
+}
+
+bool Bvh::intersect(const Vec3& origin, const Vec3& direction, RayHit& hit) const {
+    if (nodes.empty()) return false;
+
+    Vec3 invDir(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+    float bestT = 1e30f;
+    int bestTriangle = -1;
+
+    int stack[kMaxStackDepth];
+    int stackSize = 0;
+    if (intersectBox(nodes[0].minBounds, nodes[0].maxBounds, origin, invDir, bestT) >= 0.0f) {
+        stack[stackSize++] = 0;
+    }
+
+    while (stackSize > 0) {
+        const Node& node = nodes[stack[--stackSize]];
+
+        if (node.triangleCount > 0) {
+            for (int i = node.firstTriangle; i < node.firstTriangle + node.triangleCount; i++) {
+                float t;
+                if (intersectTriangle(triangles[i], origin, direction, t) && t < bestT) {
+                    bestT = t;
+                    bestTriangle = i;
+                }
+            }
+            continue;
+        }
+
+        // Visit the nearer child first so later boxes are rejected by bestT
+        int a = node.leftChild, b = node.leftChild + 1;
+        float ta = intersectBox(nodes[a].minBounds, nodes[a].maxBounds, origin, invDir, bestT);
+        float tb = intersectBox(nodes[b].minBounds, nodes[b].maxBounds, origin, invDir, bestT);
+        if (ta >= 0.0f && tb >= 0.0f && tb < ta) {
+            std::swap(a, b);
+            std::swap(ta, tb);
+        }
+        if (tb >= 0.0f && stackSize < kMaxStackDepth) stack[stackSize++] = b;
+        if (ta >= 0.0f && stackSize < kMaxStackDepth) stack[stackSize++] = a;
+    }
+
+    if (bestTriangle < 0) return false;
+
+    hit.faceIndex = triangles[bestTriangle].faceIndex;
+    hit.distance = bestT;
+    hit.position = Vec3(origin.x + direction.x * bestT,
+                        origin.y + direction.y * bestT,
+                        origin.z + direction.z * bestT);
+    return true;
+}
@@ -0,0 +1,60 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <vector>
+#include "ObjLoader.h"
+
+struct RayHit {
+    int faceIndex;     // Index into ObjLoader::getFaces()
+    float distance;    // Ray parameter t (model units if direction is unit length)
+    Vec3 position;     // Hit point in model space
+    RayHit() : faceIndex(-1), distance(0.0f) {}
+};
+
+// Bounding volume hierarchy over the triangulated faces of an ObjLoader.
+// Used for mouse picking: a ray cast touches only a few dozen triangles
+// instead of every face in the model.
+class Bvh {
+private:
+    struct Node {
+        Vec3 minBounds;
+        Vec3 maxBounds;
+        int leftChild;     // Interior: index of left child (right = left + 1)
+        int firstTriangle; // Leaf: first triangle in 'triangles'
+        int triangleCount; // 0 for interior nodes
+    };
+
+    struct Triangle {
+        Vec3 v0, v1, v2;
+        Vec3 centroid;
+        int faceIndex;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<Triangle> triangles;
+    const ObjLoader* source;
+    unsigned int sourceVersion;  // source->getVertexVersion() at build time
+
+    void buildNode(int nodeIndex, int first, int count);
+    bool intersectTriangle(const Triangle& tri, const Vec3& origin, const Vec3& direction, float& t) const;
+
+public:
+    Bvh();
+
+    // Build over the current geometry of 'model' (faces are fan-triangulated)
+    void build(const ObjLoader& model);
+    void clear();
+
+    // Closest hit along origin + t * direction, t >= 0
+    bool intersect(const Vec3& origin, const Vec3& direction, RayHit& hit) const;
+
+    // Getters
+    // False once the model's positions changed (blended or streamed frames)
+    bool isBuiltFor(const ObjLoader* model) const {
+        return source == model && model && sourceVersion == model->getVertexVersion() && !nodes.empty();
+    }
+    int getTriangleCount() const { return triangles.size(); }
+    int getNodeCount() const { return nodes.size(); }
+};
+
+#endif
@@ -0,0 +1,166 @@
+#include "DepthSorter.h"
+#include <chrono>
+#include <cstring>
+
+namespace {
+    // Monotonic mapping of IEEE floats to unsigned integers
+    inline uint32_t floatToKey(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+    }
+}
+
+DepthSorter::DepthSorter()
+    : coherence(true), lastIncremental(false), lastMoves(0), lastSortMs(0.0f) {
+}
+
+void DepthSorter::reset() {
+    order.clear();
+}
+
+const std::vector<int>& DepthSorter::sort(const std::vector<float>& depths) {
+    auto start = std::chrono::high_resolution_clock::now();
+
+    lastIncremental = false;
+    lastMoves = 0;
+    if (coherence && order.size() == depths.size() && repairOrder(depths)) {
+        lastIncremental = true;
+    }
+    else {
+        radixSort(depths);
+    }
+
+    lastSortMs = std::chrono::duration<float, std::milli>(
+        std::chrono::high_resolution_clock::now() - start).count();
+    return order;
+}
+
+bool DepthSorter::repairOrder(const std::vector<float>& depths) {
+    const int n = order.size();
+    if (n < 2) {
+        return true;
+    }
+
+    // The depth range sets the buckets
+    float minDepth = depths[0];
+    float maxDepth = minDepth;
+    for (int i = 0; i < n; i++) {
+        float depth = depths[i];
+        if (depth != depth) {
+            return false;  // NaN: only the radix sort orders it consistently
+        }
+        minDepth = depth < minDepth ? depth : minDepth;
+        maxDepth = depth > maxDepth ? depth : maxDepth;
+    }
+    float range = maxDepth - minDepth;
+    if (range == 0.0f) {
+        return true;
+    }
+    if (!(range < 3.0e38f)) {
+        return false;
+    }
+
+    // One counting pass into about one bucket per item, taken in the previous
+    // order: a small view change moves items by a few buckets at most, and the
+    // items sharing a bucket keep last frame's relative order, which is almost
+    // right. One scatter replaces the radix sort's three or four.
+    const int bucketCount = n;
+    const float scale = (bucketCount - 1) / range;
+    keys.resize(n);
+    tempOrder.resize(n);
+    orderedDepths.resize(n);
+    bucketStarts.assign(bucketCount + 1, 0);
+    int descents = 0;
+    float previous = minDepth;
+    for (int i = 0; i < n; i++) {
+        float depth = depths[order[i]];
+        descents += depth < previous;
+        previous = depth;
+        uint32_t bucket = (uint32_t)((depth - minDepth) * scale);
+        keys[i] = bucket;
+        bucketStarts[bucket + 1]++;
+    }
+    if (descents == 0) {
+        return true;  // Still sorted, e.g. the camera did not move
+    }
+    for (int b = 0; b < bucketCount; b++) {
+        bucketStarts[b + 1] += bucketStarts[b];
+    }
+    for (int i = 0; i < n; i++) {
+        int item = order[i];
+        uint32_t dst = bucketStarts[keys[i]]++;
+        tempOrder[dst] = item;
+        orderedDepths[dst] = depths[item];
+    }
+    order.swap(tempOrder);
+
+    // Insertion sort finishes the buckets; linear unless many items share one.
+    // Once it has moved more elements than a radix sort touches, the depths
+    // are too clustered and we bail out.
+    const int budget = 2 * n + 64;
+    for (int i = 1; i < n; i++) {
+        int item = order[i];
+        float depth = orderedDepths[i];
+        int j = i;
+        while (j > 0 && orderedDepths[j - 1] > depth) {
+            order[j] = order[j - 1];
+            orderedDepths[j] = orderedDepths[j - 1];
+            j--;
+            if (++lastMoves > budget) {
+                order[j] = item;  // Keep 'order' a permutation for the radix sort
+                return false;
+            }
+        }
+        order[j] = item;
+        orderedDepths[j] = depth;
+    }
+    return true;
+}
+
+void DepthSorter::radixSort(const std::vector<float>& depths) {
+    const int n = depths.size();
+    order.resize(n);
+    tempOrder.resize(n);
+    keys.resize(n);
+    tempKeys.resize(n);
+
+    // All four byte histograms in one pass over the keys
+    uint32_t histograms[4][256];
+    std::memset(histograms, 0, sizeof(histograms));
+    for (int i = 0; i < n; i++) {
+        uint32_t key = floatToKey(depths[i]);
+        keys[i] = key;
+        order[i] = i;
+        histograms[0][key & 0xFF]++;
+        histograms[1][(key >> 8) & 0xFF]++;
+        histograms[2][(key >> 16) & 0xFF]++;
+        histograms[3][key >> 24]++;
+    }
+
+    for (int pass = 0; pass < 4; pass++) {
+        uint32_t* histogram = histograms[pass];
+        int shift = pass * 8;
+
+        // A byte shared by every key does not reorder anything
+        if (n == 0 || histogram[(keys[0] >> shift) & 0xFF] == (uint32_t)n) {
+            continue;
+        }
+
+        uint32_t offset = 0;
+        for (int b = 0; b < 256; b++) {
+            uint32_t count = histogram[b];
+            histogram[b] = offset;
+            offset += count;
+        }
+
+        for (int i = 0; i < n; i++) {
+            uint32_t key = keys[i];
+            uint32_t dst = histogram[(key >> shift) & 0xFF]++;
+            tempKeys[dst] = key;
+            tempOrder[dst] = order[i];
+        }
+        keys.swap(tempKeys);
+        order.swap(tempOrder);
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef DEPTH_SORTER_H
+#define DEPTH_SORTER_H
+
+#include <vector>
+#include <cstdint>
+
+// Orders items by a float key (eye-space z for back-to-front blending).
+// Uses an LSD radix sort on the float bit patterns, O(n), and exploits frame
+// to frame coherence: the previous order is bucketed by depth in one pass and
+// finished with a bounded insertion sort, and the radix sort only runs when
+// that gives up.
+class DepthSorter {
+private:
+    std::vector<int> order;
+    std::vector<int> tempOrder;
+    std::vector<uint32_t> keys;
+    std::vector<uint32_t> tempKeys;
+    std::vector<uint32_t> bucketStarts;
+    std::vector<float> orderedDepths;
+    bool coherence;
+    bool lastIncremental;
+    int lastMoves;
+    float lastSortMs;
+
+    bool repairOrder(const std::vector<float>& depths);
+    void radixSort(const std::vector<float>& depths);
+
+public:
+    DepthSorter();
+
+    // Returns item indices with ascending depths[i]. With eye-space z (negative
+    // in front of the camera) that is farthest first.
+    const std::vector<int>& sort(const std::vector<float>& depths);
+    void reset();
+
+    void setCoherence(bool enabled) { coherence = enabled; }
+
+    // Getters
+    bool wasIncremental() const { return lastIncremental; }
+    int getLastMoves() const { return lastMoves; }
+    float getLastSortMs() const { return lastSortMs; }
+    const std::vector<int>& getOrder() const { return order; }
+};
+
+#endif
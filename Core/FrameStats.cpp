@@ -0,0 +1,100 @@
+#include "FrameStats.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+const float FrameStatsRecorder::kMaxFrameIntervalMs = 1000.0f;
+
+namespace {
+    double nowSeconds() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    FramePercentiles percentiles(std::vector<float>& values) {
+        FramePercentiles result;
+        if (values.empty()) {
+            return result;
+        }
+        std::sort(values.begin(), values.end());
+        size_t last = values.size() - 1;
+        result.p50Ms = values[last * 50 / 100];
+        result.p95Ms = values[last * 95 / 100];
+        result.p99Ms = values[last * 99 / 100];
+        result.samples = values.size();
+        return result;
+    }
+}
+
+FrameStatsRecorder::FrameStatsRecorder()
+    : nextSlot(0), frameCount(0), overlayVisible(false), startSeconds(nowSeconds()), lastFrameSeconds(-1.0) {
+    history.reserve(HISTORY);
+}
+
+FrameStatsRecorder::~FrameStatsRecorder() {
+    if (log.is_open()) {
+        log.close();
+    }
+}
+
+bool FrameStatsRecorder::openLog(const std::string& path) {
+    log.open(path.c_str());
+    if (!log.is_open()) {
+        std::cerr << "Warning: Cannot write frame log " << path << std::endl;
+        return false;
+    }
+    log << "frame,time_ms,interval_ms,cpu_ms,draw_calls,triangles,state_calls,state_filtered,"
+        << "objects_drawn,objects_culled,animation_frame\n";
+    return true;
+}
+
+float FrameStatsRecorder::beginFrame() {
+    double now = nowSeconds();
+    float interval = lastFrameSeconds < 0.0 ? 0.0f : (float)((now - lastFrameSeconds) * 1000.0);
+    lastFrameSeconds = now;
+    return interval;
+}
+
+void FrameStatsRecorder::record(const FrameRecord& frame) {
+    if ((int)history.size() < HISTORY) {
+        history.push_back(frame);
+    }
+    else {
+        history[nextSlot] = frame;
+    }
+    nextSlot = (nextSlot + 1) % HISTORY;
+
+    if (log.is_open()) {
+        log << frameCount << ',' << (lastFrameSeconds - startSeconds) * 1000.0 << ',' << frame.intervalMs << ','
+            << frame.cpuMs << ',' << frame.drawCalls << ',' << frame.trianglesDrawn << ',' << frame.stateCalls << ','
+            << frame.stateFiltered << ',' << frame.objectsDrawn << ',' << frame.objectsCulled << ','
+            << frame.animationFrame << '\n';
+    }
+    frameCount++;
+}
+
+const FrameRecord* FrameStatsRecorder::getLastFrame() const {
+    if (history.empty()) {
+        return nullptr;
+    }
+    return &history[(nextSlot + HISTORY - 1) % HISTORY];
+}
+
+FramePercentiles FrameStatsRecorder::getIntervalPercentiles() const {
+    std::vector<float> values;
+    values.reserve(history.size());
+    for (const FrameRecord& frame : history) {
+        if (frame.intervalMs > 0.0f && frame.intervalMs <= kMaxFrameIntervalMs) {
+            values.push_back(frame.intervalMs);
+        }
+    }
+    return percentiles(values);
+}
+
+FramePercentiles FrameStatsRecorder::getCpuPercentiles() const {
+    std::vector<float> values;
+    values.reserve(history.size());
+    for (const FrameRecord& frame : history) {
+        values.push_back(frame.cpuMs);
+    }
+    return percentiles(values);
+}
@@ -0,0 +1,72 @@
+#ifndef FRAME_STATS_H
+#define FRAME_STATS_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+// What one display() did. Filled by the viewer from the draw statistics of
+// ObjLoader / InstanceRenderer and the GL state cache.
+struct FrameRecord {
+    float intervalMs;       // Since the previous frame (0 for the first)
+    float cpuMs;            // CPU time of the frame up to (not including) the buffer swap
+    int drawCalls;
+    int trianglesDrawn;
+    int stateCalls;         // GL state calls that reached the driver
+    int stateFiltered;      // ... and those the state cache dropped
+    int objectsDrawn;
+    int objectsCulled;      // Frustum + occlusion
+    int animationFrame;     // -1 for static models
+    FrameRecord() : intervalMs(0.0f), cpuMs(0.0f), drawCalls(0), trianglesDrawn(0), stateCalls(0),
+                    stateFiltered(0), objectsDrawn(0), objectsCulled(0), animationFrame(-1) {}
+};
+
+struct FramePercentiles {
+    float p50Ms;
+    float p95Ms;
+    float p99Ms;
+    int samples;
+    FramePercentiles() : p50Ms(0.0f), p95Ms(0.0f), p99Ms(0.0f), samples(0) {}
+};
+
+// Keeps the last frames for the on-screen overlay and optionally appends
+// every frame to a CSV file. Inactive (overlay off, no log) it records
+// nothing, and the viewer skips collecting the numbers altogether.
+class FrameStatsRecorder {
+private:
+    enum { HISTORY = 240 };
+
+    std::vector<FrameRecord> history;   // Ring buffer
+    int nextSlot;
+    int frameCount;
+    bool overlayVisible;
+    std::ofstream log;
+    double startSeconds;
+    double lastFrameSeconds;
+
+public:
+    // Gaps longer than this are idle time between on-demand redraws, not frame time
+    static const float kMaxFrameIntervalMs;
+
+    FrameStatsRecorder();
+    ~FrameStatsRecorder();
+
+    bool openLog(const std::string& path);
+    bool isLogging() const { return log.is_open(); }
+
+    void setOverlayVisible(bool visible) { overlayVisible = visible; }
+    bool isOverlayVisible() const { return overlayVisible; }
+    bool isActive() const { return overlayVisible || log.is_open(); }
+
+    // Call at the start of a frame; returns the interval since the previous one
+    float beginFrame();
+    void record(const FrameRecord& frame);
+
+    const FrameRecord* getLastFrame() const;
+    int getFrameCount() const { return frameCount; }
+    // Over the frame intervals in the history (idle gaps excluded)
+    FramePercentiles getIntervalPercentiles() const;
+    FramePercentiles getCpuPercentiles() const;
+};
+
+#endif
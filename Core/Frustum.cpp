@@ -0,0 +1,63 @@
+#include "Frustum.h"
+#include <cmath>
+
+Frustum::Frustum() {
+    // Accept everything until extracted
+    for (int i = 0; i < 6; i++) {
+        planes[i][0] = planes[i][1] = planes[i][2] = 0.0f;
+        planes[i][3] = 1.0f;
+    }
+}
+
+void Frustum::extract(const float* modelview, const float* projection) {
+    // clip = projection * modelview (column-major: m[col * 4 + row])
+    float clip[16];
+    for (int col = 0; col < 4; col++) {
+        for (int row = 0; row < 4; row++) {
+            clip[col * 4 + row] =
+                projection[0 * 4 + row] * modelview[col * 4 + 0] +
+                projection[1 * 4 + row] * modelview[col * 4 + 1] +
+                projection[2 * 4 + row] * modelview[col * 4 + 2] +
+                projection[3 * 4 + row] * modelview[col * 4 + 3];
+        }
+    }
+
+    // Gribb/Hartmann: planes are row 3 +/- rows 0..2
+    for (int i = 0; i < 6; i++) {
+        int row = i / 2;
+        float sign = (i % 2 == 0) ? 1.0f : -1.0f;
+        for (int j = 0; j < 4; j++) {
+            planes[i][j] = clip[j * 4 + 3] + sign * clip[j * 4 + row];
+        }
+
+        float length = std::sqrt(planes[i][0] * planes[i][0] +
+                                 planes[i][1] * planes[i][1] +
+                                 planes[i][2] * planes[i][2]);
+        if (length > 0.0f) {
+            for (int j = 0; j < 4; j++) {
+                planes[i][j] /= length;
+            }
+        }
+    }
+}
+
+void Frustum::extractFromGL() {
+    float modelview[16];
+    float projection[16];
+    glGetFloatv(GL_MODELVIEW_MATRIX, modelview);
+    glGetFloatv(GL_PROJECTION_MATRIX, projection);
+    extract(modelview, projection);
+}
+
+bool Frustum::isBoxVisible(const Vec3& minBounds, const Vec3& maxBounds) const {
+    for (int i = 0; i < 6; i++) {
+        // Corner furthest along the plane normal; if it is outside, the whole box is
+        float x = planes[i][0] >= 0.0f ? maxBounds.x : minBounds.x;
+        float y = planes[i][1] >= 0.0f ? maxBounds.y : minBounds.y;
+        float z = planes[i][2] >= 0.0f ? maxBounds.z : minBounds.z;
+        if (planes[i][0] * x + planes[i][1] * y + planes[i][2] * z + planes[i][3] < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
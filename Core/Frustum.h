@@ -0,0 +1,24 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include "ObjLoader.h"
+
+// View frustum as six planes (ax + by + cz + d >= 0 is inside), extracted
+// from a combined projection * modelview matrix. When the modelview includes
+// the model transform the planes are in model space, so object AABBs from
+// the loader can be tested directly.
+class Frustum {
+private:
+    float planes[6][4];
+
+public:
+    Frustum();
+
+    // Column-major 4x4 matrices, as returned by glGetFloatv
+    void extract(const float* modelview, const float* projection);
+    void extractFromGL();
+
+    bool isBoxVisible(const Vec3& minBounds, const Vec3& maxBounds) const;
+};
+
+#endif
@@ -0,0 +1,210 @@
+#include "GLExtensions.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+GLGenBuffersProc extGenBuffers = nullptr;
+GLDeleteBuffersProc extDeleteBuffers = nullptr;
+GLBindBufferProc extBindBuffer = nullptr;
+GLBufferDataProc extBufferData = nullptr;
+
+GLGenFramebuffersProc extGenFramebuffers = nullptr;
+GLDeleteFramebuffersProc extDeleteFramebuffers = nullptr;
+GLBindFramebufferProc extBindFramebuffer = nullptr;
+GLCheckFramebufferStatusProc extCheckFramebufferStatus = nullptr;
+GLFramebufferRenderbufferProc extFramebufferRenderbuffer = nullptr;
+GLGenRenderbuffersProc extGenRenderbuffers = nullptr;
+GLDeleteRenderbuffersProc extDeleteRenderbuffers = nullptr;
+GLBindRenderbufferProc extBindRenderbuffer = nullptr;
+GLRenderbufferStorageProc extRenderbufferStorage = nullptr;
+
+GLCreateShaderProc extCreateShader = nullptr;
+GLShaderSourceProc extShaderSource = nullptr;
+GLCompileShaderProc extCompileShader = nullptr;
+GLGetShaderivProc extGetShaderiv = nullptr;
+GLGetShaderInfoLogProc extGetShaderInfoLog = nullptr;
+GLDeleteShaderProc extDeleteShader = nullptr;
+GLCreateProgramProc extCreateProgram = nullptr;
+GLAttachShaderProc extAttachShader = nullptr;
+GLLinkProgramProc extLinkProgram = nullptr;
+GLGetProgramivProc extGetProgramiv = nullptr;
+GLGetProgramInfoLogProc extGetProgramInfoLog = nullptr;
+GLUseProgramProc extUseProgram = nullptr;
+GLDeleteProgramProc extDeleteProgram = nullptr;
+GLGetUniformLocationProc extGetUniformLocation = nullptr;
+GLUniform1iProc extUniform1i = nullptr;
+GLUniform1ivProc extUniform1iv = nullptr;
+GLGetAttribLocationProc extGetAttribLocation = nullptr;
+GLVertexAttribPointerProc extVertexAttribPointer = nullptr;
+GLEnableVertexAttribArrayProc extEnableVertexAttribArray = nullptr;
+GLDisableVertexAttribArrayProc extDisableVertexAttribArray = nullptr;
+
+GLVertexAttribDivisorProc extVertexAttribDivisor = nullptr;
+GLDrawElementsInstancedProc extDrawElementsInstanced = nullptr;
+
+namespace {
+    bool versionAtLeast(int wantMajor, int wantMinor) {
+        const char* version = (const char*)glGetString(GL_VERSION);
+        int major = 0, minor = 0;
+        if (!version || sscanf(version, "%d.%d", &major, &minor) != 2) {
+            return false;
+        }
+        return major > wantMajor || (major == wantMajor && minor >= wantMinor);
+    }
+
+    bool hasExtension(const char* name) {
+        const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+        if (!extensions) {
+            return false;
+        }
+        // Match whole words only (some names are prefixes of others)
+        size_t length = strlen(name);
+        for (const char* p = strstr(extensions, name); p; p = strstr(p + length, name)) {
+            bool startOk = (p == extensions || p[-1] == ' ');
+            bool endOk = (p[length] == ' ' || p[length] == '\0');
+            if (startOk && endOk) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Core name first, then the vendor suffixed one ("ARB", "EXT" or none)
+    GLProc resolve(GLProcLoader loader, const char* name, const char* suffix) {
+        GLProc proc = loader(name);
+        if (!proc && suffix) {
+            proc = loader((std::string(name) + suffix).c_str());
+        }
+        return proc;
+    }
+}
+
+bool loadGLExtensions(GLProcLoader loader) {
+    extGenBuffers = nullptr;
+    extDeleteBuffers = nullptr;
+    extBindBuffer = nullptr;
+    extBufferData = nullptr;
+    extGenFramebuffers = nullptr;
+    extDeleteFramebuffers = nullptr;
+    extBindFramebuffer = nullptr;
+    extCheckFramebufferStatus = nullptr;
+    extFramebufferRenderbuffer = nullptr;
+    extGenRenderbuffers = nullptr;
+    extDeleteRenderbuffers = nullptr;
+    extBindRenderbuffer = nullptr;
+    extRenderbufferStorage = nullptr;
+    extCreateShader = nullptr;
+    extShaderSource = nullptr;
+    extCompileShader = nullptr;
+    extGetShaderiv = nullptr;
+    extGetShaderInfoLog = nullptr;
+    extDeleteShader = nullptr;
+    extCreateProgram = nullptr;
+    extAttachShader = nullptr;
+    extLinkProgram = nullptr;
+    extGetProgramiv = nullptr;
+    extGetProgramInfoLog = nullptr;
+    extUseProgram = nullptr;
+    extDeleteProgram = nullptr;
+    extGetUniformLocation = nullptr;
+    extUniform1i = nullptr;
+    extUniform1iv = nullptr;
+    extGetAttribLocation = nullptr;
+    extVertexAttribPointer = nullptr;
+    extEnableVertexAttribArray = nullptr;
+    extDisableVertexAttribArray = nullptr;
+    extVertexAttribDivisor = nullptr;
+    extDrawElementsInstanced = nullptr;
+
+    if (!loader) {
+        return false;
+    }
+
+    // Loaders may hand out stubs for unsupported functions, so check the context first
+    bool core = versionAtLeast(1, 5);
+    bool arb = hasExtension("GL_ARB_vertex_buffer_object");
+    if (core || arb) {
+        const char* suffix = core ? nullptr : "ARB";
+        extGenBuffers = (GLGenBuffersProc)resolve(loader, "glGenBuffers", suffix);
+        extDeleteBuffers = (GLDeleteBuffersProc)resolve(loader, "glDeleteBuffers", suffix);
+        extBindBuffer = (GLBindBufferProc)resolve(loader, "glBindBuffer", suffix);
+        extBufferData = (GLBufferDataProc)resolve(loader, "glBufferData", suffix);
+    }
+
+    // ARB_framebuffer_object uses the unsuffixed core names
+    bool fboCore = versionAtLeast(3, 0) || hasExtension("GL_ARB_framebuffer_object");
+    bool fboExt = hasExtension("GL_EXT_framebuffer_object");
+    if (fboCore || fboExt) {
+        const char* suffix = fboCore ? nullptr : "EXT";
+        extGenFramebuffers = (GLGenFramebuffersProc)resolve(loader, "glGenFramebuffers", suffix);
+        extDeleteFramebuffers = (GLDeleteFramebuffersProc)resolve(loader, "glDeleteFramebuffers", suffix);
+        extBindFramebuffer = (GLBindFramebufferProc)resolve(loader, "glBindFramebuffer", suffix);
+        extCheckFramebufferStatus = (GLCheckFramebufferStatusProc)resolve(loader, "glCheckFramebufferStatus", suffix);
+        extFramebufferRenderbuffer = (GLFramebufferRenderbufferProc)resolve(loader, "glFramebufferRenderbuffer", suffix);
+        extGenRenderbuffers = (GLGenRenderbuffersProc)resolve(loader, "glGenRenderbuffers", suffix);
+        extDeleteRenderbuffers = (GLDeleteRenderbuffersProc)resolve(loader, "glDeleteRenderbuffers", suffix);
+        extBindRenderbuffer = (GLBindRenderbufferProc)resolve(loader, "glBindRenderbuffer", suffix);
+        extRenderbufferStorage = (GLRenderbufferStorageProc)resolve(loader, "glRenderbufferStorage", suffix);
+    }
+
+    // Shaders only through the core 2.0 names (the ARB_shader_objects API differs)
+    if (versionAtLeast(2, 0)) {
+        extCreateShader = (GLCreateShaderProc)resolve(loader, "glCreateShader", nullptr);
+        extShaderSource = (GLShaderSourceProc)resolve(loader, "glShaderSource", nullptr);
+        extCompileShader = (GLCompileShaderProc)resolve(loader, "glCompileShader", nullptr);
+        extGetShaderiv = (GLGetShaderivProc)resolve(loader, "glGetShaderiv", nullptr);
+        extGetShaderInfoLog = (GLGetShaderInfoLogProc)resolve(loader, "glGetShaderInfoLog", nullptr);
+        extDeleteShader = (GLDeleteShaderProc)resolve(loader, "glDeleteShader", nullptr);
+        extCreateProgram = (GLCreateProgramProc)resolve(loader, "glCreateProgram", nullptr);
+        extAttachShader = (GLAttachShaderProc)resolve(loader, "glAttachShader", nullptr);
+        extLinkProgram = (GLLinkProgramProc)resolve(loader, "glLinkProgram", nullptr);
+        extGetProgramiv = (GLGetProgramivProc)resolve(loader, "glGetProgramiv", nullptr);
+        extGetProgramInfoLog = (GLGetProgramInfoLogProc)resolve(loader, "glGetProgramInfoLog", nullptr);
+        extUseProgram = (GLUseProgramProc)resolve(loader, "glUseProgram", nullptr);
+        extDeleteProgram = (GLDeleteProgramProc)resolve(loader, "glDeleteProgram", nullptr);
+        extGetUniformLocation = (GLGetUniformLocationProc)resolve(loader, "glGetUniformLocation", nullptr);
+        extUniform1i = (GLUniform1iProc)resolve(loader, "glUniform1i", nullptr);
+        extUniform1iv = (GLUniform1ivProc)resolve(loader, "glUniform1iv", nullptr);
+        extGetAttribLocation = (GLGetAttribLocationProc)resolve(loader, "glGetAttribLocation", nullptr);
+        extVertexAttribPointer = (GLVertexAttribPointerProc)resolve(loader, "glVertexAttribPointer", nullptr);
+        extEnableVertexAttribArray = (GLEnableVertexAttribArrayProc)resolve(loader, "glEnableVertexAttribArray", nullptr);
+        extDisableVertexAttribArray = (GLDisableVertexAttribArrayProc)resolve(loader, "glDisableVertexAttribArray", nullptr);
+    }
+
+    // Divisors: 3.3 or ARB_instanced_arrays; instanced draws: 3.1 or ARB_draw_instanced
+    bool divisorCore = versionAtLeast(3, 3);
+    if (divisorCore || hasExtension("GL_ARB_instanced_arrays")) {
+        extVertexAttribDivisor = (GLVertexAttribDivisorProc)resolve(
+            loader, "glVertexAttribDivisor", divisorCore ? nullptr : "ARB");
+    }
+    bool drawCore = versionAtLeast(3, 1);
+    if (drawCore || hasExtension("GL_ARB_draw_instanced")) {
+        extDrawElementsInstanced = (GLDrawElementsInstancedProc)resolve(
+            loader, "glDrawElementsInstanced", drawCore ? nullptr : "ARB");
+    }
+
+    return hasBufferObjects();
+}
+
+bool hasBufferObjects() {
+    return extGenBuffers && extDeleteBuffers && extBindBuffer && extBufferData;
+}
+
+bool hasFramebufferObjects() {
+    return extGenFramebuffers && extDeleteFramebuffers && extBindFramebuffer &&
+           extCheckFramebufferStatus && extFramebufferRenderbuffer && extGenRenderbuffers &&
+           extDeleteRenderbuffers && extBindRenderbuffer && extRenderbufferStorage;
+}
+
+bool hasShaders() {
+    return extCreateShader && extShaderSource && extCompileShader && extGetShaderiv &&
+           extGetShaderInfoLog && extDeleteShader && extCreateProgram && extAttachShader &&
+           extLinkProgram && extGetProgramiv && extGetProgramInfoLog && extUseProgram &&
+           extDeleteProgram && extGetUniformLocation && extUniform1i && extUniform1iv &&
+           extGetAttribLocation && extVertexAttribPointer && extEnableVertexAttribArray &&
+           extDisableVertexAttribArray;
+}
+
+bool hasInstancing() {
+    return hasShaders() && hasBufferObjects() && extVertexAttribDivisor && extDrawElementsInstanced;
+}
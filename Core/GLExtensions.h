@@ -0,0 +1,143 @@
+#ifndef GL_EXTENSIONS_H
+#define GL_EXTENSIONS_H
+
+#include <cstddef>
+#include <GL/glut.h>
+
+// Entry points beyond OpenGL 1.1 are not exported by opengl32.lib, so they are
+// resolved at runtime through the windowing layer (glutGetProcAddress in the
+// viewer, eglGetProcAddress in the headless benches). Call after a context
+// exists; every ext* pointer stays null if the feature is missing.
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER 0x8892
+#define GL_ELEMENT_ARRAY_BUFFER 0x8893
+#define GL_STATIC_DRAW 0x88E4
+#endif
+
+#ifndef GL_STREAM_DRAW
+#define GL_STREAM_DRAW 0x88E0
+#endif
+
+#ifndef GL_FRAMEBUFFER
+#define GL_FRAMEBUFFER 0x8D40
+#define GL_RENDERBUFFER 0x8D41
+#define GL_COLOR_ATTACHMENT0 0x8CE0
+#define GL_DEPTH_ATTACHMENT 0x8D00
+#define GL_FRAMEBUFFER_COMPLETE 0x8CD5
+#endif
+
+#ifndef GL_DEPTH_COMPONENT24
+#define GL_DEPTH_COMPONENT24 0x81A6
+#endif
+
+#ifndef GL_VERTEX_SHADER
+#define GL_FRAGMENT_SHADER 0x8B30
+#define GL_VERTEX_SHADER 0x8B31
+#define GL_COMPILE_STATUS 0x8B81
+#define GL_LINK_STATUS 0x8B82
+#define GL_INFO_LOG_LENGTH 0x8B84
+#define GL_VERTEX_PROGRAM_TWO_SIDE 0x8643
+#endif
+
+typedef void (*GLProc)();
+typedef GLProc (*GLProcLoader)(const char* name);
+
+typedef void (APIENTRY *GLGenBuffersProc)(GLsizei n, GLuint* buffers);
+typedef void (APIENTRY *GLDeleteBuffersProc)(GLsizei n, const GLuint* buffers);
+typedef void (APIENTRY *GLBindBufferProc)(GLenum target, GLuint buffer);
+typedef void (APIENTRY *GLBufferDataProc)(GLenum target, ptrdiff_t size, const void* data, GLenum usage);
+
+typedef void (APIENTRY *GLGenFramebuffersProc)(GLsizei n, GLuint* framebuffers);
+typedef void (APIENTRY *GLDeleteFramebuffersProc)(GLsizei n, const GLuint* framebuffers);
+typedef void (APIENTRY *GLBindFramebufferProc)(GLenum target, GLuint framebuffer);
+typedef GLenum (APIENTRY *GLCheckFramebufferStatusProc)(GLenum target);
+typedef void (APIENTRY *GLFramebufferRenderbufferProc)(GLenum target, GLenum attachment,
+                                                       GLenum renderbufferTarget, GLuint renderbuffer);
+typedef void (APIENTRY *GLGenRenderbuffersProc)(GLsizei n, GLuint* renderbuffers);
+typedef void (APIENTRY *GLDeleteRenderbuffersProc)(GLsizei n, const GLuint* renderbuffers);
+typedef void (APIENTRY *GLBindRenderbufferProc)(GLenum target, GLuint renderbuffer);
+typedef void (APIENTRY *GLRenderbufferStorageProc)(GLenum target, GLenum format, GLsizei width, GLsizei height);
+
+typedef GLuint (APIENTRY *GLCreateShaderProc)(GLenum type);
+typedef void (APIENTRY *GLShaderSourceProc)(GLuint shader, GLsizei count, const char* const* source, const GLint* length);
+typedef void (APIENTRY *GLCompileShaderProc)(GLuint shader);
+typedef void (APIENTRY *GLGetShaderivProc)(GLuint shader, GLenum name, GLint* value);
+typedef void (APIENTRY *GLGetShaderInfoLogProc)(GLuint shader, GLsizei size, GLsizei* length, char* log);
+typedef void (APIENTRY *GLDeleteShaderProc)(GLuint shader);
+typedef GLuint (APIENTRY *GLCreateProgramProc)();
+typedef void (APIENTRY *GLAttachShaderProc)(GLuint program, GLuint shader);
+typedef void (APIENTRY *GLLinkProgramProc)(GLuint program);
+typedef void (APIENTRY *GLGetProgramivProc)(GLuint program, GLenum name, GLint* value);
+typedef void (APIENTRY *GLGetProgramInfoLogProc)(GLuint program, GLsizei size, GLsizei* length, char* log);
+typedef void (APIENTRY *GLUseProgramProc)(GLuint program);
+typedef void (APIENTRY *GLDeleteProgramProc)(GLuint program);
+typedef GLint (APIENTRY *GLGetUniformLocationProc)(GLuint program, const char* name);
+typedef void (APIENTRY *GLUniform1iProc)(GLint location, GLint value);
+typedef void (APIENTRY *GLUniform1ivProc)(GLint location, GLsizei count, const GLint* values);
+typedef GLint (APIENTRY *GLGetAttribLocationProc)(GLuint program, const char* name);
+typedef void (APIENTRY *GLVertexAttribPointerProc)(GLuint index, GLint size, GLenum type, GLboolean normalized,
+                                                   GLsizei stride, const void* pointer);
+typedef void (APIENTRY *GLEnableVertexAttribArrayProc)(GLuint index);
+typedef void (APIENTRY *GLDisableVertexAttribArrayProc)(GLuint index);
+
+typedef void (APIENTRY *GLVertexAttribDivisorProc)(GLuint index, GLuint divisor);
+typedef void (APIENTRY *GLDrawElementsInstancedProc)(GLenum mode, GLsizei count, GLenum type,
+                                                     const void* indices, GLsizei instanceCount);
+
+// Vertex/index buffer objects (OpenGL 1.5 or GL_ARB_vertex_buffer_object)
+extern GLGenBuffersProc extGenBuffers;
+extern GLDeleteBuffersProc extDeleteBuffers;
+extern GLBindBufferProc extBindBuffer;
+extern GLBufferDataProc extBufferData;
+
+// Offscreen render targets (OpenGL 3.0, GL_ARB_framebuffer_object or GL_EXT_framebuffer_object)
+extern GLGenFramebuffersProc extGenFramebuffers;
+extern GLDeleteFramebuffersProc extDeleteFramebuffers;
+extern GLBindFramebufferProc extBindFramebuffer;
+extern GLCheckFramebufferStatusProc extCheckFramebufferStatus;
+extern GLFramebufferRenderbufferProc extFramebufferRenderbuffer;
+extern GLGenRenderbuffersProc extGenRenderbuffers;
+extern GLDeleteRenderbuffersProc extDeleteRenderbuffers;
+extern GLBindRenderbufferProc extBindRenderbuffer;
+extern GLRenderbufferStorageProc extRenderbufferStorage;
+
+// GLSL programs (OpenGL 2.0)
+extern GLCreateShaderProc extCreateShader;
+extern GLShaderSourceProc extShaderSource;
+extern GLCompileShaderProc extCompileShader;
+extern GLGetShaderivProc extGetShaderiv;
+extern GLGetShaderInfoLogProc extGetShaderInfoLog;
+extern GLDeleteShaderProc extDeleteShader;
+extern GLCreateProgramProc extCreateProgram;
+extern GLAttachShaderProc extAttachShader;
+extern GLLinkProgramProc extLinkProgram;
+extern GLGetProgramivProc extGetProgramiv;
+extern GLGetProgramInfoLogProc extGetProgramInfoLog;
+extern GLUseProgramProc extUseProgram;
+extern GLDeleteProgramProc extDeleteProgram;
+extern GLGetUniformLocationProc extGetUniformLocation;
+extern GLUniform1iProc extUniform1i;
+extern GLUniform1ivProc extUniform1iv;
+extern GLGetAttribLocationProc extGetAttribLocation;
+extern GLVertexAttribPointerProc extVertexAttribPointer;
+extern GLEnableVertexAttribArrayProc extEnableVertexAttribArray;
+extern GLDisableVertexAttribArrayProc extDisableVertexAttribArray;
+
+// Instanced drawing (OpenGL 3.3, or GL_ARB_instanced_arrays + GL_ARB_draw_instanced)
+extern GLVertexAttribDivisorProc extVertexAttribDivisor;
+extern GLDrawElementsInstancedProc extDrawElementsInstanced;
+
+// Resolves all entry points the current context supports; returns false if
+// the context has no buffer objects
+bool loadGLExtensions(GLProcLoader loader);
+bool hasBufferObjects();
+bool hasFramebufferObjects();
+bool hasShaders();
+bool hasInstancing();
+
+#endif
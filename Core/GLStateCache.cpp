@@ -0,0 +1,237 @@
+#include "GLStateCache.h"
+#include "GLExtensions.h"
+#include <cstring>
+
+GLStateCache glState;
+
+namespace {
+    const GLenum kCachedCaps[] = {
+        GL_LIGHTING, GL_LIGHT0, GL_LIGHT1, GL_LIGHT2, GL_LIGHT3, GL_LIGHT4, GL_LIGHT5, GL_LIGHT6, GL_LIGHT7,
+        GL_TEXTURE_2D, GL_BLEND, GL_DEPTH_TEST, GL_COLOR_MATERIAL, GL_CULL_FACE, GL_NORMALIZE,
+        GL_VERTEX_PROGRAM_TWO_SIDE
+    };
+    const int kColorMaterialSlot = 12;
+
+    int materialVectorSlot(GLenum pname) {
+        switch (pname) {
+        case GL_AMBIENT: return 0;
+        case GL_DIFFUSE: return 1;
+        case GL_SPECULAR: return 2;
+        case GL_EMISSION: return 3;
+        default: return -1;
+        }
+    }
+
+    int lightVectorSlot(GLenum pname) {
+        switch (pname) {
+        case GL_AMBIENT: return 0;
+        case GL_DIFFUSE: return 1;
+        case GL_SPECULAR: return 2;
+        default: return -1;
+        }
+    }
+
+    int lightScalarSlot(GLenum pname) {
+        switch (pname) {
+        case GL_SPOT_CUTOFF: return 0;
+        case GL_SPOT_EXPONENT: return 1;
+        case GL_CONSTANT_ATTENUATION: return 2;
+        case GL_LINEAR_ATTENUATION: return 3;
+        case GL_QUADRATIC_ATTENUATION: return 4;
+        default: return -1;
+        }
+    }
+}
+
+GLStateCache::GLStateCache() {
+    invalidate();
+}
+
+void GLStateCache::invalidate() {
+    std::memset(caps, -1, sizeof(caps));
+    for (int i = 0; i < MATERIAL_VECTOR_COUNT; i++) {
+        materialVectors[i].known = false;
+    }
+    materialShininess.known = false;
+    for (int light = 0; light < MAX_LIGHTS; light++) {
+        for (int i = 0; i < LIGHT_VECTOR_COUNT; i++) lightVectors[light][i].known = false;
+        for (int i = 0; i < LIGHT_SCALAR_COUNT; i++) lightScalars[light][i].known = false;
+    }
+    globalAmbient.known = false;
+    textureKnown = false;
+    boundTexture = 0;
+    blendFuncKnown = false;
+    blendSource = GL_ONE;
+    blendDestination = GL_ZERO;
+    depthWrites = -1;
+    polygonModeKnown = false;
+    polygonModeValue = GL_FILL;
+}
+
+int GLStateCache::capSlot(GLenum cap) {
+    for (int i = 0; i < CAP_COUNT; i++) {
+        if (kCachedCaps[i] == cap) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// True if the value changed (and was stored); counts the call either way
+bool GLStateCache::update(Vec4Entry& entry, const GLfloat* value) {
+    if (entry.known && std::memcmp(entry.value, value, sizeof(entry.value)) == 0) {
+        stats.filtered++;
+        return false;
+    }
+    entry.known = true;
+    std::memcpy(entry.value, value, sizeof(entry.value));
+    stats.issued++;
+    return true;
+}
+
+bool GLStateCache::update(ScalarEntry& entry, GLfloat value) {
+    if (entry.known && entry.value == value) {
+        stats.filtered++;
+        return false;
+    }
+    entry.known = true;
+    entry.value = value;
+    stats.issued++;
+    return true;
+}
+
+void GLStateCache::setEnabled(GLenum cap, bool enabled) {
+    int slot = capSlot(cap);
+    if (slot >= 0 && caps[slot] == (enabled ? 1 : 0)) {
+        stats.filtered++;
+        return;
+    }
+    if (slot >= 0) {
+        caps[slot] = enabled ? 1 : 0;
+    }
+    stats.issued++;
+    if (enabled) glEnable(cap);
+    else glDisable(cap);
+}
+
+bool GLStateCache::isEnabled(GLenum cap) {
+    int slot = capSlot(cap);
+    if (slot >= 0 && caps[slot] >= 0) {
+        return caps[slot] == 1;
+    }
+    bool enabled = glIsEnabled(cap) == GL_TRUE;
+    if (slot >= 0) {
+        caps[slot] = enabled ? 1 : 0;
+    }
+    return enabled;
+}
+
+void GLStateCache::materialfv(GLenum face, GLenum pname, const GLfloat* params) {
+    if (pname == GL_SHININESS) {
+        materialf(face, pname, params[0]);
+        return;
+    }
+
+    // With GL_COLOR_MATERIAL on, glColor rewrites the material behind our back
+    int slot = materialVectorSlot(pname);
+    if (face != GL_FRONT_AND_BACK || slot < 0 || caps[kColorMaterialSlot] != 0) {
+        for (int i = 0; i < MATERIAL_VECTOR_COUNT; i++) {
+            materialVectors[i].known = false;
+        }
+        stats.issued++;
+        glMaterialfv(face, pname, params);
+        return;
+    }
+    if (update(materialVectors[slot], params)) {
+        glMaterialfv(face, pname, params);
+    }
+}
+
+void GLStateCache::materialf(GLenum face, GLenum pname, GLfloat param) {
+    if (face != GL_FRONT_AND_BACK || pname != GL_SHININESS) {
+        materialShininess.known = false;
+        stats.issued++;
+        glMaterialf(face, pname, param);
+        return;
+    }
+    if (update(materialShininess, param)) {
+        glMaterialf(face, pname, param);
+    }
+}
+
+void GLStateCache::lightfv(GLenum light, GLenum pname, const GLfloat* params) {
+    int index = light - GL_LIGHT0;
+    int slot = lightVectorSlot(pname);
+    if (index < 0 || index >= MAX_LIGHTS || slot < 0) {
+        // Positions and spot directions depend on the current modelview
+        stats.issued++;
+        glLightfv(light, pname, params);
+        return;
+    }
+    if (update(lightVectors[index][slot], params)) {
+        glLightfv(light, pname, params);
+    }
+}
+
+void GLStateCache::lightf(GLenum light, GLenum pname, GLfloat param) {
+    int index = light - GL_LIGHT0;
+    int slot = lightScalarSlot(pname);
+    if (index < 0 || index >= MAX_LIGHTS || slot < 0) {
+        stats.issued++;
+        glLightf(light, pname, param);
+        return;
+    }
+    if (update(lightScalars[index][slot], param)) {
+        glLightf(light, pname, param);
+    }
+}
+
+void GLStateCache::lightModelAmbient(const GLfloat* color) {
+    if (update(globalAmbient, color)) {
+        glLightModelfv(GL_LIGHT_MODEL_AMBIENT, color);
+    }
+}
+
+void GLStateCache::bindTexture(GLuint texture) {
+    if (textureKnown && boundTexture == texture) {
+        stats.filtered++;
+        return;
+    }
+    textureKnown = true;
+    boundTexture = texture;
+    stats.issued++;
+    glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+void GLStateCache::blendFunc(GLenum source, GLenum destination) {
+    if (blendFuncKnown && blendSource == source && blendDestination == destination) {
+        stats.filtered++;
+        return;
+    }
+    blendFuncKnown = true;
+    blendSource = source;
+    blendDestination = destination;
+    stats.issued++;
+    glBlendFunc(source, destination);
+}
+
+void GLStateCache::depthMask(GLboolean write) {
+    if (depthWrites == (write ? 1 : 0)) {
+        stats.filtered++;
+        return;
+    }
+    depthWrites = write ? 1 : 0;
+    stats.issued++;
+    glDepthMask(write);
+}
+
+void GLStateCache::polygonMode(GLenum mode) {
+    if (polygonModeKnown && polygonModeValue == mode) {
+        stats.filtered++;
+        return;
+    }
+    polygonModeKnown = true;
+    polygonModeValue = mode;
+    stats.issued++;
+    glPolygonMode(GL_FRONT_AND_BACK, mode);
+}
@@ -0,0 +1,89 @@
+#ifndef GL_STATE_CACHE_H
+#define GL_STATE_CACHE_H
+
+#include <GL/glut.h>
+
+struct GLStateStats {
+    int issued;     // Calls passed on to GL
+    int filtered;   // Calls dropped because GL already had that value
+    GLStateStats() : issued(0), filtered(0) {}
+};
+
+// Shadow copy of the fixed-function state the viewer sets every frame
+// (capabilities, materials, light parameters, texture binding, blending,
+// depth writes). Setting a value GL already has is dropped and counted.
+// Entries start unknown, so the first call always reaches GL; code that
+// changes state behind the cache's back must call invalidate() afterwards.
+// Light positions and spot directions are always issued because GL
+// transforms them by the modelview current at the time of the call.
+// One instance per context (glState); not thread-safe.
+class GLStateCache {
+private:
+    enum {
+        MAX_LIGHTS = 8,
+        CAP_COUNT = 16,
+        LIGHT_VECTOR_COUNT = 3,   // Ambient, diffuse, specular
+        LIGHT_SCALAR_COUNT = 5,   // Spot cutoff/exponent, 3 attenuation factors
+        MATERIAL_VECTOR_COUNT = 4 // Ambient, diffuse, specular, emission
+    };
+
+    struct Vec4Entry {
+        bool known;
+        float value[4];
+    };
+
+    struct ScalarEntry {
+        bool known;
+        float value;
+    };
+
+    signed char caps[CAP_COUNT];            // -1 unknown, 0 disabled, 1 enabled
+    Vec4Entry materialVectors[MATERIAL_VECTOR_COUNT];
+    ScalarEntry materialShininess;
+    Vec4Entry lightVectors[MAX_LIGHTS][LIGHT_VECTOR_COUNT];
+    ScalarEntry lightScalars[MAX_LIGHTS][LIGHT_SCALAR_COUNT];
+    Vec4Entry globalAmbient;
+    bool textureKnown;
+    GLuint boundTexture;
+    bool blendFuncKnown;
+    GLenum blendSource;
+    GLenum blendDestination;
+    signed char depthWrites;                // -1 unknown
+    bool polygonModeKnown;
+    GLenum polygonModeValue;
+    GLStateStats stats;
+
+    static int capSlot(GLenum cap);
+    bool update(Vec4Entry& entry, const GLfloat* value);
+    bool update(ScalarEntry& entry, GLfloat value);
+
+public:
+    GLStateCache();
+
+    // Forget everything; the next call of each kind reaches GL again
+    void invalidate();
+
+    void enable(GLenum cap) { setEnabled(cap, true); }
+    void disable(GLenum cap) { setEnabled(cap, false); }
+    void setEnabled(GLenum cap, bool enabled);
+    // Answers from the cache when known, otherwise asks GL
+    bool isEnabled(GLenum cap);
+
+    void materialfv(GLenum face, GLenum pname, const GLfloat* params);
+    void materialf(GLenum face, GLenum pname, GLfloat param);
+    void lightfv(GLenum light, GLenum pname, const GLfloat* params);
+    void lightf(GLenum light, GLenum pname, GLfloat param);
+    void lightModelAmbient(const GLfloat* color);
+    void bindTexture(GLuint texture);       // GL_TEXTURE_2D
+    void blendFunc(GLenum source, GLenum destination);
+    void depthMask(GLboolean write);
+    void polygonMode(GLenum mode);          // GL_FRONT_AND_BACK
+
+    // Counted since the last resetStats() (the viewer resets once per frame)
+    const GLStateStats& getStats() const { return stats; }
+    void resetStats() { stats = GLStateStats(); }
+};
+
+extern GLStateCache glState;
+
+#endif
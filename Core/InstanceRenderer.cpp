@@ -0,0 +1,580 @@
+#include "InstanceRenderer.h"
+#include "GLStateCache.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+
+namespace {
+    const int kMaxLights = 8;
+
+    // Fixed-function lighting (local viewer, two-sided, attenuation, spotlights)
+    // per vertex, with the instance matrix read from per-instance attributes.
+    // One addLight() call per enabled light is spliced in at LIGHTS.
+    const char* kVertexShader =
+        "#version 120\n"
+        "attribute vec4 instanceColumn0;\n"
+        "attribute vec4 instanceColumn1;\n"
+        "attribute vec4 instanceColumn2;\n"
+        "attribute vec4 instanceColumn3;\n"
+        "uniform bool lighting;\n"
+        "\n"
+        "void addLight(int i, vec3 position, vec3 normal, vec3 viewDir, inout vec4 front, inout vec4 back) {\n"
+        "    vec3 toLight = normalize(gl_LightSource[i].position.xyz);\n"
+        "    float attenuation = 1.0;\n"
+        "    if (gl_LightSource[i].position.w != 0.0) {\n"
+        "        vec3 delta = gl_LightSource[i].position.xyz - position;\n"
+        "        float d = length(delta);\n"
+        "        toLight = delta / d;\n"
+        "        attenuation = 1.0 / (gl_LightSource[i].constantAttenuation +\n"
+        "                             gl_LightSource[i].linearAttenuation * d +\n"
+        "                             gl_LightSource[i].quadraticAttenuation * d * d);\n"
+        "        if (gl_LightSource[i].spotCutoff <= 90.0) {\n"
+        "            float spotCos = dot(-toLight, normalize(gl_LightSource[i].spotDirection));\n"
+        "            attenuation *= spotCos < gl_LightSource[i].spotCosCutoff ? 0.0 :\n"
+        "                           pow(spotCos, gl_LightSource[i].spotExponent);\n"
+        "        }\n"
+        "    }\n"
+        "    float facing = dot(normal, toLight);\n"
+        "    float halfFacing = dot(normal, normalize(toLight + viewDir));\n"
+        "    vec4 ambient = gl_FrontLightProduct[i].ambient;\n"
+        "    vec4 diffuse = gl_FrontLightProduct[i].diffuse;\n"
+        "    vec4 specular = gl_FrontLightProduct[i].specular;\n"
+        "    float shininess = gl_FrontMaterial.shininess;\n"
+        "    front += attenuation * (ambient + max(facing, 0.0) * diffuse +\n"
+        "             (facing > 0.0 ? pow(max(halfFacing, 0.0), shininess) : 0.0) * specular);\n"
+        "    back += attenuation * (ambient + max(-facing, 0.0) * diffuse +\n"
+        "            (facing < 0.0 ? pow(max(-halfFacing, 0.0), shininess) : 0.0) * specular);\n"
+        "}\n"
+        "\n"
+        "void main() {\n"
+        "    mat4 instance = mat4(instanceColumn0, instanceColumn1, instanceColumn2, instanceColumn3);\n"
+        "    vec4 position = gl_ModelViewMatrix * (instance * gl_Vertex);\n"
+        "    if (lighting) {\n"
+        "        vec3 normal = normalize(gl_NormalMatrix * (mat3(instance) * gl_Normal));\n"
+        "        vec3 viewDir = normalize(-position.xyz);\n"
+        "        vec4 front = gl_FrontLightModelProduct.sceneColor;\n"
+        "        vec4 back = front;\n"
+        "LIGHTS"
+        "        gl_FrontColor = vec4(clamp(front.rgb, 0.0, 1.0), gl_FrontMaterial.diffuse.a);\n"
+        "        gl_BackColor = vec4(clamp(back.rgb, 0.0, 1.0), gl_FrontMaterial.diffuse.a);\n"
+        "    }\n"
+        "    else {\n"
+        "        gl_FrontColor = gl_Color;\n"
+        "        gl_BackColor = gl_Color;\n"
+        "    }\n"
+        "    gl_TexCoord[0] = gl_MultiTexCoord0;\n"
+        "    gl_Position = gl_ProjectionMatrix * position;\n"
+        "}\n";
+
+    const char* kFragmentShader =
+        "#version 120\n"
+        "uniform bool useTexture;\n"
+        "uniform sampler2D diffuseMap;\n"
+        "void main() {\n"
+        "    vec4 color = gl_Color;\n"
+        "    if (useTexture) color *= texture2D(diffuseMap, gl_TexCoord[0].st);\n"
+        "    gl_FragColor = color;\n"
+        "}\n";
+
+    GLuint compileShader(GLenum type, const char* source) {
+        GLuint shader = extCreateShader(type);
+        extShaderSource(shader, 1, &source, nullptr);
+        extCompileShader(shader);
+
+        GLint ok = 0;
+        extGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+        if (!ok) {
+            char log[1024];
+            extGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+            std::cerr << "Warning: Instancing shader failed to compile: " << log << std::endl;
+            extDeleteShader(shader);
+            return 0;
+        }
+        return shader;
+    }
+
+    // out = transform * scale(s) * translate(-center), all column-major
+    void composeModelMatrix(const float* t, const Vec3& center, float s, float* out) {
+        for (int i = 0; i < 12; i++) {
+            out[i] = t[i] * s;
+        }
+        for (int row = 0; row < 4; row++) {
+            out[12 + row] = t[12 + row] - s * (center.x * t[row] + center.y * t[4 + row] + center.z * t[8 + row]);
+        }
+    }
+}
+
+ModelInstance::ModelInstance() : materialOverride(nullptr) {
+    for (int i = 0; i < 16; i++) {
+        transform[i] = (i % 5 == 0) ? 1.0f : 0.0f;
+    }
+}
+
+InstanceRenderer::InstanceRenderer()
+    : model(nullptr), instancesDirty(true), requestedMode(MODE_HARDWARE), activeMode(MODE_HARDWARE),
+      program(0), programLightMask(0), instanceBuffer(0), lightingUniform(-1),
+      useTextureUniform(-1), hardwareFailed(false), batchVertexBuffer(0), batchIndexBuffer(0) {
+    for (int i = 0; i < 4; i++) {
+        instanceAttributes[i] = -1;
+    }
+}
+
+InstanceRenderer::~InstanceRenderer() {
+    releaseBatches();
+    if (instanceBuffer != 0) {
+        extDeleteBuffers(1, &instanceBuffer);
+    }
+    if (program != 0) {
+        extDeleteProgram(program);
+    }
+}
+
+void InstanceRenderer::setModel(ObjLoader* newModel) {
+    model = newModel;
+    meshBuffers.release();
+    weldedMesh.clear();
+    instancesDirty = true;
+}
+
+void InstanceRenderer::clearInstances() {
+    instances.clear();
+    instancesDirty = true;
+}
+
+void InstanceRenderer::addInstance(const ModelInstance& instance) {
+    instances.push_back(instance);
+    instancesDirty = true;
+}
+
+void InstanceRenderer::addGrid(int count, float spacing, float instanceScale, const Material* override,
+                               int overrideEvery) {
+    int columns = std::max(1, (int)std::ceil(std::sqrt((float)count)));
+    float offset = (columns - 1) * spacing * 0.5f;
+
+    for (int i = 0; i < count; i++) {
+        // Quarter turns so neighbours do not all face the same way
+        float angle = (i % 4) * 1.5707963f;
+        float c = std::cos(angle) * instanceScale;
+        float s = std::sin(angle) * instanceScale;
+
+        ModelInstance instance;
+        instance.transform[0] = c;   instance.transform[2] = -s;
+        instance.transform[5] = instanceScale;
+        instance.transform[8] = s;   instance.transform[10] = c;
+        instance.transform[12] = (i % columns) * spacing - offset;
+        instance.transform[14] = (i / columns) * spacing - offset;
+        if (override && overrideEvery > 0 && i % overrideEvery == 0) {
+            instance.materialOverride = override;
+        }
+        addInstance(instance);
+    }
+}
+
+void InstanceRenderer::setMode(Mode mode) {
+    requestedMode = mode;
+    instancesDirty = true;
+}
+
+const char* InstanceRenderer::getModeName(Mode mode) {
+    switch (mode) {
+    case MODE_HARDWARE: return "hardware instancing";
+    case MODE_BATCHED: return "batched";
+    default: return "per instance";
+    }
+}
+
+void InstanceRenderer::buildGroups() {
+    std::stable_sort(instances.begin(), instances.end(),
+                     [](const ModelInstance& a, const ModelInstance& b) {
+                         return std::less<const Material*>()(a.materialOverride, b.materialOverride);
+                     });
+
+    groups.clear();
+    for (size_t i = 0; i < instances.size(); i++) {
+        if (groups.empty() || groups.back().materialOverride != instances[i].materialOverride) {
+            Group group;
+            group.materialOverride = instances[i].materialOverride;
+            group.firstInstance = i;
+            group.instanceCount = 0;
+            groups.push_back(group);
+        }
+        groups.back().instanceCount++;
+    }
+}
+
+int InstanceRenderer::getEnabledLightMask() {
+    int mask = 0;
+    for (int i = 0; i < kMaxLights; i++) {
+        if (glState.isEnabled(GL_LIGHT0 + i)) {
+            mask |= 1 << i;
+        }
+    }
+    return mask;
+}
+
+bool InstanceRenderer::buildProgram(int lightMask) {
+    if (program != 0 && lightMask == programLightMask) {
+        return true;
+    }
+    if (program != 0) {
+        extDeleteProgram(program);
+        program = 0;
+    }
+
+    // Unrolled over the enabled lights only, like the drivers' own fixed-function shaders
+    std::string lights;
+    for (int i = 0; i < kMaxLights; i++) {
+        if (lightMask & (1 << i)) {
+            lights += "        addLight(" + std::to_string(i) + ", position.xyz, normal, viewDir, front, back);\n";
+        }
+    }
+    std::string vertexSource = kVertexShader;
+    vertexSource.replace(vertexSource.find("LIGHTS"), 6, lights);
+
+    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource.c_str());
+    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, kFragmentShader);
+    if (vertexShader == 0 || fragmentShader == 0) {
+        if (vertexShader) extDeleteShader(vertexShader);
+        if (fragmentShader) extDeleteShader(fragmentShader);
+        hardwareFailed = true;
+        return false;
+    }
+
+    program = extCreateProgram();
+    extAttachShader(program, vertexShader);
+    extAttachShader(program, fragmentShader);
+    extLinkProgram(program);
+    extDeleteShader(vertexShader);
+    extDeleteShader(fragmentShader);
+
+    GLint ok = 0;
+    extGetProgramiv(program, GL_LINK_STATUS, &ok);
+    if (!ok) {
+        char log[1024];
+        extGetProgramInfoLog(program, sizeof(log), nullptr, log);
+        std::cerr << "Warning: Instancing shader failed to link: " << log << std::endl;
+        extDeleteProgram(program);
+        program = 0;
+        hardwareFailed = true;
+        return false;
+    }
+
+    const char* columns[4] = { "instanceColumn0", "instanceColumn1", "instanceColumn2", "instanceColumn3" };
+    for (int i = 0; i < 4; i++) {
+        instanceAttributes[i] = extGetAttribLocation(program, columns[i]);
+    }
+    lightingUniform = extGetUniformLocation(program, "lighting");
+    useTextureUniform = extGetUniformLocation(program, "useTexture");
+    programLightMask = lightMask;
+    return true;
+}
+
+bool InstanceRenderer::prepareHardware() {
+    if (hardwareFailed || !hasInstancing() || !buildProgram(getEnabledLightMask())) {
+        return false;
+    }
+    if (!meshBuffers.isBuilt() && !meshBuffers.build(*model)) {
+        return false;
+    }
+    if (instanceBuffer == 0) {
+        extGenBuffers(1, &instanceBuffer);
+    }
+    return true;
+}
+
+void InstanceRenderer::uploadInstances() {
+    std::vector<float> matrices(instances.size() * 16);
+    for (size_t i = 0; i < instances.size(); i++) {
+        composeModelMatrix(instances[i].transform, model->getCenter(), model->getScale(), &matrices[i * 16]);
+    }
+
+    extBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    extBufferData(GL_ARRAY_BUFFER, matrices.size() * sizeof(float),
+                  matrices.empty() ? nullptr : &matrices[0], GL_STATIC_DRAW);
+    extBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void InstanceRenderer::releaseBatches() {
+    if (batchVertexBuffer != 0) {
+        extDeleteBuffers(1, &batchVertexBuffer);
+        extDeleteBuffers(1, &batchIndexBuffer);
+    }
+    batchVertexBuffer = 0;
+    batchIndexBuffer = 0;
+    batchVertices.clear();
+    batchIndices.clear();
+    batches.clear();
+}
+
+void InstanceRenderer::buildBatches() {
+    releaseBatches();
+    if (weldedMesh.vertices.empty()) {
+        weldedMesh.build(*model);
+    }
+
+    const std::vector<DrawRange>& ranges = model->getDrawRanges();
+
+    // Effective material -> (instance, range) pairs; opaque and transparent kept apart
+    typedef std::pair<bool, const Material*> BatchKey;
+    std::map<BatchKey, std::vector<std::pair<int, int> > > buckets;
+    for (const Group& group : groups) {
+        for (size_t r = 0; r < ranges.size(); r++) {
+            const Material* material = group.materialOverride ? group.materialOverride : ranges[r].material;
+            bool transparent = material ? material->transparency < 1.0f : false;
+            std::vector<std::pair<int, int> >& bucket = buckets[BatchKey(transparent, material)];
+            for (int i = group.firstInstance; i < group.firstInstance + group.instanceCount; i++) {
+                bucket.push_back(std::make_pair(i, (int)r));
+            }
+        }
+    }
+
+    // Each (instance, range) copies only the vertices its indices reference
+    std::vector<int> remap(weldedMesh.vertices.size(), -1);
+    std::vector<int> remapStamp(weldedMesh.vertices.size(), -1);
+    int stamp = 0;
+    float matrix[16];
+
+    for (auto& bucket : buckets) {
+        Batch batch;
+        batch.transparent = bucket.first.first;
+        batch.material = bucket.first.second;
+        batch.firstIndex = batchIndices.size();
+
+        for (const std::pair<int, int>& item : bucket.second) {
+            composeModelMatrix(instances[item.first].transform, model->getCenter(), model->getScale(), matrix);
+            const IndexRange& range = weldedMesh.ranges[item.second];
+            stamp++;
+
+            for (int k = range.firstIndex; k < range.firstIndex + range.indexCount; k++) {
+                GLuint source = weldedMesh.indices[k];
+                if (remapStamp[source] != stamp) {
+                    remapStamp[source] = stamp;
+                    remap[source] = batchVertices.size();
+
+                    const BufferVertex& v = weldedMesh.vertices[source];
+                    BufferVertex out = v;
+                    for (int row = 0; row < 3; row++) {
+                        out.position[row] = matrix[row] * v.position[0] + matrix[4 + row] * v.position[1] +
+                                            matrix[8 + row] * v.position[2] + matrix[12 + row];
+                        out.normal[row] = matrix[row] * v.normal[0] + matrix[4 + row] * v.normal[1] +
+                                          matrix[8 + row] * v.normal[2];
+                    }
+                    batchVertices.push_back(out);
+                }
+                batchIndices.push_back(remap[source]);
+            }
+        }
+
+        batch.indexCount = batchIndices.size() - batch.firstIndex;
+        if (batch.indexCount > 0) {
+            batches.push_back(batch);
+        }
+    }
+
+    // Upload when buffer objects exist, otherwise draw from client memory
+    if (hasBufferObjects() && !batchIndices.empty()) {
+        extGenBuffers(1, &batchVertexBuffer);
+        extGenBuffers(1, &batchIndexBuffer);
+        extBindBuffer(GL_ARRAY_BUFFER, batchVertexBuffer);
+        extBufferData(GL_ARRAY_BUFFER, batchVertices.size() * sizeof(BufferVertex), &batchVertices[0], GL_STATIC_DRAW);
+        extBindBuffer(GL_ARRAY_BUFFER, 0);
+        extBindBuffer(GL_ELEMENT_ARRAY_BUFFER, batchIndexBuffer);
+        extBufferData(GL_ELEMENT_ARRAY_BUFFER, batchIndices.size() * sizeof(GLuint), &batchIndices[0], GL_STATIC_DRAW);
+        extBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+        std::vector<BufferVertex>().swap(batchVertices);
+        std::vector<GLuint>().swap(batchIndices);
+    }
+}
+
+void InstanceRenderer::bindMaterial(const Material* material, const Material*& bound) {
+    // Ranges without an .mtl entry keep the previous state, as in drawWithMaterials()
+    if (!material || material == bound) {
+        return;
+    }
+    bound = material;
+    model->applyMaterial(*material);
+    if (activeMode == MODE_HARDWARE) {
+        extUniform1i(useTextureUniform, material->textureID != 0);
+    }
+}
+
+void InstanceRenderer::draw() {
+    stats = InstanceStats();
+    if (!model || instances.empty()) {
+        return;
+    }
+
+    if (instancesDirty) {
+        instancesDirty = false;
+        buildGroups();
+
+        activeMode = requestedMode;
+        if (activeMode == MODE_HARDWARE && !prepareHardware()) {
+            std::cerr << "Warning: Hardware instancing not available, using batched instances" << std::endl;
+            activeMode = MODE_BATCHED;
+        }
+
+        if (activeMode == MODE_HARDWARE) {
+            uploadInstances();
+        }
+        if (activeMode == MODE_BATCHED) {
+            buildBatches();
+        }
+        else {
+            releaseBatches();
+        }
+    }
+
+    // Lights toggled since the last frame need a new program
+    if (activeMode == MODE_HARDWARE && !buildProgram(getEnabledLightMask())) {
+        std::cerr << "Warning: Hardware instancing not available, using batched instances" << std::endl;
+        activeMode = MODE_BATCHED;
+        buildBatches();
+    }
+
+    auto submitStart = std::chrono::high_resolution_clock::now();
+
+    glState.enable(GL_TEXTURE_2D);
+    if (activeMode == MODE_HARDWARE) {
+        drawHardware();
+    }
+    else if (activeMode == MODE_BATCHED) {
+        drawBatched();
+    }
+    else {
+        drawPerInstance();
+    }
+    glState.depthMask(GL_TRUE);
+    glState.disable(GL_TEXTURE_2D);
+    glState.disable(GL_BLEND);
+
+    stats.instancesDrawn = instances.size();
+    if (activeMode != MODE_PER_INSTANCE) {
+        for (const DrawRange& range : model->getDrawRanges()) {
+            stats.trianglesDrawn += range.triangleCount * instances.size();
+        }
+    }
+    stats.submitMs = std::chrono::duration<float, std::milli>(
+        std::chrono::high_resolution_clock::now() - submitStart).count();
+}
+
+void InstanceRenderer::drawHardware() {
+    extUseProgram(program);
+    glState.enable(GL_VERTEX_PROGRAM_TWO_SIDE);
+
+    extUniform1i(lightingUniform, glState.isEnabled(GL_LIGHTING));
+    extUniform1i(useTextureUniform, 0);
+
+    meshBuffers.bind();
+    extBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    for (int c = 0; c < 4; c++) {
+        if (instanceAttributes[c] < 0) continue;
+        extEnableVertexAttribArray(instanceAttributes[c]);
+        extVertexAttribDivisor(instanceAttributes[c], 1);
+    }
+
+    const std::vector<DrawRange>& ranges = model->getDrawRanges();
+    const Material* bound = nullptr;
+
+    // Opaque pass, then transparent ranges without depth writes
+    for (int pass = 0; pass < 2; pass++) {
+        if (pass == 1) {
+            glState.depthMask(GL_FALSE);
+        }
+
+        for (const Group& group : groups) {
+            // No base-instance draws in GL 3.x, so the attributes start at the group instead
+            const GLsizei stride = 16 * sizeof(float);
+            for (int c = 0; c < 4; c++) {
+                if (instanceAttributes[c] < 0) continue;
+                size_t offset = (group.firstInstance * 16 + c * 4) * sizeof(float);
+                extVertexAttribPointer(instanceAttributes[c], 4, GL_FLOAT, GL_FALSE, stride, (const void*)offset);
+            }
+
+            for (size_t r = 0; r < ranges.size(); r++) {
+                const Material* material = group.materialOverride ? group.materialOverride : ranges[r].material;
+                bool transparent = material ? material->transparency < 1.0f : false;
+                if (transparent != (pass == 1)) {
+                    continue;
+                }
+                bindMaterial(material, bound);
+                meshBuffers.drawRangeInstanced(r, group.instanceCount);
+                stats.drawCalls++;
+            }
+        }
+    }
+
+    for (int c = 0; c < 4; c++) {
+        if (instanceAttributes[c] < 0) continue;
+        extVertexAttribDivisor(instanceAttributes[c], 0);
+        extDisableVertexAttribArray(instanceAttributes[c]);
+    }
+    meshBuffers.unbind();
+
+    glState.disable(GL_VERTEX_PROGRAM_TWO_SIDE);
+    extUseProgram(0);
+}
+
+void InstanceRenderer::drawBatched() {
+    // Vertices are already in world space
+    const BufferVertex* base = nullptr;
+    const GLuint* indexBase = nullptr;
+    if (batchVertexBuffer != 0) {
+        extBindBuffer(GL_ARRAY_BUFFER, batchVertexBuffer);
+        extBindBuffer(GL_ELEMENT_ARRAY_BUFFER, batchIndexBuffer);
+    }
+    else if (!batchVertices.empty()) {
+        base = &batchVertices[0];
+        indexBase = &batchIndices[0];
+    }
+    else {
+        return;
+    }
+
+    const GLsizei stride = sizeof(BufferVertex);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glVertexPointer(3, GL_FLOAT, stride, (const char*)base + offsetof(BufferVertex, position));
+    glNormalPointer(GL_FLOAT, stride, (const char*)base + offsetof(BufferVertex, normal));
+    glTexCoordPointer(2, GL_FLOAT, stride, (const char*)base + offsetof(BufferVertex, texCoord));
+
+    // Opaque batches sort first (map key), transparent ones last
+    const Material* bound = nullptr;
+    for (const Batch& batch : batches) {
+        if (batch.transparent) {
+            glState.depthMask(GL_FALSE);
+        }
+        bindMaterial(batch.material, bound);
+        glDrawElements(GL_TRIANGLES, batch.indexCount, GL_UNSIGNED_INT, indexBase + batch.firstIndex);
+        stats.drawCalls++;
+    }
+
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    if (batchVertexBuffer != 0) {
+        extBindBuffer(GL_ARRAY_BUFFER, 0);
+        extBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+}
+
+void InstanceRenderer::drawPerInstance() {
+    // Baseline: the regular draw path once per instance (material overrides are ignored)
+    for (const ModelInstance& instance : instances) {
+        glPushMatrix();
+        glMultMatrixf(instance.transform);
+        model->drawWithMaterials();
+        glPopMatrix();
+
+        const DrawStats& drawStats = model->getDrawStats();
+        stats.trianglesDrawn += drawStats.trianglesDrawn;
+        stats.drawCalls += drawStats.drawCalls;
+    }
+}
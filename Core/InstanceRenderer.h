@@ -0,0 +1,114 @@
+#ifndef INSTANCE_RENDERER_H
+#define INSTANCE_RENDERER_H
+
+#include <vector>
+#include "ObjLoader.h"
+#include "MeshBuffers.h"
+
+// One placed copy of the model. The transform places the normalized model
+// (ObjLoader center/scale already applied) in world space.
+struct ModelInstance {
+    float transform[16];                // Column-major
+    const Material* materialOverride;   // Replaces every material of the model; nullptr keeps them
+    ModelInstance();
+};
+
+struct InstanceStats {
+    int instancesDrawn;
+    int drawCalls;
+    int trianglesDrawn;
+    float submitMs;
+    InstanceStats() : instancesDrawn(0), drawCalls(0), trianglesDrawn(0), submitMs(0.0f) {}
+};
+
+// Draws many copies of one ObjLoader model. With GLSL + instanced arrays the
+// welded mesh is drawn once per (material override group, draw range) with
+// glDrawElementsInstanced; a vertex shader reproduces the fixed-function
+// lighting (rebuilt when the set of enabled lights changes). Otherwise all instances are pre-transformed on the CPU into one
+// batch per material (rebuilt when the instance list changes). Either way the
+// draw call count does not grow with the instance count. Transparent ranges
+// are drawn last without depth writes but are not depth sorted.
+class InstanceRenderer {
+public:
+    enum Mode {
+        MODE_HARDWARE,     // glDrawElementsInstanced
+        MODE_BATCHED,      // CPU pre-transformed batches
+        MODE_PER_INSTANCE  // ObjLoader::drawWithMaterials() per instance, for comparison
+    };
+
+private:
+    struct Group {
+        const Material* materialOverride;
+        int firstInstance;
+        int instanceCount;
+    };
+
+    struct Batch {
+        const Material* material;
+        bool transparent;
+        int firstIndex;
+        int indexCount;
+    };
+
+    ObjLoader* model;
+    std::vector<ModelInstance> instances;
+    std::vector<Group> groups;         // Instances sorted by override, contiguous per group
+    bool instancesDirty;
+    Mode requestedMode;
+    Mode activeMode;
+    InstanceStats stats;
+
+    // Hardware path
+    MeshBuffers meshBuffers;
+    GLuint program;
+    int programLightMask;              // GL_LIGHTi enabled when the program was built
+    GLuint instanceBuffer;
+    GLint instanceAttributes[4];       // Matrix columns, one vec4 attribute each
+    GLint lightingUniform;
+    GLint useTextureUniform;
+    bool hardwareFailed;
+
+    // Batched path
+    WeldedMesh weldedMesh;
+    std::vector<BufferVertex> batchVertices;
+    std::vector<GLuint> batchIndices;
+    std::vector<Batch> batches;
+    GLuint batchVertexBuffer;
+    GLuint batchIndexBuffer;
+
+    static int getEnabledLightMask();
+    bool buildProgram(int lightMask);
+    bool prepareHardware();
+    void uploadInstances();
+    void buildGroups();
+    void buildBatches();
+    void releaseBatches();
+    void drawHardware();
+    void drawBatched();
+    void drawPerInstance();
+    void bindMaterial(const Material* material, const Material*& bound);
+
+public:
+    InstanceRenderer();
+    ~InstanceRenderer();
+
+    // Not owned; must outlive the renderer
+    void setModel(ObjLoader* model);
+
+    void clearInstances();
+    void addInstance(const ModelInstance& instance);
+    // Grid on the XZ plane, centered on the origin; every overrideEvery-th instance gets 'override'
+    void addGrid(int count, float spacing, float instanceScale, const Material* override = nullptr,
+                 int overrideEvery = 0);
+    int getInstanceCount() const { return instances.size(); }
+
+    // Hardware by default; falls back to batched if the context lacks support
+    void setMode(Mode mode);
+    Mode getMode() const { return activeMode; }
+    static const char* getModeName(Mode mode);
+
+    void draw();
+    const InstanceStats& getStats() const { return stats; }
+};
+
+#endif
@@ -0,0 +1,259 @@
+#include "MeshBuffers.h"
+#include "ObjLoader.h"
+#include <unordered_map>
+#include <iostream>
+
+namespace {
+    struct CornerKey {
+        int vertex, texCoord, normal;
+        bool operator==(const CornerKey& other) const {
+            return vertex == other.vertex && texCoord == other.texCoord && normal == other.normal;
+        }
+    };
+
+    struct CornerKeyHash {
+        size_t operator()(const CornerKey& key) const {
+            size_t h = (size_t)key.vertex * 73856093u;
+            h ^= (size_t)key.texCoord * 19349663u;
+            h ^= (size_t)key.normal * 83492791u;
+            return h;
+        }
+    };
+
+    int cornerIndex(const std::vector<int>& indices, size_t i, size_t limit) {
+        if (i >= indices.size()) return -1;
+        int index = indices[i];
+        return (index >= 0 && index < (int)limit) ? index : -1;
+    }
+}
+
+MeshBuffers::MeshBuffers() : vertexBuffer(0), indexBuffer(0), indexType(GL_UNSIGNED_INT),
+                             vertexCount(0), indexCount(0), cornerCount(0) {
+}
+
+MeshBuffers::~MeshBuffers() {
+    release();
+}
+
+void WeldedMesh::clear() {
+    vertices.clear();
+    indices.clear();
+    ranges.clear();
+    sources.clear();
+    cornerCount = 0;
+}
+
+void WeldedMesh::build(const ObjLoader& model) {
+    clear();
+    const std::vector<Vec3>& positions = model.getVertices();
+    const std::vector<Vec3>& normals = model.getNormals();
+    const std::vector<Vec2>& texCoords = model.getTexCoords();
+    const std::vector<Face>& faces = model.getFaces();
+    const std::vector<DrawRange>& drawRanges = model.getDrawRanges();
+    bool keepSources = model.hasDynamicVertices();
+
+    std::unordered_map<CornerKey, GLuint, CornerKeyHash> welded;
+    welded.reserve(positions.size() * 2);
+    std::vector<GLuint> faceCorners;
+
+    ranges.resize(drawRanges.size());
+    for (size_t r = 0; r < drawRanges.size(); r++) {
+        const DrawRange& range = drawRanges[r];
+        ranges[r].firstIndex = indices.size();
+
+        for (int f = range.firstFace; f < range.firstFace + range.faceCount; f++) {
+            const Face& face = faces[f];
+            faceCorners.clear();
+
+            for (size_t i = 0; i < face.vertexIndices.size(); i++) {
+                // Corners with a bad position index are dropped, like glVertex is skipped in drawFace()
+                CornerKey key;
+                key.vertex = cornerIndex(face.vertexIndices, i, positions.size());
+                if (key.vertex < 0) continue;
+                key.texCoord = cornerIndex(face.texCoordIndices, i, texCoords.size());
+                key.normal = cornerIndex(face.normalIndices, i, normals.size());
+                cornerCount++;
+
+                auto found = welded.find(key);
+                if (found != welded.end()) {
+                    faceCorners.push_back(found->second);
+                    continue;
+                }
+
+                // Missing attributes get the GL defaults instead of whatever was current
+                BufferVertex vertex;
+                const Vec3& p = positions[key.vertex];
+                vertex.position[0] = p.x; vertex.position[1] = p.y; vertex.position[2] = p.z;
+                Vec3 n = key.normal >= 0 ? normals[key.normal] : Vec3(0.0f, 0.0f, 1.0f);
+                vertex.normal[0] = n.x; vertex.normal[1] = n.y; vertex.normal[2] = n.z;
+                Vec2 t = key.texCoord >= 0 ? texCoords[key.texCoord] : Vec2(0.0f, 0.0f);
+                vertex.texCoord[0] = t.u; vertex.texCoord[1] = t.v;
+
+                GLuint index = vertices.size();
+                vertices.push_back(vertex);
+                if (keepSources) {
+                    WeldedSource source = { key.vertex, key.normal };
+                    sources.push_back(source);
+                }
+                welded[key] = index;
+                faceCorners.push_back(index);
+            }
+
+            // Fan triangulation, same split as GL_QUADS / GL_POLYGON
+            for (size_t i = 1; i + 1 < faceCorners.size(); i++) {
+                indices.push_back(faceCorners[0]);
+                indices.push_back(faceCorners[i]);
+                indices.push_back(faceCorners[i + 1]);
+            }
+        }
+
+        ranges[r].indexCount = indices.size() - ranges[r].firstIndex;
+    }
+}
+
+bool WeldedMesh::updateVertices(const ObjLoader& model) {
+    if (sources.size() != vertices.size()) {
+        return false;
+    }
+    const std::vector<Vec3>& positions = model.getVertices();
+    const std::vector<Vec3>& normals = model.getNormals();
+    for (size_t i = 0; i < vertices.size(); i++) {
+        const WeldedSource& source = sources[i];
+        BufferVertex& vertex = vertices[i];
+        // The topology is unchanged, so the indices are still in range
+        const Vec3& p = positions[source.vertex];
+        vertex.position[0] = p.x; vertex.position[1] = p.y; vertex.position[2] = p.z;
+        if (source.normal >= 0) {
+            const Vec3& n = normals[source.normal];
+            vertex.normal[0] = n.x; vertex.normal[1] = n.y; vertex.normal[2] = n.z;
+        }
+    }
+    return true;
+}
+
+bool MeshBuffers::build(const ObjLoader& model) {
+    release();
+    if (!hasBufferObjects()) {
+        return false;
+    }
+
+    WeldedMesh mesh;
+    mesh.build(model);
+    if (mesh.indices.empty()) {
+        return false;
+    }
+    const std::vector<BufferVertex>& bufferVertices = mesh.vertices;
+    const std::vector<GLuint>& indices = mesh.indices;
+    vertexCount = bufferVertices.size();
+    indexCount = indices.size();
+    cornerCount = mesh.cornerCount;
+    ranges.swap(mesh.ranges);
+
+    extGenBuffers(1, &vertexBuffer);
+    extGenBuffers(1, &indexBuffer);
+
+    bool dynamic = !mesh.sources.empty();
+    extBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    extBufferData(GL_ARRAY_BUFFER, bufferVertices.size() * sizeof(BufferVertex),
+                  &bufferVertices[0], dynamic ? GL_STREAM_DRAW : GL_STATIC_DRAW);
+    extBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // 16-bit indices halve the index traffic for most models
+    extBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    if (vertexCount <= 65536) {
+        std::vector<GLushort> shortIndices(indices.begin(), indices.end());
+        indexType = GL_UNSIGNED_SHORT;
+        extBufferData(GL_ELEMENT_ARRAY_BUFFER, shortIndices.size() * sizeof(GLushort),
+                      &shortIndices[0], GL_STATIC_DRAW);
+    }
+    else {
+        indexType = GL_UNSIGNED_INT;
+        extBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint),
+                      &indices[0], GL_STATIC_DRAW);
+    }
+    extBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    if (dynamic) {
+        dynamicMesh.vertices.swap(mesh.vertices);
+        dynamicMesh.sources.swap(mesh.sources);
+    }
+    return true;
+}
+
+bool MeshBuffers::updateVertices(const ObjLoader& model) {
+    if (vertexBuffer == 0 || !dynamicMesh.updateVertices(model)) {
+        return false;
+    }
+    // Same size again: the driver may orphan the old storage instead of waiting for draws that use it
+    extBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    extBufferData(GL_ARRAY_BUFFER, dynamicMesh.vertices.size() * sizeof(BufferVertex),
+                  &dynamicMesh.vertices[0], GL_STREAM_DRAW);
+    extBindBuffer(GL_ARRAY_BUFFER, 0);
+    return true;
+}
+
+void MeshBuffers::release() {
+    if (vertexBuffer != 0 && extDeleteBuffers) {
+        extDeleteBuffers(1, &vertexBuffer);
+        extDeleteBuffers(1, &indexBuffer);
+    }
+    vertexBuffer = 0;
+    indexBuffer = 0;
+    vertexCount = 0;
+    indexCount = 0;
+    cornerCount = 0;
+    ranges.clear();
+    dynamicMesh.clear();
+}
+
+void MeshBuffers::bind() const {
+    extBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    extBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+
+    const GLsizei stride = sizeof(BufferVertex);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glVertexPointer(3, GL_FLOAT, stride, (const void*)offsetof(BufferVertex, position));
+    glNormalPointer(GL_FLOAT, stride, (const void*)offsetof(BufferVertex, normal));
+    glTexCoordPointer(2, GL_FLOAT, stride, (const void*)offsetof(BufferVertex, texCoord));
+}
+
+void MeshBuffers::unbind() const {
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+
+    extBindBuffer(GL_ARRAY_BUFFER, 0);
+    extBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+int MeshBuffers::drawRange(int rangeIndex) const {
+    const IndexRange& range = ranges[rangeIndex];
+    if (range.indexCount == 0) {
+        return 0;
+    }
+    size_t indexSize = (indexType == GL_UNSIGNED_SHORT) ? sizeof(GLushort) : sizeof(GLuint);
+    glDrawElements(GL_TRIANGLES, range.indexCount, indexType,
+                   (const void*)(range.firstIndex * indexSize));
+    return 1;
+}
+
+void MeshBuffers::drawRangeInstanced(int rangeIndex, int instanceCount) const {
+    const IndexRange& range = ranges[rangeIndex];
+    if (range.indexCount == 0 || instanceCount == 0) {
+        return;
+    }
+    size_t indexSize = (indexType == GL_UNSIGNED_SHORT) ? sizeof(GLushort) : sizeof(GLuint);
+    extDrawElementsInstanced(GL_TRIANGLES, range.indexCount, indexType,
+                             (const void*)(range.firstIndex * indexSize), instanceCount);
+}
+
+size_t MeshBuffers::getGpuBytes() const {
+    size_t indexSize = (indexType == GL_UNSIGNED_SHORT) ? sizeof(GLushort) : sizeof(GLuint);
+    return vertexCount * sizeof(BufferVertex) + indexCount * indexSize;
+}
+
+size_t MeshBuffers::getClientBytes() const {
+    return dynamicMesh.vertices.size() * sizeof(BufferVertex) + dynamicMesh.sources.size() * sizeof(WeldedSource);
+}
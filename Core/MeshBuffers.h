@@ -0,0 +1,85 @@
+#ifndef MESH_BUFFERS_H
+#define MESH_BUFFERS_H
+
+#include <vector>
+#include "GLExtensions.h"
+
+class ObjLoader;
+
+// Interleaved vertex as stored in the vertex buffer (32 bytes)
+struct BufferVertex {
+    float position[3];
+    float normal[3];
+    float texCoord[2];
+};
+
+// Model position and normal a welded vertex was made from (-1 = GL default)
+struct WeldedSource {
+    int vertex;
+    int normal;
+};
+
+// Contiguous indices of one ObjLoader draw range
+struct IndexRange {
+    int firstIndex;
+    int indexCount;
+};
+
+// Indexed triangle copy of a model. Face corners are welded on their
+// (vertex, texcoord, normal) triple, faces are fan-triangulated, and the
+// indices of each draw range are stored contiguously so a range is a single
+// glDrawElements call.
+struct WeldedMesh {
+    std::vector<BufferVertex> vertices;
+    std::vector<GLuint> indices;
+    std::vector<IndexRange> ranges;   // One per ObjLoader draw range
+    std::vector<WeldedSource> sources; // Per vertex, only for models with dynamic vertices
+    int cornerCount;                  // Face corners before welding
+
+    WeldedMesh() : cornerCount(0) {}
+    void build(const ObjLoader& model);
+    // Copies the model's current positions and normals into 'vertices';
+    // false if the mesh was not built with sources
+    bool updateVertices(const ObjLoader& model);
+    void clear();
+};
+
+// Retained copy of a WeldedMesh in GPU buffer objects
+class MeshBuffers {
+private:
+    GLuint vertexBuffer;
+    GLuint indexBuffer;
+    GLenum indexType;          // GL_UNSIGNED_SHORT when the vertex count allows
+    int vertexCount;
+    int indexCount;
+    int cornerCount;
+    std::vector<IndexRange> ranges;
+    WeldedMesh dynamicMesh;    // Vertices and sources kept for updateVertices(), dynamic models only
+
+public:
+    MeshBuffers();
+    ~MeshBuffers();
+
+    // Weld and upload; false (nothing built) if buffer objects are unavailable
+    bool build(const ObjLoader& model);
+    void release();
+    bool isBuilt() const { return vertexBuffer != 0; }
+    // Re-uploads the vertex buffer with the model's current positions and
+    // normals; false if the model did not have dynamic vertices at build()
+    bool updateVertices(const ObjLoader& model);
+
+    // bind() sets up the vertex/normal/texcoord arrays; drawRange() between bind and unbind
+    void bind() const;
+    void unbind() const;
+    int drawRange(int rangeIndex) const;    // 1 if a draw call was issued
+    void drawRangeInstanced(int rangeIndex, int instanceCount) const;
+
+    // Getters
+    int getVertexCount() const { return vertexCount; }
+    int getIndexCount() const { return indexCount; }
+    int getCornerCount() const { return cornerCount; }
+    size_t getGpuBytes() const;
+    size_t getClientBytes() const;     // Copy kept for updateVertices()
+};
+
+#endif
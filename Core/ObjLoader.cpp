@@ -1,26 +1,232 @@
 #include "ObjLoader.h"
+#include "Frustum.h"
+#include "OcclusionCuller.h"
+#include "GLStateCache.h"
+#include "Trace.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <cmath>
 #include <algorithm>
+#include <set>
+#include <chrono>
+#include <iomanip>
+#include <cstring>
+#include <cstdint>
 
 // For texture loading - using simple BMP loader
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
-ObjLoader::ObjLoader() : scale(1.0f) {
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VERTEX_HASH_USE_SSE
+#endif
+
+namespace {
+    // RGB is usually stored as RGBA; a full mip chain adds a third
+    size_t estimateTextureBytes(const TextureImage& image) {
+        return (size_t)image.width * image.height * 4 * 4 / 3;
+    }
+
+    template <typename T>
+    void addVector(const std::vector<T>& v, size_t& used, size_t& slack) {
+        used += v.size() * sizeof(T);
+        slack += (v.capacity() - v.size()) * sizeof(T);
+    }
+
+    // Heap bytes of a string; short strings are stored inside the object (SSO)
+    size_t stringHeapBytes(const std::string& s) {
+        const char* data = s.data();
+        const char* object = reinterpret_cast<const char*>(&s);
+        if (data >= object && data < object + sizeof(std::string)) {
+            return 0;
+        }
+        return s.capacity() + 1;
+    }
+
+    // Appends plain values in host byte order (little-endian on every supported target)
+    class TopologyWriter {
+    private:
+        std::vector<char>& out;
+
+    public:
+        explicit TopologyWriter(std::vector<char>& out) : out(out) {}
+
+        void bytes(const void* data, size_t size) {
+            const char* p = static_cast<const char*>(data);
+            out.insert(out.end(), p, p + size);
+        }
+        template <typename T>
+        void value(const T& v) { bytes(&v, sizeof(T)); }
+        void count(size_t n) { value((uint32_t)n); }
+        void string(const std::string& s) {
+            count(s.size());
+            bytes(s.data(), s.size());
+        }
+        void ints(const std::vector<int>& v) {
+            count(v.size());
+            if (!v.empty()) bytes(&v[0], v.size() * sizeof(int32_t));
+        }
+    };
+
+    // Reads what TopologyWriter wrote; every read past the end fails and sets 'ok' to false
+    class TopologyReader {
+    private:
+        const char* data;
+        size_t size;
+        size_t position;
+
+    public:
+        bool ok;
+
+        TopologyReader(const char* data, size_t size) : data(data), size(size), position(0), ok(true) {}
+
+        bool bytes(void* target, size_t n) {
+            if (!ok || n > size - position) {
+                ok = false;
+                return false;
+            }
+            std::memcpy(target, data + position, n);
+            position += n;
+            return true;
+        }
+        template <typename T>
+        T value() {
+            T v = T();
+            bytes(&v, sizeof(T));
+            return v;
+        }
+        // Element count, rejected if that many elements of 'elementSize' cannot follow
+        size_t count(size_t elementSize) {
+            size_t n = value<uint32_t>();
+            if (ok && n > (size - position) / std::max(elementSize, (size_t)1)) {
+                ok = false;
+            }
+            return ok ? n : 0;
+        }
+        std::string string() {
+            std::string s(count(1), '\0');
+            if (!s.empty()) bytes(&s[0], s.size());
+            return s;
+        }
+        void ints(std::vector<int>& v) {
+            v.resize(count(sizeof(int32_t)));
+            if (!v.empty()) bytes(&v[0], v.size() * sizeof(int32_t));
+        }
+    };
+
+    bool sameVec3(const Vec3& a, const Vec3& b) {
+        return a.x == b.x && a.y == b.y && a.z == b.z;
+    }
+
+    bool sameFace(const Face& a, const Face& b) {
+        return a.objectIndex == b.objectIndex && a.vertexIndices == b.vertexIndices &&
+               a.texCoordIndices == b.texCoordIndices && a.normalIndices == b.normalIndices &&
+               a.materialName == b.materialName;
+    }
+
+    // Everything read from the .mtl; texture state differs between loads
+    bool sameMaterial(const Material& a, const Material& b) {
+        return a.name == b.name && sameVec3(a.ambient, b.ambient) && sameVec3(a.diffuse, b.diffuse) &&
+               sameVec3(a.specular, b.specular) && a.shininess == b.shininess &&
+               a.transparency == b.transparency && a.illum == b.illum &&
+               a.ambientTexture == b.ambientTexture && a.diffuseTexture == b.diffuseTexture &&
+               a.specularTexture == b.specularTexture && a.bumpTexture == b.bumpTexture;
+    }
+
+    // Vertex data hash: eight 64-bit lanes, each accumulating
+    // rotate32(data) + lo32(data ^ key) * hi32(data ^ key) over every 64th
+    // byte group, then folded with the tail bytes. The SSE2 and scalar paths
+    // give the same result.
+    const uint64_t kHashPrime1 = 0x9E3779B185EBCA87ULL;
+    const uint64_t kHashPrime2 = 0xC2B2AE3D27D4EB4FULL;
+    const uint64_t kHashKeys[8] = {
+        0xBE4BA423396CFEB8ULL, 0x1CAD21F72C81017CULL, 0xDB979083E96DD4DEULL, 0x1F67B3B7A4A44072ULL,
+        0x78E5C0CC4EE679CBULL, 0x2172FFCC7DD05A82ULL, 0x8E2443F7744608B8ULL, 0x4C263A81E69035E0ULL,
+    };
+    const size_t kHashStripe = 64;
+
+    uint64_t hashBytes(const void* data, size_t size, uint64_t seed) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        size_t stripes = size / kHashStripe;
+        uint64_t lanes[8];
+#ifdef VERTEX_HASH_USE_SSE
+        __m128i acc[4];
+        __m128i keys[4];
+        for (int i = 0; i < 4; i++) {
+            acc[i] = _mm_set1_epi64x((long long)(seed + i));
+            keys[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(kHashKeys + 2 * i));
+        }
+        for (size_t s = 0; s < stripes; s++) {
+            const __m128i* stripe = reinterpret_cast<const __m128i*>(bytes + s * kHashStripe);
+            for (int i = 0; i < 4; i++) {
+                __m128i value = _mm_loadu_si128(stripe + i);
+                __m128i mixed = _mm_xor_si128(value, keys[i]);
+                __m128i product = _mm_mul_epu32(mixed, _mm_srli_epi64(mixed, 32));
+                __m128i rotated = _mm_shuffle_epi32(value, _MM_SHUFFLE(2, 3, 0, 1));
+                acc[i] = _mm_add_epi64(acc[i], _mm_add_epi64(rotated, product));
+            }
+        }
+        for (int i = 0; i < 4; i++) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes + 2 * i), acc[i]);
+        }
+#else
+        for (int i = 0; i < 8; i++) {
+            lanes[i] = seed + i / 2;
+        }
+        for (size_t s = 0; s < stripes; s++) {
+            for (int i = 0; i < 8; i++) {
+                uint64_t value;
+                std::memcpy(&value, bytes + s * kHashStripe + i * sizeof(uint64_t), sizeof(value));
+                uint64_t mixed = value ^ kHashKeys[i];
+                lanes[i] += ((value << 32) | (value >> 32)) + (mixed & 0xFFFFFFFFULL) * (mixed >> 32);
+            }
+        }
+#endif
+        uint64_t hash = seed ^ (size * kHashPrime1);
+        for (int i = 0; i < 8; i++) {
+            hash = (hash ^ lanes[i]) * kHashPrime1;
+            hash ^= hash >> 29;
+        }
+        for (size_t i = stripes * kHashStripe; i < size; i++) {
+            hash = (hash ^ bytes[i]) * kHashPrime2;
+        }
+        hash ^= hash >> 33;
+        hash *= kHashPrime2;
+        hash ^= hash >> 29;
+        return hash;
+    }
+}
+
+ObjLoader::ObjLoader() : topology(new MeshTopology()), renderBackend(nullptr),
+                         requestedBackend(RENDER_BUFFERS), backendDirty(true),
+                         dynamicVertices(false), verticesChanged(false), vertexVersion(0),
+                         scale(1.0f), objectChanged(true),
+                         frustumCulling(true), occlusionCuller(nullptr),
+                         textureLoading(TEXTURES_UPLOAD), verbose(true) {
     minBounds = Vec3(1e10, 1e10, 1e10);
     maxBounds = Vec3(-1e10, -1e10, -1e10);
 }
 
-ObjLoader::~ObjLoader() {
-    // Clean up textures
+MeshTopology::~MeshTopology() {
+    // Clean up textures. Without any this makes no GL call, so a topology
+    // loaded without textures may be dropped on a loader thread.
+    bool deletedTexture = false;
     for (auto& matPair : materials) {
         if (matPair.second.textureID != 0) {
             glDeleteTextures(1, &matPair.second.textureID);
+            deletedTexture = true;
         }
     }
+    // A deleted texture that was bound reverts the binding to 0
+    if (deletedTexture) {
+        glState.invalidate();
+    }
+}
+
+ObjLoader::~ObjLoader() {
+    delete renderBackend;
 }
 
 std::string ObjLoader::getDirectory(const std::string& filepath) {
@@ -32,7 +238,12 @@ std::string ObjLoader::getDirectory(const std::string& filepath) {
 }
 
 bool ObjLoader::loadObj(const std::string& filename) {
-    std::ifstream file(filename);
+    TRACE_SCOPE_DETAIL("load obj", filename);
+    std::ifstream file;
+    {
+        TRACE_SCOPE("open file");
+        file.open(filename);
+    }
     if (!file.is_open()) {
         std::cerr << "Error: Cannot open file " << filename << std::endl;
         return false;
@@ -42,34 +253,64 @@ bool ObjLoader::loadObj(const std::string& filename) {
     std::string line;
     int lineNum = 0;
 
-    while (std::getline(file, line)) {
-        lineNum++;
-        if (line.empty() || line[0] == '#') continue;
+    {
+        TRACE_SCOPE("parse");
+        while (std::getline(file, line)) {
+            lineNum++;
+            if (line.empty() || line[0] == '#') continue;
 
-        try {
-            parseLine(line);
-        }
-        catch (const std::exception& e) {
-            std::cerr << "Error parsing line " << lineNum << ": " << e.what() << std::endl;
+            try {
+                parseLine(line);
+            }
+            catch (const std::exception& e) {
+                std::cerr << "Error parsing line " << lineNum << ": " << e.what() << std::endl;
+            }
         }
     }
 
     file.close();
 
+    // Positions and normals are all that stays per frame once an animation shares topology
+    vertices.shrink_to_fit();
+    normals.shrink_to_fit();
+
     calculateBounds();
+    sortFacesByMaterial();
+    buildDrawRanges();
+    buildTransparentTriangles();
+    calculateObjectBounds();
+    backendDirty = true;
+    vertexVersion++;
+
+    if (!verbose) {
+        return true;
+    }
 
     std::cout << "OBJ file loaded successfully:" << std::endl;
     std::cout << "  Vertices: " << vertices.size() << std::endl;
     std::cout << "  Normals: " << normals.size() << std::endl;
-    std::cout << "  Texture Coords: " << texCoords.size() << std::endl;
-    std::cout << "  Faces: " << faces.size() << std::endl;
-    std::cout << "  Materials: " << materials.size() << std::endl;
+    std::cout << "  Texture Coords: " << topology->texCoords.size() << std::endl;
+    std::cout << "  Faces: " << topology->faces.size() << std::endl;
+    std::cout << "  Materials: " << topology->materials.size() << std::endl;
+    std::cout << "  Objects: " << objects.size() << std::endl;
+    std::cout << "  Draw ranges: " << topology->drawRanges.size() << std::endl;
+    if (!transparentTriangles.empty()) {
+        std::cout << "  Transparent triangles: " << transparentTriangles.size() << std::endl;
+    }
+    if (!topology->materials.empty()) {
+        std::set<std::string> usedMaterials;
+        for (const auto& range : topology->drawRanges) {
+            usedMaterials.insert(range.materialName);
+        }
+        std::cout << "  Material changes per frame: " << topology->fileOrderMaterialChanges
+                  << " in file order, " << usedMaterials.size() << " sorted" << std::endl;
+    }
     std::cout << "  Center: (" << center.x << ", " << center.y << ", " << center.z << ")" << std::endl;
     std::cout << "  Scale: " << scale << std::endl;
 
     // Check for faces without materials
     int facesWithoutMaterial = 0;
-    for (const auto& face : faces) {
+    for (const auto& face : topology->faces) {
         if (face.materialName.empty()) {
             facesWithoutMaterial++;
         }
@@ -110,7 +351,7 @@ void ObjLoader::parseLine(const std::string& line) {
         // Texture coordinate
         Vec2 texCoord;
         iss >> texCoord.u >> texCoord.v;
-        texCoords.push_back(texCoord);
+        topology->texCoords.push_back(texCoord);
     }
     else if (prefix == "f") {
         // Face
@@ -130,12 +371,29 @@ void ObjLoader::parseLine(const std::string& line) {
         std::getline(iss >> std::ws, materialName);
         currentMaterial = materialName;
     }
+    else if (prefix == "o" || prefix == "g") {
+        // Object / group name; the record itself is created by the first face that follows
+        std::string objectName;
+        std::getline(iss >> std::ws, objectName);
+        currentObject = objectName;
+        objectChanged = true;
+    }
 }
 
 void ObjLoader::parseFace(const std::string& line) {
     Face face;
     face.materialName = currentMaterial;
 
+    // Start a new object record on the first face after an o/g line (or the first face at all)
+    if (objectChanged) {
+        ObjectGroup object;
+        object.name = currentObject.empty() ? "default" : currentObject;
+        objects.push_back(object);
+        objectChanged = false;
+    }
+    face.objectIndex = objects.size() - 1;
+    objects.back().faceCount++;
+
     std::istringstream iss(line);
     std::string prefix;
     iss >> prefix; // Skip 'f'
@@ -154,7 +412,7 @@ void ObjLoader::parseFace(const std::string& line) {
                 // OBJ indices are 1-based, convert to 0-based
                 if (index > 0) index--;
                 else if (index < 0) index = (idx == 0 ? vertices.size() :
-                    idx == 1 ? texCoords.size() :
+                    idx == 1 ? topology->texCoords.size() :
                     normals.size()) + index;
 
                 if (idx == 0) face.vertexIndices.push_back(index);
@@ -165,10 +423,11 @@ void ObjLoader::parseFace(const std::string& line) {
         }
     }
 
-    faces.push_back(face);
+    topology->faces.push_back(face);
 }
 
 void ObjLoader::calculateBounds() {
+    TRACE_SCOPE("bounds");
     // Calculate center
     center.x = (minBounds.x + maxBounds.x) / 2.0f;
     center.y = (minBounds.y + maxBounds.y) / 2.0f;
@@ -185,51 +444,295 @@ void ObjLoader::calculateBounds() {
     }
 }
 
+void ObjLoader::calculateObjectBounds() {
+    TRACE_SCOPE("object bounds");
+    for (auto& object : objects) {
+        object.minBounds = Vec3(1e10, 1e10, 1e10);
+        object.maxBounds = Vec3(-1e10, -1e10, -1e10);
+        object.triangleCount = 0;
+    }
+
+    for (const auto& face : topology->faces) {
+        ObjectGroup& object = objects[face.objectIndex];
+        if (face.vertexIndices.size() >= 3) {
+            object.triangleCount += face.vertexIndices.size() - 2;
+        }
+        for (int vIdx : face.vertexIndices) {
+            if (vIdx < 0 || vIdx >= (int)vertices.size()) continue;
+            const Vec3& v = vertices[vIdx];
+            object.minBounds.x = std::min(object.minBounds.x, v.x);
+            object.minBounds.y = std::min(object.minBounds.y, v.y);
+            object.minBounds.z = std::min(object.minBounds.z, v.z);
+            object.maxBounds.x = std::max(object.maxBounds.x, v.x);
+            object.maxBounds.y = std::max(object.maxBounds.y, v.y);
+            object.maxBounds.z = std::max(object.maxBounds.z, v.z);
+        }
+    }
+}
+
+void ObjLoader::sortFacesByMaterial() {
+    TRACE_SCOPE("sort faces");
+    // Cost of the old file-order walk, kept for the load report
+    topology->fileOrderMaterialChanges = 0;
+    std::string lastMaterial;
+    for (const auto& face : topology->faces) {
+        if (face.materialName != lastMaterial) {
+            lastMaterial = face.materialName;
+            if (topology->materials.find(face.materialName) != topology->materials.end()) {
+                topology->fileOrderMaterialChanges++;
+            }
+        }
+    }
+
+    // Opaque before transparent, then by material name. Stable, so faces of one
+    // material stay in file order and therefore grouped by object.
+    auto isTransparent = [this](const Face& face) {
+        auto it = topology->materials.find(face.materialName);
+        return it != topology->materials.end() && it->second.transparency < 1.0f;
+    };
+    std::stable_sort(topology->faces.begin(), topology->faces.end(), [&isTransparent](const Face& a, const Face& b) {
+        bool ta = isTransparent(a), tb = isTransparent(b);
+        if (ta != tb) return !ta;
+        return a.materialName < b.materialName;
+    });
+}
+
+void ObjLoader::buildDrawRanges() {
+    TRACE_SCOPE("build draw ranges");
+    topology->drawRanges.clear();
+    for (auto& object : objects) {
+        object.drawRanges.clear();
+    }
+
+    for (size_t f = 0; f < topology->faces.size(); f++) {
+        const Face& face = topology->faces[f];
+        if (topology->drawRanges.empty() ||
+            topology->drawRanges.back().objectIndex != face.objectIndex ||
+            topology->drawRanges.back().materialName != face.materialName) {
+            DrawRange range;
+            range.materialName = face.materialName;
+            auto it = topology->materials.find(face.materialName);
+            range.material = it != topology->materials.end() ? &it->second : nullptr;
+            range.transparent = range.material && range.material->transparency < 1.0f;
+            range.objectIndex = face.objectIndex;
+            range.firstFace = f;
+            objects[face.objectIndex].drawRanges.push_back(topology->drawRanges.size());
+            topology->drawRanges.push_back(range);
+        }
+
+        DrawRange& range = topology->drawRanges.back();
+        range.faceCount++;
+        if (face.vertexIndices.size() >= 3) {
+            range.triangleCount += face.vertexIndices.size() - 2;
+        }
+    }
+}
+
+void ObjLoader::buildTransparentTriangles() {
+    TRACE_SCOPE("transparent triangles");
+    transparentTriangles.clear();
+    transparentSorter.reset();
+
+    for (size_t r = 0; r < topology->drawRanges.size(); r++) {
+        const DrawRange& range = topology->drawRanges[r];
+        if (!range.transparent) continue;
+
+        for (int f = range.firstFace; f < range.firstFace + range.faceCount; f++) {
+            const std::vector<int>& idx = topology->faces[f].vertexIndices;
+            for (size_t i = 1; i + 1 < idx.size(); i++) {
+                TransparentTriangle tri;
+                tri.faceIndex = f;
+                tri.corner = i;
+                tri.rangeIndex = r;
+
+                transparentTriangles.push_back(tri);
+            }
+        }
+    }
+    updateTransparentCentroids();
+}
+
+void ObjLoader::updateTransparentCentroids() {
+    for (auto& tri : transparentTriangles) {
+        const std::vector<int>& idx = topology->faces[tri.faceIndex].vertexIndices;
+        int corners[3] = { idx[0], idx[tri.corner], idx[tri.corner + 1] };
+        tri.centroid = Vec3();
+        for (int k = 0; k < 3; k++) {
+            if (corners[k] < 0 || corners[k] >= (int)vertices.size()) continue;
+            tri.centroid.x += vertices[corners[k]].x / 3.0f;
+            tri.centroid.y += vertices[corners[k]].y / 3.0f;
+            tri.centroid.z += vertices[corners[k]].z / 3.0f;
+        }
+    }
+}
+
 void ObjLoader::draw() {
+    TRACE_SCOPE("draw");
     glPushMatrix();
 
     // Center and scale the model
     glScalef(scale, scale, scale);
     glTranslatef(-center.x, -center.y, -center.z);
 
-    // Draw all faces
-    for (const auto& face : faces) {
-        if (face.vertexIndices.size() == 3) {
-            glBegin(GL_TRIANGLES);
+    cullObjects();
+    auto submitStart = std::chrono::high_resolution_clock::now();
+    RenderBackend* backend = prepareBackend();
+    backend->begin();
+
+    // Draw the ranges of all visible objects
+    for (size_t r = 0; r < topology->drawRanges.size(); r++) {
+        if (!objectVisible[topology->drawRanges[r].objectIndex]) {
+            continue;
+        }
+        drawStats.drawCalls += backend->drawRange(*this, r);
+    }
+
+    backend->end();
+
+    drawStats.submitMs = std::chrono::duration<float, std::milli>(
+        std::chrono::high_resolution_clock::now() - submitStart).count();
+
+    glPopMatrix();
+}
+
+RenderBackend* ObjLoader::prepareBackend() {
+    if (verticesChanged && !backendDirty && renderBackend) {
+        TRACE_SCOPE("update backend vertices");
+        verticesChanged = false;
+        if (!renderBackend->updateVertices(*this)) {
+            backendDirty = true;
+        }
+    }
+    if (!backendDirty && renderBackend) {
+        return renderBackend;
+    }
+    TRACE_SCOPE("prepare backend");
+    backendDirty = false;
+    verticesChanged = false;
+    delete renderBackend;
+    renderBackend = nullptr;
+
+    RenderBackendType type = requestedBackend;
+    while (true) {
+        RenderBackend* backend = createRenderBackend(type);
+        if (backend->prepare(*this) || type == RENDER_IMMEDIATE) {
+            renderBackend = backend;
+            return renderBackend;
         }
-        else if (face.vertexIndices.size() == 4) {
-            glBegin(GL_QUADS);
+        delete backend;
+
+        RenderBackendType fallback = getFallbackBackend(type);
+        std::cerr << "Warning: " << getRenderBackendName(type) << " backend not available, using "
+                  << getRenderBackendName(fallback) << std::endl;
+        type = fallback;
+    }
+}
+
+void ObjLoader::cullObjects() {
+    TRACE_SCOPE("cull");
+    drawStats = DrawStats();
+    objectVisible.assign(objects.size(), 1);
+
+    // Matrices already include the model transform, so culling happens in model space
+    float modelview[16];
+    float projection[16];
+    glGetFloatv(GL_MODELVIEW_MATRIX, modelview);
+    glGetFloatv(GL_PROJECTION_MATRIX, projection);
+
+    Frustum frustum;
+    frustum.extract(modelview, projection);
+
+    if (occlusionCuller) {
+        occlusionCuller->beginFrame(modelview, projection);
+        occlusionCuller->renderOccluders(*this);
+    }
+
+    for (size_t i = 0; i < objects.size(); i++) {
+        const ObjectGroup& object = objects[i];
+        bool visible = true;
+        if (frustumCulling && !frustum.isBoxVisible(object.minBounds, object.maxBounds)) {
+            visible = false;
+        }
+        else if (occlusionCuller && !occlusionCuller->isBoxVisible(object.minBounds, object.maxBounds)) {
+            visible = false;
+            drawStats.objectsOccluded++;
+            drawStats.trianglesOccluded += object.triangleCount;
+        }
+
+        objectVisible[i] = visible;
+        if (visible) {
+            drawStats.objectsDrawn++;
+            drawStats.trianglesDrawn += object.triangleCount;
         }
         else {
-            glBegin(GL_POLYGON);
+            drawStats.objectsCulled++;
+            drawStats.trianglesCulled += object.triangleCount;
         }
+    }
+}
 
-        for (size_t i = 0; i < face.vertexIndices.size(); i++) {
-            // Apply normal if available
-            if (i < face.normalIndices.size()) {
-                int nIdx = face.normalIndices[i];
-                if (nIdx >= 0 && nIdx < normals.size()) {
-                    glNormal3f(normals[nIdx].x, normals[nIdx].y, normals[nIdx].z);
-                }
-            }
+void ObjLoader::drawFace(const Face& face) const {
+    if (face.vertexIndices.size() == 3) {
+        glBegin(GL_TRIANGLES);
+    }
+    else if (face.vertexIndices.size() == 4) {
+        glBegin(GL_QUADS);
+    }
+    else {
+        glBegin(GL_POLYGON);
+    }
 
-            // Apply texture coordinate if available
-            if (i < face.texCoordIndices.size()) {
-                int tIdx = face.texCoordIndices[i];
-                if (tIdx >= 0 && tIdx < texCoords.size()) {
-                    glTexCoord2f(texCoords[tIdx].u, texCoords[tIdx].v);
-                }
-            }
+    for (size_t i = 0; i < face.vertexIndices.size(); i++) {
+        emitVertex(face, i);
+    }
 
-            // Apply vertex
-            int vIdx = face.vertexIndices[i];
-            if (vIdx >= 0 && vIdx < vertices.size()) {
-                glVertex3f(vertices[vIdx].x, vertices[vIdx].y, vertices[vIdx].z);
-            }
+    glEnd();
+}
+
+void ObjLoader::emitVertex(const Face& face, size_t i) const {
+    // Apply normal if available
+    if (i < face.normalIndices.size()) {
+        int nIdx = face.normalIndices[i];
+        if (nIdx >= 0 && nIdx < normals.size()) {
+            glNormal3f(normals[nIdx].x, normals[nIdx].y, normals[nIdx].z);
         }
+    }
+
+    // Apply texture coordinate if available
+    if (i < face.texCoordIndices.size()) {
+        int tIdx = face.texCoordIndices[i];
+        if (tIdx >= 0 && tIdx < topology->texCoords.size()) {
+            glTexCoord2f(topology->texCoords[tIdx].u, topology->texCoords[tIdx].v);
+        }
+    }
+
+    // Apply vertex
+    int vIdx = face.vertexIndices[i];
+    if (vIdx >= 0 && vIdx < vertices.size()) {
+        glVertex3f(vertices[vIdx].x, vertices[vIdx].y, vertices[vIdx].z);
+    }
+}
+
+void ObjLoader::drawFaceHighlight(int faceIndex) {
+    if (faceIndex < 0 || faceIndex >= (int)topology->faces.size()) {
+        return;
+    }
+
+    glPushMatrix();
+
+    // Same model transform as draw()
+    glScalef(scale, scale, scale);
+    glTranslatef(-center.x, -center.y, -center.z);
 
-        glEnd();
+    const Face& face = topology->faces[faceIndex];
+    glBegin(GL_LINE_LOOP);
+    for (size_t i = 0; i < face.vertexIndices.size(); i++) {
+        int vIdx = face.vertexIndices[i];
+        if (vIdx >= 0 && vIdx < vertices.size()) {
+            glVertex3f(vertices[vIdx].x, vertices[vIdx].y, vertices[vIdx].z);
+        }
     }
+    glEnd();
 
     glPopMatrix();
 }
@@ -240,6 +743,7 @@ void ObjLoader::drawWithNormals() {
 }
 
 bool ObjLoader::loadMaterialFile(const std::string& filename) {
+    TRACE_SCOPE_DETAIL("load mtl", filename);
     std::ifstream file(filename);
     if (!file.is_open()) {
         std::cerr << "Warning: Cannot open material file " << filename << std::endl;
@@ -261,7 +765,7 @@ bool ObjLoader::loadMaterialFile(const std::string& filename) {
         if (prefix == "newmtl") {
             // Save previous material
             if (hasMaterial) {
-                materials[currentMatName] = currentMat;
+                topology->materials[currentMatName] = currentMat;
             }
             // Start new material
             iss >> currentMatName;
@@ -276,12 +780,14 @@ bool ObjLoader::loadMaterialFile(const std::string& filename) {
 
     // Save last material
     if (hasMaterial) {
-        materials[currentMatName] = currentMat;
+        topology->materials[currentMatName] = currentMat;
     }
 
     file.close();
 
-    std::cout << "Loaded " << materials.size() << " materials from " << filename << std::endl;
+    if (verbose) {
+        std::cout << "Loaded " << topology->materials.size() << " materials from " << filename << std::endl;
+    }
     return true;
 }
 
@@ -317,7 +823,7 @@ void ObjLoader::parseMaterialLine(const std::string& line, Material& mat) {
     else if (prefix == "map_Kd") {
         // Diffuse texture map
         iss >> mat.diffuseTexture;
-        mat.textureID = loadTexture(objDirectory + mat.diffuseTexture);
+        loadTexture(objDirectory + mat.diffuseTexture, mat);
     }
     else if (prefix == "map_Ka") {
         // Ambient texture map
@@ -333,18 +839,55 @@ void ObjLoader::parseMaterialLine(const std::string& line, Material& mat) {
     }
 }
 
-GLuint ObjLoader::loadTexture(const std::string& filename) {
+void ObjLoader::loadTexture(const std::string& filename, Material& mat) {
+    if (textureLoading == TEXTURES_SKIP) {
+        return;
+    }
+
+    TextureImage image;
+    if (!decodeTexture(filename, image)) {
+        std::cerr << "Warning: Failed to load texture " << filename << std::endl;
+        return;
+    }
+
+    if (textureLoading == TEXTURES_DEFERRED) {
+        mat.pendingTexture.pixels.swap(image.pixels);
+        mat.pendingTexture.width = image.width;
+        mat.pendingTexture.height = image.height;
+        mat.pendingTexture.channels = image.channels;
+    }
+    else {
+        mat.textureID = uploadTexture(image);
+        mat.textureBytes = estimateTextureBytes(image);
+    }
+
+    if (verbose) {
+        std::cout << "Loaded texture: " << filename << " (" << image.width << "x" << image.height
+                  << ", " << image.channels << " channels)" << std::endl;
+    }
+}
+
+bool ObjLoader::decodeTexture(const std::string& filename, TextureImage& image) {
+    TRACE_SCOPE_DETAIL("decode texture", filename);
     int width, height, channels;
     unsigned char* data = stbi_load(filename.c_str(), &width, &height, &channels, 0);
-
     if (!data) {
-        std::cerr << "Warning: Failed to load texture " << filename << std::endl;
-        return 0;
+        return false;
     }
 
+    image.pixels.assign(data, data + (size_t)width * height * channels);
+    image.width = width;
+    image.height = height;
+    image.channels = channels;
+    stbi_image_free(data);
+    return true;
+}
+
+GLuint ObjLoader::uploadTexture(const TextureImage& image) {
+    TRACE_SCOPE("upload texture");
     GLuint textureID;
     glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
+    glState.bindTexture(textureID);
 
     // Set texture parameters
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -353,111 +896,483 @@ GLuint ObjLoader::loadTexture(const std::string& filename) {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
     // Upload texture data with mipmaps (using gluBuild2DMipmaps for legacy OpenGL compatibility)
-    GLenum format = (channels == 4) ? GL_RGBA : GL_RGB;
-    gluBuild2DMipmaps(GL_TEXTURE_2D, format, width, height, format, GL_UNSIGNED_BYTE, data);
+    GLenum format = (image.channels == 4) ? GL_RGBA : GL_RGB;
+    gluBuild2DMipmaps(GL_TEXTURE_2D, format, image.width, image.height, format, GL_UNSIGNED_BYTE,
+                      &image.pixels[0]);
 
-    stbi_image_free(data);
+    return textureID;
+}
 
-    std::cout << "Loaded texture: " << filename << " (" << width << "x" << height << ", " << channels << " channels)" << std::endl;
+int ObjLoader::uploadPendingTextures() {
+    int uploaded = 0;
+    for (auto& matPair : topology->materials) {
+        Material& mat = matPair.second;
+        if (mat.pendingTexture.pixels.empty()) {
+            continue;
+        }
+        mat.textureID = uploadTexture(mat.pendingTexture);
+        mat.textureBytes = estimateTextureBytes(mat.pendingTexture);
+        mat.pendingTexture = TextureImage();
+        uploaded++;
+    }
+    return uploaded;
+}
 
-    return textureID;
+uint64_t ObjLoader::hashVertexData() const {
+    TRACE_SCOPE("hash vertex data");
+    uint64_t hash = vertices.empty() ? 0 : hashBytes(&vertices[0], vertices.size() * sizeof(Vec3), 0);
+    return normals.empty() ? hash : hashBytes(&normals[0], normals.size() * sizeof(Vec3), hash);
 }
 
-void ObjLoader::drawWithMaterials() {
-    glPushMatrix();
+bool ObjLoader::hasSameVertexData(const ObjLoader& other) const {
+    return sharesTopologyWith(other) && vertices.size() == other.vertices.size() &&
+           normals.size() == other.normals.size() &&
+           (vertices.empty() || std::memcmp(&vertices[0], &other.vertices[0], vertices.size() * sizeof(Vec3)) == 0) &&
+           (normals.empty() || std::memcmp(&normals[0], &other.normals[0], normals.size() * sizeof(Vec3)) == 0);
+}
 
-    // Center and scale the model
-    glScalef(scale, scale, scale);
-    glTranslatef(-center.x, -center.y, -center.z);
+bool ObjLoader::shareTopology(const ObjLoader& other) {
+    if (topology == other.topology) {
+        return true;
+    }
+    const MeshTopology& mine = *topology;
+    const MeshTopology& theirs = *other.topology;
 
-    glEnable(GL_TEXTURE_2D);
+    // Face indices must resolve to the same number of positions and normals
+    if (vertices.size() != other.vertices.size() || normals.size() != other.normals.size() ||
+        objects.size() != other.objects.size() || mine.faces.size() != theirs.faces.size() ||
+        mine.materials.size() != theirs.materials.size() || mine.texCoords.size() != theirs.texCoords.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < objects.size(); i++) {
+        if (objects[i].name != other.objects[i].name) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < mine.texCoords.size(); i++) {
+        if (mine.texCoords[i].u != theirs.texCoords[i].u || mine.texCoords[i].v != theirs.texCoords[i].v) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < mine.faces.size(); i++) {
+        if (!sameFace(mine.faces[i], theirs.faces[i])) {
+            return false;
+        }
+    }
+    auto theirMaterial = theirs.materials.begin();
+    for (const auto& matPair : mine.materials) {
+        if (matPair.first != theirMaterial->first || !sameMaterial(matPair.second, theirMaterial->second)) {
+            return false;
+        }
+        ++theirMaterial;
+    }
 
-    // Group faces by material for efficiency
-    std::string lastMaterial;
+    // Same faces and materials give the same draw ranges and transparent triangles,
+    // so only the backend (built from the old topology's indices) has to be redone
+    topology = other.topology;
+    backendDirty = true;
+    return true;
+}
 
-    for (const auto& face : faces) {
-        // Apply material if changed
-        if (face.materialName != lastMaterial) {
-            lastMaterial = face.materialName;
+void ObjLoader::adoptTopology(const ObjLoader& source) {
+    if (topology == source.topology) {
+        return;
+    }
+    // Faces, draw ranges and transparent triangles only depend on the topology
+    topology = source.topology;
+    objects = source.objects;
+    transparentTriangles = source.transparentTriangles;
+    transparentSorter.reset();
+    backendDirty = true;
+}
 
-            if (!face.materialName.empty() && materials.find(face.materialName) != materials.end()) {
-                const Material& mat = materials[face.materialName];
-
-                // Disable color material temporarily to set materials
-                glDisable(GL_COLOR_MATERIAL);
-
-                // --- KODE YANG DIPERBAIKI (Mulai dari sini) ---
-                // Menggunakan properti material yang terpisah (Ka, Kd, Ks, Ns)
-                // yang sudah dibaca dari file .mtl
-                GLfloat ambient[] = { mat.ambient.x, mat.ambient.y, mat.ambient.z, mat.transparency };
-                GLfloat diffuse[] = { mat.diffuse.x, mat.diffuse.y, mat.diffuse.z, mat.transparency };
-                GLfloat specular[] = { mat.specular.x, mat.specular.y, mat.specular.z, mat.transparency };
-
-                glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, ambient);   // <-- Sekarang menggunakan Ka
-                glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, diffuse);   // <-- Menggunakan Kd
-                glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, specular); // <-- Menggunakan Ks
-                glMaterialf(GL_FRONT_AND_BACK, GL_SHININESS, mat.shininess); // <-- Menggunakan Ns
-                // --- KODE YANG DIPERBAIKI (Selesai) ---
-
-                // Bind texture if available
-                if (mat.textureID != 0) {
-                    glBindTexture(GL_TEXTURE_2D, mat.textureID);
-                }
-                else {
-                    glBindTexture(GL_TEXTURE_2D, 0);
-                }
-
-                // Handle transparency
-                if (mat.transparency < 1.0f) {
-                    glEnable(GL_BLEND);
-                    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-                }
-                else {
-                    glDisable(GL_BLEND);
-                }
-            }
+bool ObjLoader::interpolateFrames(const ObjLoader& from, const ObjLoader& to, float t) {
+    if (!from.sharesTopologyWith(to) || from.vertices.size() != to.vertices.size() ||
+        from.normals.size() != to.normals.size()) {
+        return false;
+    }
+    TRACE_SCOPE("interpolate frames");
+
+    if (topology != from.topology) {
+        adoptTopology(from);
+        dynamicVertices = true;
+    }
+
+    vertices.resize(from.vertices.size());
+    for (size_t i = 0; i < vertices.size(); i++) {
+        vertices[i] = lerp(from.vertices[i], to.vertices[i], t);
+    }
+    // Not renormalized: GL_NORMALIZE is on wherever frames are drawn
+    normals.resize(from.normals.size());
+    for (size_t i = 0; i < normals.size(); i++) {
+        normals[i] = lerp(from.normals[i], to.normals[i], t);
+    }
+
+    minBounds = lerp(from.minBounds, to.minBounds, t);
+    maxBounds = lerp(from.maxBounds, to.maxBounds, t);
+    center = lerp(from.center, to.center, t);
+    scale = from.scale + (to.scale - from.scale) * t;
+    calculateObjectBounds();
+    updateTransparentCentroids();
+    verticesChanged = true;
+    vertexVersion++;
+    return true;
+}
+
+void ObjLoader::writeTopology(std::vector<char>& out) const {
+    TopologyWriter writer(out);
+    const MeshTopology& mesh = *topology;
+
+    writer.count(mesh.texCoords.size());
+    if (!mesh.texCoords.empty()) writer.bytes(&mesh.texCoords[0], mesh.texCoords.size() * sizeof(Vec2));
+
+    writer.count(objects.size());
+    for (const auto& object : objects) {
+        writer.string(object.name);
+        writer.value((int32_t)object.faceCount);
+    }
+
+    writer.count(mesh.materials.size());
+    for (const auto& matPair : mesh.materials) {
+        const Material& mat = matPair.second;
+        writer.string(matPair.first);
+        writer.string(mat.name);
+        writer.value(mat.ambient);
+        writer.value(mat.diffuse);
+        writer.value(mat.specular);
+        writer.value(mat.shininess);
+        writer.value(mat.transparency);
+        writer.value((int32_t)mat.illum);
+        writer.string(mat.ambientTexture);
+        writer.string(mat.diffuseTexture);
+        writer.string(mat.specularTexture);
+        writer.string(mat.bumpTexture);
+    }
+    writer.value((int32_t)mesh.fileOrderMaterialChanges);
+
+    // Already sorted by material, so the reader only rebuilds the draw ranges
+    writer.count(mesh.faces.size());
+    for (const auto& face : mesh.faces) {
+        writer.ints(face.vertexIndices);
+        writer.ints(face.texCoordIndices);
+        writer.ints(face.normalIndices);
+        writer.string(face.materialName);
+        writer.value((int32_t)face.objectIndex);
+    }
+}
+
+bool ObjLoader::readTopology(const char* data, size_t size, const std::string& directory) {
+    TRACE_SCOPE("read topology");
+    TopologyReader reader(data, size);
+    std::shared_ptr<MeshTopology> mesh(new MeshTopology());
+    std::vector<ObjectGroup> newObjects;
+
+    mesh->texCoords.resize(reader.count(sizeof(Vec2)));
+    if (!mesh->texCoords.empty()) reader.bytes(&mesh->texCoords[0], mesh->texCoords.size() * sizeof(Vec2));
+
+    newObjects.resize(reader.count(sizeof(uint32_t) + sizeof(int32_t)));
+    for (auto& object : newObjects) {
+        object.name = reader.string();
+        object.faceCount = reader.value<int32_t>();
+    }
+
+    size_t materialCount = reader.count(1);
+    for (size_t i = 0; i < materialCount && reader.ok; i++) {
+        std::string key = reader.string();
+        Material& mat = mesh->materials[key];
+        mat.name = reader.string();
+        mat.ambient = reader.value<Vec3>();
+        mat.diffuse = reader.value<Vec3>();
+        mat.specular = reader.value<Vec3>();
+        mat.shininess = reader.value<float>();
+        mat.transparency = reader.value<float>();
+        mat.illum = reader.value<int32_t>();
+        mat.ambientTexture = reader.string();
+        mat.diffuseTexture = reader.string();
+        mat.specularTexture = reader.string();
+        mat.bumpTexture = reader.string();
+    }
+    mesh->fileOrderMaterialChanges = reader.value<int32_t>();
+
+    mesh->faces.resize(reader.count(3 * sizeof(uint32_t) + sizeof(uint32_t) + sizeof(int32_t)));
+    for (auto& face : mesh->faces) {
+        reader.ints(face.vertexIndices);
+        reader.ints(face.texCoordIndices);
+        reader.ints(face.normalIndices);
+        face.materialName = reader.string();
+        face.objectIndex = reader.value<int32_t>();
+        if (face.objectIndex < 0 || face.objectIndex >= (int)newObjects.size()) {
+            reader.ok = false;
         }
+        if (!reader.ok) break;
+    }
+    if (!reader.ok) {
+        std::cerr << "Error: Corrupt topology block" << std::endl;
+        return false;
+    }
 
-        // Draw the face
-        if (face.vertexIndices.size() == 3) {
-            glBegin(GL_TRIANGLES);
+    topology = mesh;
+    objects.swap(newObjects);
+    objDirectory = directory;
+    for (auto& matPair : topology->materials) {
+        Material& mat = matPair.second;
+        if (!mat.diffuseTexture.empty()) {
+            loadTexture(objDirectory + mat.diffuseTexture, mat);
         }
-        else if (face.vertexIndices.size() == 4) {
-            glBegin(GL_QUADS);
+    }
+
+    vertices.clear();
+    normals.clear();
+    buildDrawRanges();
+    buildTransparentTriangles();
+    backendDirty = true;
+    vertexVersion++;
+    return true;
+}
+
+void ObjLoader::setFrameVertices(const Vec3* positions, size_t positionCount, const Vec3* frameNormals,
+                                 size_t normalCount) {
+    TRACE_SCOPE("set frame vertices");
+    vertices.assign(positions, positions + positionCount);
+    normals.assign(frameNormals, frameNormals + normalCount);
+
+    minBounds = Vec3(1e10, 1e10, 1e10);
+    maxBounds = Vec3(-1e10, -1e10, -1e10);
+    for (const Vec3& v : vertices) {
+        minBounds = Vec3(std::min(minBounds.x, v.x), std::min(minBounds.y, v.y), std::min(minBounds.z, v.z));
+        maxBounds = Vec3(std::max(maxBounds.x, v.x), std::max(maxBounds.y, v.y), std::max(maxBounds.z, v.z));
+    }
+    calculateBounds();
+    calculateObjectBounds();
+    updateTransparentCentroids();
+    verticesChanged = true;
+    vertexVersion++;
+}
+
+MemoryUsage ObjLoader::getMemoryUsage(bool includeTopology) const {
+    MemoryUsage usage;
+    addVector(vertices, usage.positions, usage.slack);
+    addVector(normals, usage.normals, usage.slack);
+
+    if (includeTopology) {
+        addVector(topology->texCoords, usage.texCoords, usage.slack);
+
+        addVector(topology->faces, usage.faceRecords, usage.slack);
+        for (const auto& face : topology->faces) {
+            addVector(face.vertexIndices, usage.faceIndices, usage.slack);
+            addVector(face.texCoordIndices, usage.faceIndices, usage.slack);
+            addVector(face.normalIndices, usage.faceIndices, usage.slack);
+            usage.strings += stringHeapBytes(face.materialName);
+        }
+
+        for (const auto& matPair : topology->materials) {
+            const Material& mat = matPair.second;
+            usage.materials += sizeof(matPair) + 4 * sizeof(void*);  // Red-black tree node
+            usage.strings += stringHeapBytes(matPair.first) + stringHeapBytes(mat.name) +
+                             stringHeapBytes(mat.ambientTexture) + stringHeapBytes(mat.diffuseTexture) +
+                             stringHeapBytes(mat.specularTexture) + stringHeapBytes(mat.bumpTexture);
+            addVector(mat.pendingTexture.pixels, usage.textureCpu, usage.slack);
+            usage.textureGpu += mat.textureBytes;
+        }
+
+        addVector(topology->drawRanges, usage.meshTables, usage.slack);
+        for (const auto& range : topology->drawRanges) {
+            usage.strings += stringHeapBytes(range.materialName);
+        }
+        usage.meshTables += sizeof(MeshTopology);
+    }
+
+    addVector(objects, usage.meshTables, usage.slack);
+    for (const auto& object : objects) {
+        addVector(object.drawRanges, usage.meshTables, usage.slack);
+        usage.strings += stringHeapBytes(object.name);
+    }
+    addVector(objectVisible, usage.meshTables, usage.slack);
+    addVector(transparentTriangles, usage.meshTables, usage.slack);
+    addVector(transparentDepths, usage.meshTables, usage.slack);
+    usage.strings += stringHeapBytes(currentMaterial) + stringHeapBytes(currentObject) +
+                     stringHeapBytes(objDirectory);
+
+    if (renderBackend) {
+        usage.backendCpu += renderBackend->getStagingBytes();
+        size_t retained = renderBackend->getRetainedBytes();
+        if (renderBackend->getType() == RENDER_BUFFERS) {
+            usage.backendGpu += retained;
         }
         else {
-            glBegin(GL_POLYGON);
+            usage.backendCpu += retained;
         }
+    }
+    return usage;
+}
 
-        for (size_t i = 0; i < face.vertexIndices.size(); i++) {
-            // Apply normal if available
-            if (i < face.normalIndices.size()) {
-                int nIdx = face.normalIndices[i];
-                if (nIdx >= 0 && nIdx < normals.size()) {
-                    glNormal3f(normals[nIdx].x, normals[nIdx].y, normals[nIdx].z);
-                }
-            }
+size_t MemoryUsage::getCpuBytes() const {
+    return positions + normals + texCoords + faceIndices + faceRecords + materials + meshTables +
+           strings + textureCpu + backendCpu + slack;
+}
 
-            // Apply texture coordinate if available
-            if (i < face.texCoordIndices.size()) {
-                int tIdx = face.texCoordIndices[i];
-                if (tIdx >= 0 && tIdx < texCoords.size()) {
-                    glTexCoord2f(texCoords[tIdx].u, texCoords[tIdx].v);
-                }
-            }
+MemoryUsage& MemoryUsage::operator+=(const MemoryUsage& other) {
+    positions += other.positions;
+    normals += other.normals;
+    texCoords += other.texCoords;
+    faceIndices += other.faceIndices;
+    faceRecords += other.faceRecords;
+    materials += other.materials;
+    meshTables += other.meshTables;
+    strings += other.strings;
+    textureCpu += other.textureCpu;
+    backendCpu += other.backendCpu;
+    slack += other.slack;
+    textureGpu += other.textureGpu;
+    backendGpu += other.backendGpu;
+    return *this;
+}
 
-            // Apply vertex
-            int vIdx = face.vertexIndices[i];
-            if (vIdx >= 0 && vIdx < vertices.size()) {
-                glVertex3f(vertices[vIdx].x, vertices[vIdx].y, vertices[vIdx].z);
-            }
+void MemoryUsage::print(std::ostream& out) const {
+    const struct { const char* name; size_t bytes; } rows[] = {
+        { "Positions", positions }, { "Normals", normals }, { "Texture coords", texCoords },
+        { "Face indices", faceIndices }, { "Face records", faceRecords }, { "Materials", materials },
+        { "Mesh tables", meshTables }, { "Strings", strings }, { "Texture pixels (CPU)", textureCpu },
+        { "Backend (CPU)", backendCpu }, { "Vector slack", slack },
+        { "Textures (GPU, est.)", textureGpu }, { "Backend (GPU)", backendGpu }
+    };
+    std::ios::fmtflags flags = out.flags();
+    out << std::fixed << std::setprecision(1);
+    for (const auto& row : rows) {
+        if (row.bytes > 0) {
+            out << "  " << std::left << std::setw(22) << row.name << std::right << std::setw(12)
+                << row.bytes / 1024.0 << " KB" << std::endl;
+        }
+    }
+    out << "  " << std::left << std::setw(22) << "Total CPU / GPU" << std::right << std::setw(12)
+        << getCpuBytes() / 1024.0 << " KB / " << getGpuBytes() / 1024.0 << " KB" << std::endl;
+    out.flags(flags);
+}
+
+void ObjLoader::applyMaterial(const Material& mat) {
+    // Disable color material temporarily to set materials
+    // (all state goes through glState, which drops values GL already has)
+    glState.disable(GL_COLOR_MATERIAL);
+
+    // --- KODE YANG DIPERBAIKI (Mulai dari sini) ---
+    // Menggunakan properti material yang terpisah (Ka, Kd, Ks, Ns)
+    // yang sudah dibaca dari file .mtl
+    GLfloat ambient[] = { mat.ambient.x, mat.ambient.y, mat.ambient.z, mat.transparency };
+    GLfloat diffuse[] = { mat.diffuse.x, mat.diffuse.y, mat.diffuse.z, mat.transparency };
+    GLfloat specular[] = { mat.specular.x, mat.specular.y, mat.specular.z, mat.transparency };
+
+    glState.materialfv(GL_FRONT_AND_BACK, GL_AMBIENT, ambient);   // <-- Sekarang menggunakan Ka
+    glState.materialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, diffuse);   // <-- Menggunakan Kd
+    glState.materialfv(GL_FRONT_AND_BACK, GL_SPECULAR, specular); // <-- Menggunakan Ks
+    glState.materialf(GL_FRONT_AND_BACK, GL_SHININESS, mat.shininess); // <-- Menggunakan Ns
+    // --- KODE YANG DIPERBAIKI (Selesai) ---
+
+    // Bind texture if available
+    glState.bindTexture(mat.textureID);
+
+    // Handle transparency
+    if (mat.transparency < 1.0f) {
+        glState.enable(GL_BLEND);
+        glState.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    }
+    else {
+        glState.disable(GL_BLEND);
+    }
+
+    drawStats.materialChanges++;
+}
+
+void ObjLoader::drawWithMaterials() {
+    TRACE_SCOPE("draw");
+    glPushMatrix();
+
+    // Center and scale the model
+    glScalef(scale, scale, scale);
+    glTranslatef(-center.x, -center.y, -center.z);
+
+    cullObjects();
+
+    glState.enable(GL_TEXTURE_2D);
+
+    // Ranges are sorted by material, so each material is applied once
+    const Material* lastMaterial = nullptr;
+
+    auto submitStart = std::chrono::high_resolution_clock::now();
+    RenderBackend* backend = prepareBackend();
+    backend->begin();
+
+    for (size_t r = 0; r < topology->drawRanges.size(); r++) {
+        const DrawRange& range = topology->drawRanges[r];
+        if (!objectVisible[range.objectIndex] || range.transparent) {
+            continue;
+        }
+
+        if (range.material && range.material != lastMaterial) {
+            lastMaterial = range.material;
+            applyMaterial(*range.material);
         }
 
-        glEnd();
+        drawStats.drawCalls += backend->drawRange(*this, r);
     }
 
-    glDisable(GL_TEXTURE_2D);
-    glDisable(GL_BLEND);
+    backend->end();
+
+    // Blended geometry last, back to front
+    drawTransparent();
+
+    drawStats.submitMs = std::chrono::duration<float, std::milli>(
+        std::chrono::high_resolution_clock::now() - submitStart).count();
+
+    glState.disable(GL_TEXTURE_2D);
+    glState.disable(GL_BLEND);
 
     glPopMatrix();
-}
\ No newline at end of file
+}
+
+void ObjLoader::drawTransparent() {
+    if (transparentTriangles.empty()) {
+        return;
+    }
+    TRACE_SCOPE("draw transparent");
+
+    // Eye-space z of each centroid only needs the third row of the modelview
+    float modelview[16];
+    glGetFloatv(GL_MODELVIEW_MATRIX, modelview);
+    transparentDepths.resize(transparentTriangles.size());
+    for (size_t i = 0; i < transparentTriangles.size(); i++) {
+        const Vec3& c = transparentTriangles[i].centroid;
+        transparentDepths[i] = modelview[2] * c.x + modelview[6] * c.y + modelview[10] * c.z + modelview[14];
+    }
+
+    const std::vector<int>& order = transparentSorter.sort(transparentDepths);
+    drawStats.transparentSortMs = transparentSorter.getLastSortMs();
+
+    // Sorted surfaces must not hide each other through the depth buffer
+    glState.depthMask(GL_FALSE);
+
+    const Material* lastMaterial = nullptr;
+    for (int index : order) {
+        const TransparentTriangle& tri = transparentTriangles[index];
+        const DrawRange& range = topology->drawRanges[tri.rangeIndex];
+        if (!objectVisible[range.objectIndex]) {
+            continue;
+        }
+
+        if (range.material != lastMaterial) {
+            if (lastMaterial) glEnd();
+            lastMaterial = range.material;
+            applyMaterial(*range.material);
+            glBegin(GL_TRIANGLES);
+            drawStats.drawCalls++;
+        }
+
+        const Face& face = topology->faces[tri.faceIndex];
+        emitVertex(face, 0);
+        emitVertex(face, tri.corner);
+        emitVertex(face, tri.corner + 1);
+        drawStats.transparentTriangles++;
+    }
+    if (lastMaterial) glEnd();
+
+    glState.depthMask(GL_TRUE);
+}
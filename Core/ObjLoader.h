@@ -4,7 +4,12 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <memory>
+#include <iosfwd>
+#include <cstdint>
 #include <GL/glut.h>
+#include "DepthSorter.h"
+#include "RenderBackend.h"
 
 struct Vec3 {
     float x, y, z;
@@ -12,12 +17,26 @@ struct Vec3 {
     Vec3(float x, float y, float z) : x(x), y(y), z(z) {}
 };
 
+// a + (b - a) * t per component
+inline Vec3 lerp(const Vec3& a, const Vec3& b, float t) {
+    return Vec3(a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t);
+}
+
 struct Vec2 {
     float u, v;
     Vec2() : u(0), v(0) {}
     Vec2(float u, float v) : u(u), v(v) {}
 };
 
+// Decoded texture pixels waiting for a GL context (TEXTURES_DEFERRED)
+struct TextureImage {
+    std::vector<unsigned char> pixels;
+    int width;
+    int height;
+    int channels;
+    TextureImage() : width(0), height(0), channels(0) {}
+};
+
 struct Material {
     std::string name;
     Vec3 ambient;      // Ka
@@ -33,6 +52,8 @@ struct Material {
     std::string bumpTexture;     // map_Bump or bump
     
     GLuint textureID;  // OpenGL texture ID
+    size_t textureBytes;          // Estimated GPU memory of textureID, mipmaps included
+    TextureImage pendingTexture;  // map_Kd pixels not yet uploaded
     
     Material() : ambient(0.2f, 0.2f, 0.2f), 
                  diffuse(0.8f, 0.8f, 0.8f),
@@ -40,7 +61,8 @@ struct Material {
                  shininess(32.0f),
                  transparency(1.0f),
                  illum(2),
-                 textureID(0) {}
+                 textureID(0),
+                 textureBytes(0) {}
 };
 
 struct Face {
@@ -48,15 +70,130 @@ struct Face {
     std::vector<int> texCoordIndices;
     std::vector<int> normalIndices;
     std::string materialName;
+    int objectIndex;   // Index into ObjLoader::getObjects(), from o/g records
+    Face() : objectIndex(-1) {}
+};
+
+// A named o/g record. Its faces are spread over one draw range per material.
+struct ObjectGroup {
+    std::string name;
+    int faceCount;
+    int triangleCount;            // After fan triangulation
+    Vec3 minBounds;               // Model-space AABB, used for frustum culling
+    Vec3 maxBounds;
+    std::vector<int> drawRanges;  // Indices into ObjLoader::getDrawRanges()
+    ObjectGroup() : faceCount(0), triangleCount(0) {}
+};
+
+// Contiguous run of faces with one material and one object. Faces are stably
+// sorted by material at load time (opaque first, transparent last), so walking
+// the ranges in order binds every material once per frame.
+struct DrawRange {
+    std::string materialName;
+    const Material* material;  // nullptr if the name has no .mtl entry
+    int objectIndex;
+    int firstFace;
+    int faceCount;
+    int triangleCount;
+    bool transparent;
+    DrawRange() : material(nullptr), objectIndex(0), firstFace(0), faceCount(0),
+                  triangleCount(0), transparent(false) {}
+};
+
+// One fan triangle (0, corner, corner + 1) of a face in a transparent draw range.
+// These are depth sorted every frame and drawn back to front.
+struct TransparentTriangle {
+    int faceIndex;
+    int corner;
+    int rangeIndex;
+    Vec3 centroid;
+};
+
+// Per-draw counters, reset on every draw()/drawWithMaterials() call
+struct DrawStats {
+    int objectsDrawn;
+    int objectsCulled;
+    int trianglesDrawn;
+    int trianglesCulled;
+    int objectsOccluded;    // Subset of the culled counts rejected by the occlusion culler
+    int trianglesOccluded;
+    int materialChanges;    // Material state applications in drawWithMaterials()
+    int drawCalls;          // GL draw calls (glDrawElements, glCallList, glBegin) issued
+    int transparentTriangles;
+    float transparentSortMs;
+    float submitMs;         // CPU time spent issuing GL calls for the draw
+    DrawStats() : objectsDrawn(0), objectsCulled(0), trianglesDrawn(0), trianglesCulled(0),
+                  objectsOccluded(0), trianglesOccluded(0), materialChanges(0),
+                  drawCalls(0), transparentTriangles(0), transparentSortMs(0.0f), submitMs(0.0f) {}
+};
+
+// Bytes held by a loaded model, per kind of data (ObjLoader::getMemoryUsage()).
+// Vector fields count size(); the unused capacity of every vector is summed in
+// 'slack'. GPU figures are estimates: the driver may pad or compress.
+struct MemoryUsage {
+    size_t positions;       // v
+    size_t normals;         // vn
+    size_t texCoords;       // vt
+    size_t faceIndices;     // Per-corner vertex/texcoord/normal indices
+    size_t faceRecords;     // Face structs themselves
+    size_t materials;       // Material table entries (map nodes)
+    size_t meshTables;      // Objects, draw ranges, transparent triangles, culling flags
+    size_t strings;         // Heap-allocated names (faces, materials, objects, textures)
+    size_t textureCpu;      // Decoded pixels waiting for uploadPendingTextures()
+    size_t backendCpu;      // Render backend copies in client memory (vertex arrays)
+    size_t slack;           // std::vector capacity beyond size()
+    size_t textureGpu;
+    size_t backendGpu;      // VBO/IBO
+    MemoryUsage() : positions(0), normals(0), texCoords(0), faceIndices(0), faceRecords(0),
+                    materials(0), meshTables(0), strings(0), textureCpu(0), backendCpu(0),
+                    slack(0), textureGpu(0), backendGpu(0) {}
+
+    size_t getCpuBytes() const;
+    size_t getGpuBytes() const { return textureGpu + backendGpu; }
+    MemoryUsage& operator+=(const MemoryUsage& other);
+    // One line per non-empty category, in KB
+    void print(std::ostream& out) const;
+};
+
+// What loadObj() does with map_Kd textures
+enum TextureLoading {
+    TEXTURES_UPLOAD,    // Decode and upload while loading (needs a current GL context)
+    TEXTURES_DEFERRED,  // Decode only; uploadPendingTextures() later on the GL thread
+    TEXTURES_SKIP       // Keep the file names, never decode
 };
 
+// Connectivity and materials of a loaded model: everything except the
+// per-vertex positions and normals. Frames of a vertex-animation sequence
+// share one (ObjLoader::shareTopology()); it owns the material textures.
+struct MeshTopology {
+    std::vector<Vec2> texCoords;
+    std::vector<Face> faces;
+    std::map<std::string, Material> materials;
+    std::vector<DrawRange> drawRanges;  // Material pointers point into 'materials'
+    int fileOrderMaterialChanges;       // Material switches when walking faces in file order
+    MeshTopology() : fileOrderMaterialChanges(0) {}
+    ~MeshTopology();
+};
+
+class Frustum;
+class OcclusionCuller;
+
 class ObjLoader {
 private:
     std::vector<Vec3> vertices;
     std::vector<Vec3> normals;
-    std::vector<Vec2> texCoords;
-    std::vector<Face> faces;
-    std::map<std::string, Material> materials;
+    std::shared_ptr<MeshTopology> topology;  // Possibly shared with other frames
+    std::vector<ObjectGroup> objects;  // Per model: the bounds depend on the positions
+    std::vector<char> objectVisible;   // Per-object culling result of the current draw
+    RenderBackend* renderBackend;      // Submits opaque range geometry, created on first draw
+    RenderBackendType requestedBackend;
+    bool backendDirty;                 // Recreate and prepare the backend on the next draw
+    bool dynamicVertices;              // Positions change after load (interpolateFrames())
+    bool verticesChanged;              // Refresh the backend's copy on the next draw
+    unsigned int vertexVersion;        // Bumped whenever the positions are replaced
+    std::vector<TransparentTriangle> transparentTriangles;
+    std::vector<float> transparentDepths;
+    DepthSorter transparentSorter;
     
     Vec3 minBounds;
     Vec3 maxBounds;
@@ -64,38 +201,138 @@ private:
     float scale;
     
     std::string currentMaterial;
+    std::string currentObject;
+    bool objectChanged;
+
+    bool frustumCulling;
+    OcclusionCuller* occlusionCuller;
+    DrawStats drawStats;
     std::string objDirectory;
+    TextureLoading textureLoading;
+    bool verbose;                      // Print the load summary to std::cout
 
     void calculateBounds();
+    void calculateObjectBounds();
+    void sortFacesByMaterial();
+    void buildDrawRanges();
+    void buildTransparentTriangles();
+    void updateTransparentCentroids();
+    void cullObjects();
+    RenderBackend* prepareBackend();
+    void drawTransparent();
     void parseLine(const std::string& line);
     void parseFace(const std::string& line);
     bool loadMaterialFile(const std::string& filename);
     void parseMaterialLine(const std::string& line, Material& mat);
-    GLuint loadTexture(const std::string& filename);
+    void loadTexture(const std::string& filename, Material& mat);
+    static bool decodeTexture(const std::string& filename, TextureImage& image);
+    static GLuint uploadTexture(const TextureImage& image);
     std::string getDirectory(const std::string& filepath);
 
 public:
     ObjLoader();
     ~ObjLoader();
     bool loadObj(const std::string& filename);
+
+    // Without a GL context (tools, benchmarks, loader threads) use
+    // TEXTURES_DEFERRED or TEXTURES_SKIP; both make loadObj() GL-free
+    void setTextureLoading(TextureLoading mode) { textureLoading = mode; }
+    TextureLoading getTextureLoading() const { return textureLoading; }
+    // Uploads textures decoded by TEXTURES_DEFERRED; returns how many
+    int uploadPendingTextures();
+    // Switches to other's topology (faces, texture coordinates, materials and
+    // their textures) if it is identical to this model's, as in the frames of a
+    // vertex animation; only the positions and normals then stay per model.
+    // Returns false, changing nothing, if anything differs.
+    bool shareTopology(const ObjLoader& other);
+    bool sharesTopologyWith(const ObjLoader& other) const { return topology == other.topology; }
+    // 64-bit hash of the positions and normals (SSE2 where available), for
+    // finding identical animation frames; confirm with hasSameVertexData()
+    uint64_t hashVertexData() const;
+    // Shared topology and bitwise equal positions and normals
+    bool hasSameVertexData(const ObjLoader& other) const;
+    // Makes this model the blend from + (to - from) * t of two frames that
+    // share a topology (which this model then shares too): positions, normals,
+    // object bounds, center and scale. The render backend refreshes its vertex
+    // copy on the next draw instead of being rebuilt. False if the frames do
+    // not share a topology.
+    bool interpolateFrames(const ObjLoader& from, const ObjLoader& to, float t);
+    bool hasDynamicVertices() const { return dynamicVertices; }
+    // Changes whenever the positions do (load, interpolateFrames(),
+    // setFrameVertices()), so caches built from them can tell they are stale
+    unsigned int getVertexVersion() const { return vertexVersion; }
+    // Takes source's topology without comparing it; the caller guarantees the
+    // positions and normals set next fit it (frames of one .anim container)
+    void adoptTopology(const ObjLoader& source);
+
+    // Binary topology block of .anim containers (AnimContainer.h): texture
+    // coordinates, objects, materials and faces in draw order
+    void writeTopology(std::vector<char>& out) const;
+    // Replaces the model with a topology block and no vertices; textures are
+    // loaded from 'directory' as set by setTextureLoading(). False if the
+    // block is malformed, changing nothing.
+    bool readTopology(const char* data, size_t size, const std::string& directory);
+    // Copies one frame's positions and normals and recomputes the bounds
+    void setFrameVertices(const Vec3* positions, size_t positionCount, const Vec3* normals, size_t normalCount);
+    void setVerbose(bool enabled) { verbose = enabled; }
     void draw();
     void drawWithNormals();
     void drawWithMaterials();
+    void drawFaceHighlight(int faceIndex);
+
+    // Material state as used by drawWithMaterials() (counted in the draw stats)
+    void applyMaterial(const Material& mat);
+
+    // Immediate-mode face submission, also used by the render backends
+    void drawFace(const Face& face) const;
+    void emitVertex(const Face& face, size_t i) const;
     
     // Getters
     Vec3 getCenter() const { return center; }
     float getScale() const { return scale; }
     int getVertexCount() const { return vertices.size(); }
-    int getFaceCount() const { return faces.size(); }
-    int getMaterialCount() const { return materials.size(); }
-    bool hasMaterials() const { return !materials.empty(); }
+    int getFaceCount() const { return topology->faces.size(); }
+    int getMaterialCount() const { return topology->materials.size(); }
+    int getObjectCount() const { return objects.size(); }
+    bool hasMaterials() const { return !topology->materials.empty(); }
+
+    // Frustum culling per o/g object (on by default)
+    void setFrustumCulling(bool enabled) { frustumCulling = enabled; }
+    bool isFrustumCulling() const { return frustumCulling; }
+
+    // Geometry submission path (VBO by default). The backend is built on the next
+    // draw and falls back (vbo -> lists -> immediate) if the context lacks support.
+    // Requesting the type already requested keeps the built backend.
+    void setRenderBackend(RenderBackendType type) {
+        if (type != requestedBackend) {
+            requestedBackend = type;
+            backendDirty = true;
+        }
+    }
+    RenderBackendType getRenderBackendType() const {
+        return (renderBackend && !backendDirty) ? renderBackend->getType() : requestedBackend;
+    }
+    const RenderBackend* getRenderBackend() const { return renderBackend; }
+    void invalidateRenderBackend() { backendDirty = true; }
+
+    // Optional CPU occlusion culling (not owned; nullptr disables)
+    void setOcclusionCuller(OcclusionCuller* culler) { occlusionCuller = culler; }
+    OcclusionCuller* getOcclusionCuller() const { return occlusionCuller; }
+    const DrawStats& getDrawStats() const { return drawStats; }
     
     // Data access for animation (returns const references)
     const std::vector<Vec3>& getVertices() const { return vertices; }
     const std::vector<Vec3>& getNormals() const { return normals; }
-    const std::vector<Vec2>& getTexCoords() const { return texCoords; }
-    const std::vector<Face>& getFaces() const { return faces; }
-    const std::map<std::string, Material>& getMaterials() const { return materials; }
+    const std::vector<Vec2>& getTexCoords() const { return topology->texCoords; }
+    const std::vector<Face>& getFaces() const { return topology->faces; }
+    const std::map<std::string, Material>& getMaterials() const { return topology->materials; }
+    const std::vector<ObjectGroup>& getObjects() const { return objects; }
+    const std::vector<DrawRange>& getDrawRanges() const { return topology->drawRanges; }
+    int getFileOrderMaterialChanges() const { return topology->fileOrderMaterialChanges; }
+    int getTransparentTriangleCount() const { return transparentTriangles.size(); }
+    // Walks every container; cheap enough for on-demand reports, not per frame.
+    // Without 'includeTopology' a shared topology is left out (counted once by its first user).
+    MemoryUsage getMemoryUsage(bool includeTopology = true) const;
     
     // Type aliases for AnimationLoader to use
     typedef Vec3 Vec3;
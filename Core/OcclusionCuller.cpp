@@ -0,0 +1,320 @@
+#include "OcclusionCuller.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define OCCLUSION_USE_SSE
+#endif
+
+namespace {
+    const float kNearW = 1e-5f;
+
+    // out = m * (x, y, z, 1), column-major
+    inline void transformPoint(const float* m, float x, float y, float z, float* out) {
+        for (int row = 0; row < 4; row++) {
+            out[row] = m[row] * x + m[4 + row] * y + m[8 + row] * z + m[12 + row];
+        }
+    }
+
+    struct Candidate {
+        int objectIndex;
+        float area;
+    };
+}
+
+OcclusionCuller::OcclusionCuller(int w, int h)
+    : threadCount(1), maxOccluders(16), maxOccluderTriangles(4096) {
+    // Width and height are kept multiples of the tile size so SIMD rows and tiles never overrun
+    width = std::max(kTileSize, (w + kTileSize - 1) / kTileSize * kTileSize);
+    height = std::max(kTileSize, (h + kTileSize - 1) / kTileSize * kTileSize);
+    tilesX = width / kTileSize;
+    tilesY = height / kTileSize;
+    depth.assign(width * height, 1.0f);
+    tileMaxDepth.assign(tilesX * tilesY, 1.0f);
+    for (int i = 0; i < 16; i++) mvp[i] = (i % 5 == 0) ? 1.0f : 0.0f;
+
+    unsigned int hw = std::thread::hardware_concurrency();
+    setThreadCount(hw > 0 ? std::min(hw, 4u) : 1);
+}
+
+void OcclusionCuller::setThreadCount(int count) {
+    threadCount = std::max(1, std::min(count, tilesY));
+}
+
+void OcclusionCuller::beginFrame(const float* modelview, const float* projection) {
+    for (int col = 0; col < 4; col++) {
+        for (int row = 0; row < 4; row++) {
+            mvp[col * 4 + row] =
+                projection[0 * 4 + row] * modelview[col * 4 + 0] +
+                projection[1 * 4 + row] * modelview[col * 4 + 1] +
+                projection[2 * 4 + row] * modelview[col * 4 + 2] +
+                projection[3 * 4 + row] * modelview[col * 4 + 3];
+        }
+    }
+
+    std::fill(depth.begin(), depth.end(), 1.0f);
+    std::fill(tileMaxDepth.begin(), tileMaxDepth.end(), 1.0f);
+    screenTriangles.clear();
+    stats = OcclusionStats();
+}
+
+bool OcclusionCuller::projectBox(const Vec3& mn, const Vec3& mx,
+                                 float& minX, float& minY, float& maxX, float& maxY, float& minZ) const {
+    minX = minY = minZ = 1e30f;
+    maxX = maxY = -1e30f;
+    for (int i = 0; i < 8; i++) {
+        float clip[4];
+        transformPoint(mvp, (i & 1) ? mx.x : mn.x, (i & 2) ? mx.y : mn.y, (i & 4) ? mx.z : mn.z, clip);
+        if (clip[3] <= kNearW) {
+            return false;  // Crosses the camera plane
+        }
+        float invW = 1.0f / clip[3];
+        float sx = (clip[0] * invW * 0.5f + 0.5f) * width;
+        float sy = (clip[1] * invW * 0.5f + 0.5f) * height;
+        float sz = clip[2] * invW * 0.5f + 0.5f;
+        minX = std::min(minX, sx); maxX = std::max(maxX, sx);
+        minY = std::min(minY, sy); maxY = std::max(maxY, sy);
+        minZ = std::min(minZ, sz);
+    }
+    return true;
+}
+
+void OcclusionCuller::addOccluder(const ObjLoader& model, const ObjectGroup& object) {
+    const std::vector<DrawRange>& ranges = model.getDrawRanges();
+    for (int r : object.drawRanges) {
+        for (int f = ranges[r].firstFace; f < ranges[r].firstFace + ranges[r].faceCount; f++) {
+            addOccluderFace(model, model.getFaces()[f]);
+        }
+    }
+}
+
+void OcclusionCuller::addOccluderFace(const ObjLoader& model, const Face& face) {
+    const std::vector<Vec3>& vertices = model.getVertices();
+    const std::vector<int>& idx = face.vertexIndices;
+
+    for (size_t i = 1; i + 1 < idx.size(); i++) {
+        int corner[3] = { idx[0], idx[i], idx[i + 1] };
+        ScreenTriangle tri;
+        bool valid = true;
+        for (int k = 0; k < 3 && valid; k++) {
+            if (corner[k] < 0 || corner[k] >= (int)vertices.size()) {
+                valid = false;
+                break;
+            }
+            const Vec3& v = vertices[corner[k]];
+            float clip[4];
+            transformPoint(mvp, v.x, v.y, v.z, clip);
+            // Occluders are not clipped: dropping a triangle only makes culling less aggressive
+            if (clip[3] <= kNearW) {
+                valid = false;
+                break;
+            }
+            float invW = 1.0f / clip[3];
+            tri.x[k] = (clip[0] * invW * 0.5f + 0.5f) * width;
+            tri.y[k] = (clip[1] * invW * 0.5f + 0.5f) * height;
+            tri.z[k] = clip[2] * invW * 0.5f + 0.5f;
+        }
+        if (!valid) continue;
+
+        float triMinX = std::min({ tri.x[0], tri.x[1], tri.x[2] });
+        float triMaxX = std::max({ tri.x[0], tri.x[1], tri.x[2] });
+        float triMinY = std::min({ tri.y[0], tri.y[1], tri.y[2] });
+        float triMaxY = std::max({ tri.y[0], tri.y[1], tri.y[2] });
+        float triMinZ = std::min({ tri.z[0], tri.z[1], tri.z[2] });
+        if (triMaxX < 0.0f || triMaxY < 0.0f || triMinX >= width || triMinY >= height || triMinZ > 1.0f) {
+            continue;
+        }
+
+        screenTriangles.push_back(tri);
+    }
+}
+
+void OcclusionCuller::renderOccluders(const ObjLoader& model) {
+    auto start = std::chrono::high_resolution_clock::now();
+
+    // Rank objects by on-screen footprint; cheap objects that cover a lot make the best occluders
+    const std::vector<ObjectGroup>& objects = model.getObjects();
+    std::vector<Candidate> candidates;
+    for (size_t i = 0; i < objects.size(); i++) {
+        const ObjectGroup& object = objects[i];
+        if (object.triangleCount == 0 || object.triangleCount > maxOccluderTriangles) {
+            continue;
+        }
+
+        float minX, minY, maxX, maxY, minZ;
+        Candidate candidate;
+        candidate.objectIndex = i;
+        if (!projectBox(object.minBounds, object.maxBounds, minX, minY, maxX, maxY, minZ)) {
+            candidate.area = (float)width * height;  // Surrounds the camera (walls, floors)
+        }
+        else {
+            float w = std::min(maxX, (float)width) - std::max(minX, 0.0f);
+            float h = std::min(maxY, (float)height) - std::max(minY, 0.0f);
+            if (w <= 0.0f || h <= 0.0f || minZ > 1.0f) continue;
+            candidate.area = w * h;
+        }
+        candidates.push_back(candidate);
+    }
+
+    int count = std::min((int)candidates.size(), maxOccluders);
+    std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(),
+                      [](const Candidate& a, const Candidate& b) { return a.area > b.area; });
+
+    for (int i = 0; i < count; i++) {
+        addOccluder(model, objects[candidates[i].objectIndex]);
+    }
+    stats.occluderCount = count;
+    stats.occluderTriangles = screenTriangles.size();
+
+    // Bands are whole tile rows, so every thread also owns its part of the hierarchy
+    int rowsPerThread = (tilesY + threadCount - 1) / threadCount;
+    if (threadCount == 1) {
+        rasterizeBand(0, height);
+    }
+    else {
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threadCount; t++) {
+            int yStart = t * rowsPerThread * kTileSize;
+            int yEnd = std::min(height, (t + 1) * rowsPerThread * kTileSize);
+            if (yStart >= yEnd) break;
+            workers.push_back(std::thread(&OcclusionCuller::rasterizeBand, this, yStart, yEnd));
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    stats.rasterMs = std::chrono::duration<float, std::milli>(
+        std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void OcclusionCuller::rasterizeBand(int yStart, int yEnd) {
+    for (const ScreenTriangle& src : screenTriangles) {
+        // Counter-clockwise winding so all inside edge values are positive
+        float x0 = src.x[0], y0 = src.y[0], z0 = src.z[0];
+        float x1 = src.x[1], y1 = src.y[1], z1 = src.z[1];
+        float x2 = src.x[2], y2 = src.y[2], z2 = src.z[2];
+        float area = (x1 - x0) * (y2 - y0) - (y1 - y0) * (x2 - x0);
+        if (area == 0.0f) continue;
+        if (area < 0.0f) {
+            std::swap(x1, x2); std::swap(y1, y2); std::swap(z1, z2);
+            area = -area;
+        }
+
+        int minX = std::max(0, (int)std::floor(std::min({ x0, x1, x2 })));
+        int maxX = std::min(width - 1, (int)std::ceil(std::max({ x0, x1, x2 })));
+        int minY = std::max(yStart, (int)std::floor(std::min({ y0, y1, y2 })));
+        int maxY = std::min(yEnd - 1, (int)std::ceil(std::max({ y0, y1, y2 })));
+        if (minX > maxX || minY > maxY) continue;
+        minX &= ~3;
+
+        // Edge functions E(px, py) = A * px + B * py + C, evaluated at pixel centers
+        float a0 = y1 - y2, b0 = x2 - x1, c0 = x1 * y2 - x2 * y1;  // Opposite v0
+        float a1 = y2 - y0, b1 = x0 - x2, c1 = x2 * y0 - x0 * y2;  // Opposite v1
+        float a2 = y0 - y1, b2 = x1 - x0, c2 = x0 * y1 - x1 * y0;  // Opposite v2
+
+        // Depth plane z(px, py) from the barycentric weights E1 / area and E2 / area
+        float invArea = 1.0f / area;
+        float za = ((z1 - z0) * a1 + (z2 - z0) * a2) * invArea;
+        float zb = ((z1 - z0) * b1 + (z2 - z0) * b2) * invArea;
+        float zc = z0 + ((z1 - z0) * c1 + (z2 - z0) * c2) * invArea;
+
+        for (int y = minY; y <= maxY; y++) {
+            float py = y + 0.5f;
+            float* row = &depth[y * width];
+
+#ifdef OCCLUSION_USE_SSE
+            float px = minX + 0.5f;
+            __m128 offsets = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+            __m128 pxv = _mm_add_ps(_mm_set1_ps(px), offsets);
+            __m128 e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a0), pxv), _mm_set1_ps(b0 * py + c0));
+            __m128 e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a1), pxv), _mm_set1_ps(b1 * py + c1));
+            __m128 e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a2), pxv), _mm_set1_ps(b2 * py + c2));
+            __m128 zv = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(za), pxv), _mm_set1_ps(zb * py + zc));
+            __m128 step0 = _mm_set1_ps(a0 * 4.0f);
+            __m128 step1 = _mm_set1_ps(a1 * 4.0f);
+            __m128 step2 = _mm_set1_ps(a2 * 4.0f);
+            __m128 stepZ = _mm_set1_ps(za * 4.0f);
+            __m128 zero = _mm_setzero_ps();
+
+            for (int x = minX; x <= maxX; x += 4) {
+                __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)),
+                                           _mm_cmpge_ps(e2, zero));
+                if (_mm_movemask_ps(inside)) {
+                    __m128 old = _mm_loadu_ps(row + x);
+                    __m128 nearer = _mm_min_ps(old, zv);
+                    _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, old)));
+                }
+                e0 = _mm_add_ps(e0, step0);
+                e1 = _mm_add_ps(e1, step1);
+                e2 = _mm_add_ps(e2, step2);
+                zv = _mm_add_ps(zv, stepZ);
+            }
+#else
+            for (int x = minX; x <= maxX; x++) {
+                float px = x + 0.5f;
+                if (a0 * px + b0 * py + c0 >= 0.0f &&
+                    a1 * px + b1 * py + c1 >= 0.0f &&
+                    a2 * px + b2 * py + c2 >= 0.0f) {
+                    float z = za * px + zb * py + zc;
+                    if (z < row[x]) row[x] = z;
+                }
+            }
+#endif
+        }
+    }
+
+    // Reduce this band's tile rows to their farthest depth
+    for (int ty = yStart / kTileSize; ty < yEnd / kTileSize; ty++) {
+        for (int tx = 0; tx < tilesX; tx++) {
+            float farthest = 0.0f;
+            for (int y = ty * kTileSize; y < (ty + 1) * kTileSize; y++) {
+                const float* row = &depth[y * width + tx * kTileSize];
+                for (int x = 0; x < kTileSize; x++) {
+                    farthest = std::max(farthest, row[x]);
+                }
+            }
+            tileMaxDepth[ty * tilesX + tx] = farthest;
+        }
+    }
+}
+
+bool OcclusionCuller::isBoxVisible(const Vec3& minBounds, const Vec3& maxBounds) {
+    auto start = std::chrono::high_resolution_clock::now();
+    stats.boxesTested++;
+
+    bool visible = false;
+    float minX, minY, maxX, maxY, minZ;
+    if (!projectBox(minBounds, maxBounds, minX, minY, maxX, maxY, minZ)) {
+        visible = true;
+    }
+    else if (maxX < 0.0f || maxY < 0.0f || minX >= width || minY >= height) {
+        visible = true;  // Off-screen boxes are the frustum test's job
+    }
+    else {
+        int tx0 = std::max(0, (int)std::floor(minX) / kTileSize);
+        int ty0 = std::max(0, (int)std::floor(minY) / kTileSize);
+        int tx1 = std::min(tilesX - 1, (int)std::floor(maxX) / kTileSize);
+        int ty1 = std::min(tilesY - 1, (int)std::floor(maxY) / kTileSize);
+
+        // Visible as soon as one covered tile has something farther than the box front
+        for (int ty = ty0; ty <= ty1 && !visible; ty++) {
+            for (int tx = tx0; tx <= tx1; tx++) {
+                if (minZ <= tileMaxDepth[ty * tilesX + tx]) {
+                    visible = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    if (!visible) {
+        stats.boxesOccluded++;
+    }
+    stats.testMs += std::chrono::duration<float, std::milli>(
+        std::chrono::high_resolution_clock::now() - start).count();
+    return visible;
+}
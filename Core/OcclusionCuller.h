@@ -0,0 +1,76 @@
+#ifndef OCCLUSION_CULLER_H
+#define OCCLUSION_CULLER_H
+
+#include <vector>
+#include "ObjLoader.h"
+
+struct OcclusionStats {
+    int occluderCount;      // Objects rasterized as occluders this frame
+    int occluderTriangles;  // Triangles rasterized into the depth buffer
+    int boxesTested;
+    int boxesOccluded;
+    float rasterMs;         // Occluder transform + rasterization + hierarchy build
+    float testMs;           // Accumulated isBoxVisible() time
+    OcclusionStats() : occluderCount(0), occluderTriangles(0), boxesTested(0),
+                       boxesOccluded(0), rasterMs(0.0f), testMs(0.0f) {}
+};
+
+// CPU occlusion culling. A few large objects are rasterized depth-only into a
+// small software depth buffer (4 pixels per SIMD step, screen split into
+// horizontal bands across threads), reduced into a per-tile max-depth
+// hierarchy, and object AABBs are then tested against the tiles they cover.
+// Needs no GL context: matrices are passed in, so it also runs headlessly.
+class OcclusionCuller {
+private:
+    struct ScreenTriangle {
+        float x[3], y[3], z[3];  // Pixel coordinates, depth in [0, 1]
+    };
+
+    int width;
+    int height;
+    int tilesX;
+    int tilesY;
+    int threadCount;
+    int maxOccluders;
+    int maxOccluderTriangles;
+
+    std::vector<float> depth;         // Nearest occluder depth per pixel (1 = empty)
+    std::vector<float> tileMaxDepth;  // Farthest depth within each tile
+    std::vector<ScreenTriangle> screenTriangles;
+    float mvp[16];
+    OcclusionStats stats;
+
+    bool projectBox(const Vec3& minBounds, const Vec3& maxBounds,
+                    float& minX, float& minY, float& maxX, float& maxY, float& minZ) const;
+    void addOccluder(const ObjLoader& model, const ObjectGroup& object);
+    void addOccluderFace(const ObjLoader& model, const Face& face);
+    void rasterizeBand(int yStart, int yEnd);
+
+public:
+    static const int kTileSize = 8;
+
+    OcclusionCuller(int width = 256, int height = 128);
+
+    // Configuration
+    void setThreadCount(int count);
+    void setMaxOccluders(int count) { maxOccluders = count; }
+    void setMaxOccluderTriangles(int count) { maxOccluderTriangles = count; }
+
+    // Column-major matrices; the modelview must include the model transform
+    void beginFrame(const float* modelview, const float* projection);
+
+    // Pick the largest on-screen objects of 'model' as occluders and rasterize them
+    void renderOccluders(const ObjLoader& model);
+
+    // False if the box is completely hidden behind already rasterized occluders
+    bool isBoxVisible(const Vec3& minBounds, const Vec3& maxBounds);
+
+    // Getters
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getThreadCount() const { return threadCount; }
+    const std::vector<float>& getDepthBuffer() const { return depth; }
+    const OcclusionStats& getStats() const { return stats; }
+};
+
+#endif
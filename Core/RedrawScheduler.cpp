@@ -0,0 +1,70 @@
+#include "RedrawScheduler.h"
+#include <chrono>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+RedrawScheduler::RedrawScheduler()
+    : dirty(false), framesDrawn(0), coalescedRequests(0) {
+    lastWall = wallSeconds();
+    lastCpu = processCpuSeconds();
+}
+
+bool RedrawScheduler::requestRedraw() {
+    if (dirty) {
+        coalescedRequests++;
+        return false;
+    }
+    dirty = true;
+    return true;
+}
+
+void RedrawScheduler::beginFrame() {
+    dirty = false;
+    framesDrawn++;
+}
+
+void RedrawScheduler::sample(bool wasPlaying) {
+    double wall = wallSeconds();
+    double cpu = processCpuSeconds();
+    CpuUsage& usage = wasPlaying ? playing : paused;
+    usage.wallSeconds += wall - lastWall;
+    usage.cpuSeconds += cpu - lastCpu;
+    lastWall = wall;
+    lastCpu = cpu;
+}
+
+void RedrawScheduler::resetUsage() {
+    playing = CpuUsage();
+    paused = CpuUsage();
+    lastWall = wallSeconds();
+    lastCpu = processCpuSeconds();
+}
+
+double RedrawScheduler::processCpuSeconds() {
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+        return 0.0;
+    }
+    // 100 ns units
+    ULARGE_INTEGER k, u;
+    k.LowPart = kernel.dwLowDateTime;
+    k.HighPart = kernel.dwHighDateTime;
+    u.LowPart = user.dwLowDateTime;
+    u.HighPart = user.dwHighDateTime;
+    return (double)(k.QuadPart + u.QuadPart) * 1e-7;
+#else
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+           (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+#endif
+}
+
+double RedrawScheduler::wallSeconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
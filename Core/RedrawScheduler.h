@@ -0,0 +1,49 @@
+#ifndef REDRAW_SCHEDULER_H
+#define REDRAW_SCHEDULER_H
+
+struct CpuUsage {
+    double wallSeconds;
+    double cpuSeconds;      // User + system time of the whole process
+    CpuUsage() : wallSeconds(0.0), cpuSeconds(0.0) {}
+    float getPercent() const { return wallSeconds > 0.0 ? (float)(100.0 * cpuSeconds / wallSeconds) : 0.0f; }
+};
+
+// Bookkeeping for redraw-on-demand: a dirty flag that coalesces redraw
+// requests until the next display, counters for drawn and merged requests,
+// and process CPU time split into time spent playing vs paused. The GLUT
+// glue (timers, glutPostRedisplay) stays in main.cpp.
+class RedrawScheduler {
+private:
+    bool dirty;
+    int framesDrawn;
+    int coalescedRequests;  // Requests that arrived while a redraw was already pending
+    CpuUsage playing;
+    CpuUsage paused;
+    double lastWall;
+    double lastCpu;
+
+public:
+    RedrawScheduler();
+
+    // True if the caller must post a redisplay (nothing pending yet)
+    bool requestRedraw();
+    // Called at the start of display()
+    void beginFrame();
+    bool isDirty() const { return dirty; }
+
+    // Charges the time since the previous sample to the given state; call
+    // before every play/pause transition and before reporting
+    void sample(bool wasPlaying);
+    // Drops everything measured so far (e.g. model loading before the main loop)
+    void resetUsage();
+
+    int getFramesDrawn() const { return framesDrawn; }
+    int getCoalescedRequests() const { return coalescedRequests; }
+    const CpuUsage& getPlayingUsage() const { return playing; }
+    const CpuUsage& getPausedUsage() const { return paused; }
+
+    static double processCpuSeconds();
+    static double wallSeconds();
+};
+
+#endif
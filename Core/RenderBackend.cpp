@@ -0,0 +1,172 @@
+#include "RenderBackend.h"
+#include "ObjLoader.h"
+#include <iostream>
+
+namespace {
+    const char* kBackendNames[RENDER_BACKEND_COUNT] = { "immediate", "arrays", "lists", "vbo" };
+
+    // One glBegin/glEnd per face
+    int drawRangeFaces(const ObjLoader& model, int rangeIndex) {
+        const DrawRange& range = model.getDrawRanges()[rangeIndex];
+        const std::vector<Face>& faces = model.getFaces();
+        for (int f = range.firstFace; f < range.firstFace + range.faceCount; f++) {
+            model.drawFace(faces[f]);
+        }
+        return range.faceCount;
+    }
+
+    class ImmediateBackend : public RenderBackend {
+    public:
+        RenderBackendType getType() const { return RENDER_IMMEDIATE; }
+        bool prepare(const ObjLoader&) { return true; }
+        bool updateVertices(const ObjLoader&) { return true; }
+        int drawRange(const ObjLoader& model, int rangeIndex) { return drawRangeFaces(model, rangeIndex); }
+    };
+
+    class VertexArrayBackend : public RenderBackend {
+    private:
+        WeldedMesh mesh;
+
+    public:
+        RenderBackendType getType() const { return RENDER_VERTEX_ARRAYS; }
+
+        bool prepare(const ObjLoader& model) {
+            mesh.build(model);
+            return true;
+        }
+
+        bool updateVertices(const ObjLoader& model) { return mesh.updateVertices(model); }
+
+        void begin() {
+            if (mesh.vertices.empty()) return;
+            const GLsizei stride = sizeof(BufferVertex);
+            glEnableClientState(GL_VERTEX_ARRAY);
+            glEnableClientState(GL_NORMAL_ARRAY);
+            glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+            glVertexPointer(3, GL_FLOAT, stride, mesh.vertices[0].position);
+            glNormalPointer(GL_FLOAT, stride, mesh.vertices[0].normal);
+            glTexCoordPointer(2, GL_FLOAT, stride, mesh.vertices[0].texCoord);
+        }
+
+        int drawRange(const ObjLoader&, int rangeIndex) {
+            const IndexRange& range = mesh.ranges[rangeIndex];
+            if (range.indexCount == 0) return 0;
+            glDrawElements(GL_TRIANGLES, range.indexCount, GL_UNSIGNED_INT, &mesh.indices[range.firstIndex]);
+            return 1;
+        }
+
+        void end() {
+            glDisableClientState(GL_VERTEX_ARRAY);
+            glDisableClientState(GL_NORMAL_ARRAY);
+            glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+        }
+
+        size_t getRetainedBytes() const {
+            return mesh.vertices.size() * sizeof(BufferVertex) + mesh.indices.size() * sizeof(GLuint) +
+                   mesh.sources.size() * sizeof(WeldedSource);
+        }
+    };
+
+    class DisplayListBackend : public RenderBackend {
+    private:
+        GLuint listBase;                  // First of one glGenLists block, 0 if none
+        std::vector<GLuint> rangeLists;   // Compiled list per opaque range (0 = none)
+
+    public:
+        DisplayListBackend() : listBase(0) {}
+
+        ~DisplayListBackend() {
+            if (listBase != 0) {
+                glDeleteLists(listBase, rangeLists.size());
+            }
+        }
+
+        RenderBackendType getType() const { return RENDER_DISPLAY_LISTS; }
+
+        bool prepare(const ObjLoader& model) {
+            const std::vector<DrawRange>& ranges = model.getDrawRanges();
+            if (ranges.empty()) {
+                return true;
+            }
+
+            listBase = glGenLists(ranges.size());
+            if (listBase == 0) {
+                return false;
+            }
+
+            // Geometry only: material state stays outside the lists so ranges can still be
+            // culled, and transparent ranges are re-sorted every frame instead
+            rangeLists.assign(ranges.size(), 0);
+            for (size_t r = 0; r < ranges.size(); r++) {
+                if (ranges[r].transparent) {
+                    continue;
+                }
+                rangeLists[r] = listBase + r;
+                glNewList(rangeLists[r], GL_COMPILE);
+                drawRangeFaces(model, r);
+                glEndList();
+            }
+            return true;
+        }
+
+        int drawRange(const ObjLoader& model, int rangeIndex) {
+            if (rangeLists[rangeIndex] != 0) {
+                glCallList(rangeLists[rangeIndex]);
+                return 1;
+            }
+            return drawRangeFaces(model, rangeIndex);
+        }
+    };
+
+    class BufferBackend : public RenderBackend {
+    private:
+        MeshBuffers buffers;
+
+    public:
+        RenderBackendType getType() const { return RENDER_BUFFERS; }
+        bool prepare(const ObjLoader& model) { return buffers.build(model); }
+        bool updateVertices(const ObjLoader& model) { return buffers.updateVertices(model); }
+        void begin() { buffers.bind(); }
+        int drawRange(const ObjLoader&, int rangeIndex) { return buffers.drawRange(rangeIndex); }
+        void end() { buffers.unbind(); }
+        size_t getRetainedBytes() const { return buffers.getGpuBytes(); }
+        size_t getStagingBytes() const { return buffers.getClientBytes(); }
+    };
+}
+
+RenderBackend* createRenderBackend(RenderBackendType type) {
+    switch (type) {
+    case RENDER_VERTEX_ARRAYS: return new VertexArrayBackend();
+    case RENDER_DISPLAY_LISTS: return new DisplayListBackend();
+    case RENDER_BUFFERS: return new BufferBackend();
+    default: return new ImmediateBackend();
+    }
+}
+
+const char* getRenderBackendName(RenderBackendType type) {
+    if (type < 0 || type >= RENDER_BACKEND_COUNT) {
+        return "unknown";
+    }
+    return kBackendNames[type];
+}
+
+bool parseRenderBackend(const std::string& name, RenderBackendType& type) {
+    for (int i = 0; i < RENDER_BACKEND_COUNT; i++) {
+        if (name == kBackendNames[i]) {
+            type = (RenderBackendType)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool isRenderBackendSupported(RenderBackendType type) {
+    if (type == RENDER_BUFFERS) {
+        return hasBufferObjects();
+    }
+    return type >= 0 && type < RENDER_BACKEND_COUNT;
+}
+
+RenderBackendType getFallbackBackend(RenderBackendType type) {
+    return type == RENDER_BUFFERS ? RENDER_DISPLAY_LISTS : RENDER_IMMEDIATE;
+}
@@ -0,0 +1,58 @@
+#ifndef RENDER_BACKEND_H
+#define RENDER_BACKEND_H
+
+#include <string>
+#include "MeshBuffers.h"
+
+class ObjLoader;
+
+enum RenderBackendType {
+    RENDER_IMMEDIATE,       // glBegin/glEnd per face
+    RENDER_VERTEX_ARRAYS,   // Welded mesh in client memory, glDrawElements per range
+    RENDER_DISPLAY_LISTS,   // One compiled display list per range
+    RENDER_BUFFERS,         // Welded mesh in VBO/IBO, glDrawElements per range
+    RENDER_BACKEND_COUNT
+};
+
+// How ObjLoader submits the geometry of its opaque draw ranges. The loader
+// still does culling, material changes and the sorted transparent pass; a
+// backend only draws the faces of one range. prepare() runs on the first draw
+// after load (with a current GL context) and builds whatever it retains.
+class RenderBackend {
+public:
+    virtual ~RenderBackend() {}
+
+    virtual RenderBackendType getType() const = 0;
+
+    // False if the context cannot run this backend; the loader then falls back
+    virtual bool prepare(const ObjLoader& model) = 0;
+
+    // drawRange() calls are bracketed by begin()/end() once per draw;
+    // drawRange() returns the number of GL draw calls it issued
+    virtual void begin() {}
+    virtual int drawRange(const ObjLoader& model, int rangeIndex) = 0;
+    virtual void end() {}
+
+    // After the model's positions and normals changed in place (same topology):
+    // refreshes the retained geometry, or returns false to have it rebuilt
+    virtual bool updateVertices(const ObjLoader&) { return false; }
+
+    // Geometry kept by the backend (client or GPU memory)
+    virtual size_t getRetainedBytes() const { return 0; }
+    // Client-memory copy a GPU backend keeps for updateVertices()
+    virtual size_t getStagingBytes() const { return 0; }
+};
+
+RenderBackend* createRenderBackend(RenderBackendType type);
+
+// Short names used by --backend and in reports: immediate, arrays, lists, vbo
+const char* getRenderBackendName(RenderBackendType type);
+bool parseRenderBackend(const std::string& name, RenderBackendType& type);
+
+// Whether the current context has what the backend needs
+bool isRenderBackendSupported(RenderBackendType type);
+
+// Next backend to try when prepare() fails (vbo -> lists -> immediate)
+RenderBackendType getFallbackBackend(RenderBackendType type);
+
+#endif
@@ -0,0 +1,97 @@
+#include "Trace.h"
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+
+TraceRecorder traceRecorder;
+
+namespace {
+    const size_t kMaxTraceEvents = 1000000;
+
+    int currentThreadId() {
+        static std::atomic<int> nextId(1);
+        thread_local int id = nextId.fetch_add(1);
+        return id;
+    }
+
+    void writeJsonString(std::ostream& out, const std::string& text) {
+        out << '"';
+        for (char c : text) {
+            if (c == '"' || c == '\\') out << '\\' << c;
+            else if ((unsigned char)c < 0x20) out << ' ';
+            else out << c;
+        }
+        out << '"';
+    }
+}
+
+TraceRecorder::TraceRecorder() : enabled(false), droppedEvents(0) {
+}
+
+void TraceRecorder::start(const std::string& filename) {
+    std::lock_guard<std::mutex> lock(mutex);
+    path = filename;
+    events.clear();
+    droppedEvents = 0;
+    origin = std::chrono::steady_clock::now();
+    enabled.store(true);
+}
+
+double TraceRecorder::nowUs() const {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - origin).count();
+}
+
+void TraceRecorder::addEvent(const char* name, const std::string& detail, double startUs, double endUs) {
+    int threadId = currentThreadId();
+    std::lock_guard<std::mutex> lock(mutex);
+    if (events.size() >= kMaxTraceEvents) {
+        droppedEvents++;
+        return;
+    }
+    TraceEvent event;
+    event.name = name;
+    event.detail = detail;
+    event.startUs = startUs;
+    event.durationUs = endUs - startUs;
+    event.threadId = threadId;
+    events.push_back(event);
+}
+
+bool TraceRecorder::stop() {
+    if (!enabled.exchange(false)) {
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        std::cerr << "Error: Cannot write trace " << path << std::endl;
+        return false;
+    }
+
+    // Complete ("X") events; times are in microseconds
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    for (size_t i = 0; i < events.size(); i++) {
+        const TraceEvent& event = events[i];
+        out << "{\"name\": ";
+        writeJsonString(out, event.name);
+        out << ", \"ph\": \"X\", \"pid\": 1, \"tid\": " << event.threadId
+            << ", \"ts\": " << event.startUs << ", \"dur\": " << event.durationUs;
+        if (!event.detail.empty()) {
+            out << ", \"args\": {\"detail\": ";
+            writeJsonString(out, event.detail);
+            out << "}";
+        }
+        out << "}" << (i + 1 < events.size() ? ",\n" : "\n");
+    }
+    out << "]}\n";
+
+    std::cout << "Trace: " << events.size() << " zones written to " << path;
+    if (droppedEvents > 0) {
+        std::cout << " (" << droppedEvents << " dropped over the limit)";
+    }
+    std::cout << std::endl;
+    events.clear();
+    return true;
+}
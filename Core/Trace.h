@@ -0,0 +1,82 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct TraceEvent {
+    const char* name;       // String literal
+    std::string detail;     // Shown as args.detail, e.g. the file being loaded
+    double startUs;         // Since start()
+    double durationUs;
+    int threadId;           // Small id in order of first appearance
+};
+
+// Collects timed zones and writes them as a Chrome trace-event JSON file
+// (open it in Perfetto or chrome://tracing). Recording is off until start();
+// a zone then costs two clock reads and a locked append. Events past
+// kMaxTraceEvents are dropped (and counted) so a long session stays bounded.
+// One instance (traceRecorder); zones may end on any thread.
+class TraceRecorder {
+private:
+    std::atomic<bool> enabled;
+    std::string path;
+    std::chrono::steady_clock::time_point origin;
+    std::mutex mutex;
+    std::vector<TraceEvent> events;
+    size_t droppedEvents;
+
+public:
+    TraceRecorder();
+
+    // Starts recording; the file is written by stop()
+    void start(const std::string& filename);
+    // Writes the file and stops recording; false if it cannot be written
+    bool stop();
+    bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+    double nowUs() const;
+    void addEvent(const char* name, const std::string& detail, double startUs, double endUs);
+};
+
+extern TraceRecorder traceRecorder;
+
+// Records the enclosing scope as one zone when tracing is on
+class TraceZone {
+private:
+    const char* name;
+    std::string detail;
+    double startUs;
+    bool active;
+
+public:
+    explicit TraceZone(const char* name)
+        : name(name), startUs(0.0), active(traceRecorder.isEnabled()) {
+        if (active) startUs = traceRecorder.nowUs();
+    }
+    TraceZone(const char* name, const std::string& detail)
+        : name(name), detail(detail), startUs(0.0), active(traceRecorder.isEnabled()) {
+        if (active) startUs = traceRecorder.nowUs();
+    }
+    ~TraceZone() {
+        if (active) traceRecorder.addEvent(name, detail, startUs, traceRecorder.nowUs());
+    }
+};
+
+// Build with -DNO_TRACE to compile every zone out
+#ifdef NO_TRACE
+#define TRACE_SCOPE(name)
+#define TRACE_SCOPE_DETAIL(name, detail)
+#else
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) TraceZone TRACE_CONCAT(traceZone, __LINE__)(name)
+// 'detail' is only evaluated (and copied) while recording
+#define TRACE_SCOPE_DETAIL(name, detail) \
+    TraceZone TRACE_CONCAT(traceZone, __LINE__)(name, traceRecorder.isEnabled() ? std::string(detail) : std::string())
+#endif
+
+#endif
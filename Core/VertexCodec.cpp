@@ -0,0 +1,302 @@
+#include "VertexCodec.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+    const int kBlockSize = 64;          // Values sharing one Rice parameter
+    const int kParameterBits = 5;       // Rice parameter 0..31
+    const int kEscapeQuotient = 20;     // Unary quotients this long are followed by the raw value
+    const size_t kReadPadding = 8;      // Zero bytes after the data, so reads may load 8 bytes anywhere
+
+    uint32_t zigzag(int32_t value) {
+        return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+    }
+
+    int32_t unzigzag(uint32_t value) {
+        return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+    }
+
+    int countTrailingOnes(uint64_t bits) {
+#if defined(__GNUC__)
+        return ~bits ? __builtin_ctzll(~bits) : 64;
+#else
+        int count = 0;
+        while (bits & 1) {
+            bits >>= 1;
+            count++;
+        }
+        return count;
+#endif
+    }
+
+    // Bits in Rice code k, the escape included
+    size_t riceBits(uint32_t value, int k) {
+        uint32_t quotient = value >> k;
+        return quotient < (uint32_t)kEscapeQuotient ? quotient + 1 + k : kEscapeQuotient + 32;
+    }
+
+    // Appends bits least significant first
+    class BitWriter {
+    private:
+        std::vector<uint8_t>& out;
+        uint64_t pending;
+        int pendingBits;
+
+    public:
+        explicit BitWriter(std::vector<uint8_t>& out) : out(out), pending(0), pendingBits(0) {}
+
+        // Up to 32 bits
+        void write(uint32_t value, int bits) {
+            pending |= (uint64_t)value << pendingBits;
+            pendingBits += bits;
+            while (pendingBits >= 8) {
+                out.push_back((uint8_t)pending);
+                pending >>= 8;
+                pendingBits -= 8;
+            }
+        }
+
+        void writeRice(uint32_t value, int k) {
+            uint32_t quotient = value >> k;
+            if (quotient < (uint32_t)kEscapeQuotient) {
+                write((1u << quotient) - 1, quotient + 1);   // Ones ended by a zero
+                if (k > 0) write(value & ((1u << k) - 1), k);
+            }
+            else {
+                write((1u << kEscapeQuotient) - 1, kEscapeQuotient);
+                write(value, 32);
+            }
+        }
+
+        // Pads the last byte with zeros
+        void flush() {
+            if (pendingBits > 0) {
+                out.push_back((uint8_t)pending);
+            }
+            pending = 0;
+            pendingBits = 0;
+        }
+    };
+
+    // Reads what BitWriter wrote; relies on kReadPadding and a little-endian CPU
+    class BitReader {
+    private:
+        const uint8_t* data;
+        size_t position;    // In bits
+
+        uint64_t peek() const {
+            uint64_t bits;
+            std::memcpy(&bits, data + (position >> 3), sizeof(bits));
+            return bits >> (position & 7);  // At least 57 valid bits
+        }
+
+    public:
+        explicit BitReader(const uint8_t* data) : data(data), position(0) {}
+
+        uint32_t read(int bits) {
+            uint32_t value = (uint32_t)(peek() & ((1ull << bits) - 1));
+            position += bits;
+            return value;
+        }
+
+        uint32_t readRice(int k) {
+            uint64_t bits = peek();
+            int quotient = countTrailingOnes(bits);
+            if (quotient < kEscapeQuotient) {
+                position += quotient + 1 + k;
+                return ((uint32_t)quotient << k) | (uint32_t)((bits >> (quotient + 1)) & ((1ull << k) - 1));
+            }
+            position += kEscapeQuotient;
+            return read(32);
+        }
+    };
+
+    // Cheapest Rice parameter for one block
+    int chooseRiceParameter(const uint32_t* values, int count) {
+        int best = 0;
+        size_t bestBits = (size_t)-1;
+        for (int k = 0; k < (1 << kParameterBits); k++) {
+            size_t bits = 0;
+            for (int i = 0; i < count; i++) {
+                bits += riceBits(values[i], k);
+            }
+            if (bits < bestBits) {
+                bestBits = bits;
+                best = k;
+            }
+        }
+        return best;
+    }
+}
+
+CompressedAnimation::CompressedAnimation()
+    : vertexCount(0), normalCount(0), positionStep(1.0f), normalStep(1.0f) {
+}
+
+void CompressedAnimation::reset(const VertexCodecSettings& newSettings) {
+    settings = newSettings;
+    settings.keyframeInterval = std::max(1, settings.keyframeInterval);
+    settings.positionBits = std::min(std::max(settings.positionBits, 1), 24);
+    settings.normalBits = std::min(std::max(settings.normalBits, 1), 24);
+    vertexCount = 0;
+    normalCount = 0;
+    data.clear();
+    frameOffsets.clear();
+    previous.clear();
+}
+
+void CompressedAnimation::quantize(const std::vector<Vec3>& positions, const std::vector<Vec3>& normals,
+                                   std::vector<int32_t>& values) const {
+    values.resize(3 * (positions.size() + normals.size()));
+    int32_t* out = values.empty() ? nullptr : &values[0];
+    float positionScale = 1.0f / positionStep;
+    for (const Vec3& p : positions) {
+        *out++ = (int32_t)std::floor((p.x - positionOrigin.x) * positionScale + 0.5f);
+        *out++ = (int32_t)std::floor((p.y - positionOrigin.y) * positionScale + 0.5f);
+        *out++ = (int32_t)std::floor((p.z - positionOrigin.z) * positionScale + 0.5f);
+    }
+    float normalScale = 1.0f / normalStep;
+    for (const Vec3& n : normals) {
+        *out++ = (int32_t)std::floor(n.x * normalScale + 0.5f);
+        *out++ = (int32_t)std::floor(n.y * normalScale + 0.5f);
+        *out++ = (int32_t)std::floor(n.z * normalScale + 0.5f);
+    }
+}
+
+bool CompressedAnimation::addFrame(const std::vector<Vec3>& positions, const std::vector<Vec3>& normals) {
+    TRACE_SCOPE("encode frame");
+    int frame = frameOffsets.size();
+    if (frame == 0) {
+        // The grid covers the first frame at the requested resolution; later
+        // frames may leave its box, quantized values are not range limited
+        vertexCount = positions.size();
+        normalCount = normals.size();
+        Vec3 minBounds(1e10f, 1e10f, 1e10f);
+        Vec3 maxBounds(-1e10f, -1e10f, -1e10f);
+        for (const Vec3& p : positions) {
+            minBounds = Vec3(std::min(minBounds.x, p.x), std::min(minBounds.y, p.y), std::min(minBounds.z, p.z));
+            maxBounds = Vec3(std::max(maxBounds.x, p.x), std::max(maxBounds.y, p.y), std::max(maxBounds.z, p.z));
+        }
+        float extent = positions.empty() ? 0.0f :
+            std::max({ maxBounds.x - minBounds.x, maxBounds.y - minBounds.y, maxBounds.z - minBounds.z });
+        positionOrigin = positions.empty() ? Vec3() : minBounds;
+        positionStep = (extent > 0.0f ? extent : 1.0f) / (float)(1 << settings.positionBits);
+        normalStep = 2.0f / (float)(1 << settings.normalBits);
+    }
+    else if ((int)positions.size() != vertexCount || (int)normals.size() != normalCount) {
+        return false;
+    }
+
+    std::vector<int32_t> values;
+    quantize(positions, normals, values);
+
+    // Keyframes predict from the previous vertex (restarting at the normals), other frames from the last frame
+    residuals.resize(values.size());
+    if (isKeyframe(frame)) {
+        size_t normalStart = 3 * (size_t)vertexCount;
+        for (size_t i = 0; i < values.size(); i++) {
+            bool first = i < 3 || (i >= normalStart && i < normalStart + 3);
+            residuals[i] = zigzag(values[i] - (first ? 0 : values[i - 3]));
+        }
+    }
+    else {
+        for (size_t i = 0; i < values.size(); i++) {
+            residuals[i] = zigzag(values[i] - previous[i]);
+        }
+    }
+
+    // Offsets index the data before the read padding of the previous frame is dropped
+    if (!data.empty()) {
+        data.resize(data.size() - kReadPadding);
+    }
+    frameOffsets.push_back(data.size());
+    BitWriter writer(data);
+    for (size_t block = 0; block < residuals.size(); block += kBlockSize) {
+        int count = (int)std::min((size_t)kBlockSize, residuals.size() - block);
+        int k = chooseRiceParameter(&residuals[block], count);
+        writer.write(k, kParameterBits);
+        for (int i = 0; i < count; i++) {
+            writer.writeRice(residuals[block + i], k);
+        }
+    }
+    writer.flush();
+    data.resize(data.size() + kReadPadding, 0);
+
+    previous.swap(values);
+    return true;
+}
+
+size_t CompressedAnimation::getEncodedBytes() const {
+    return data.size() + frameOffsets.size() * sizeof(size_t);
+}
+
+size_t CompressedAnimation::getRawBytes() const {
+    return frameOffsets.size() * (size_t)(vertexCount + normalCount) * sizeof(Vec3);
+}
+
+VertexDecoder::VertexDecoder(const CompressedAnimation& animation)
+    : animation(&animation), currentFrame(-1) {
+}
+
+void VertexDecoder::decodeValues(int frame) {
+    size_t count = 3 * (size_t)(animation->getVertexCount() + animation->getNormalCount());
+    values.resize(count);
+    if (count == 0) {
+        return;
+    }
+    int32_t* out = &values[0];
+    BitReader reader(animation->getFrameData(frame));
+    bool keyframe = animation->isKeyframe(frame);
+    size_t normalStart = 3 * (size_t)animation->getVertexCount();
+
+    for (size_t block = 0; block < count; block += kBlockSize) {
+        int k = reader.read(kParameterBits);
+        size_t end = std::min(block + kBlockSize, count);
+        if (keyframe) {
+            for (size_t i = block; i < end; i++) {
+                bool first = i < 3 || (i >= normalStart && i < normalStart + 3);
+                out[i] = (first ? 0 : out[i - 3]) + unzigzag(reader.readRice(k));
+            }
+        }
+        else {
+            for (size_t i = block; i < end; i++) {
+                out[i] += unzigzag(reader.readRice(k));
+            }
+        }
+    }
+    currentFrame = frame;
+}
+
+bool VertexDecoder::decodeFrame(int frame, std::vector<Vec3>& positions, std::vector<Vec3>& normals) {
+    if (frame < 0 || frame >= animation->getFrameCount()) {
+        return false;
+    }
+    TRACE_SCOPE("decode frame");
+
+    // Forward within the current keyframe interval continues from the held frame
+    int interval = animation->getSettings().keyframeInterval;
+    int keyframe = frame - frame % interval;
+    int start = (currentFrame >= keyframe && currentFrame <= frame) ? currentFrame + 1 : keyframe;
+    for (int f = start; f <= frame; f++) {
+        decodeValues(f);
+    }
+
+    int vertexCount = animation->getVertexCount();
+    int normalCount = animation->getNormalCount();
+    positions.resize(vertexCount);
+    normals.resize(normalCount);
+    const int32_t* in = values.empty() ? nullptr : &values[0];
+    const Vec3& origin = animation->getPositionOrigin();
+    float positionStep = animation->getPositionStep();
+    for (int i = 0; i < vertexCount; i++, in += 3) {
+        positions[i] = Vec3(origin.x + in[0] * positionStep, origin.y + in[1] * positionStep,
+                            origin.z + in[2] * positionStep);
+    }
+    float normalStep = animation->getNormalStep();
+    for (int i = 0; i < normalCount; i++, in += 3) {
+        normals[i] = Vec3(in[0] * normalStep, in[1] * normalStep, in[2] * normalStep);
+    }
+    return true;
+}
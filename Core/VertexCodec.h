@@ -0,0 +1,88 @@
+#ifndef VERTEX_CODEC_H
+#define VERTEX_CODEC_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "ObjLoader.h"
+
+// Quantization and keyframe spacing of a CompressedAnimation
+struct VertexCodecSettings {
+    int positionBits;      // Position step = largest extent of the first frame / 2^positionBits
+    int normalBits;        // Normal step = 2 / 2^normalBits (components lie in [-1, 1])
+    int keyframeInterval;  // Every n-th frame is coded on its own; seeking decodes at most n frames
+    VertexCodecSettings() : positionBits(16), normalBits(12), keyframeInterval(30) {}
+};
+
+// Per-frame positions and normals of a vertex animation whose frames share
+// one topology (same vertex and normal count and order), compressed.
+//
+// Every component is quantized to a fixed step. Keyframes code each value as
+// the difference to the same component of the previous vertex; the other
+// frames code it as the difference to the same value in the previous frame.
+// Differences are zigzag mapped and Rice coded in blocks of 64 values, each
+// block with its own parameter. Deltas are taken between quantized values,
+// so the error never accumulates: every decoded component is within half a
+// step of the original.
+//
+// Only Bench/CodecBench uses it. The viewer, the .anim container and
+// streaming keep raw floats, and ObjViewer does not link this file.
+class CompressedAnimation {
+private:
+    VertexCodecSettings settings;
+    int vertexCount;
+    int normalCount;
+    Vec3 positionOrigin;
+    float positionStep;
+    float normalStep;
+    std::vector<uint8_t> data;          // Frames back to back, each starting on a byte
+    std::vector<size_t> frameOffsets;   // Start of each frame in 'data'
+    std::vector<int32_t> previous;      // Encoder: quantized values of the last added frame
+    std::vector<uint32_t> residuals;    // Encoder scratch
+
+    void quantize(const std::vector<Vec3>& positions, const std::vector<Vec3>& normals,
+                  std::vector<int32_t>& values) const;
+
+public:
+    CompressedAnimation();
+
+    // Drops all frames; the next addFrame() fixes the counts and the position grid
+    void reset(const VertexCodecSettings& settings);
+    // Appends one frame; false if its counts differ from the first frame's
+    bool addFrame(const std::vector<Vec3>& positions, const std::vector<Vec3>& normals);
+
+    int getFrameCount() const { return frameOffsets.size(); }
+    int getVertexCount() const { return vertexCount; }
+    int getNormalCount() const { return normalCount; }
+    const VertexCodecSettings& getSettings() const { return settings; }
+    bool isKeyframe(int frame) const { return frame % settings.keyframeInterval == 0; }
+    float getPositionStep() const { return positionStep; }
+    float getNormalStep() const { return normalStep; }
+    const Vec3& getPositionOrigin() const { return positionOrigin; }
+    const uint8_t* getFrameData(int frame) const { return &data[frameOffsets[frame]]; }
+
+    // Coded size (frame data and offset table) and the float data it replaces
+    size_t getEncodedBytes() const;
+    size_t getRawBytes() const;
+};
+
+// Decodes frames of one CompressedAnimation. Stepping to the next frame
+// decodes one frame; any other jump restarts at the keyframe at or before the
+// target. One decoder per thread; the animation itself is only read.
+class VertexDecoder {
+private:
+    const CompressedAnimation* animation;
+    int currentFrame;                   // Frame held in 'values', -1 if none
+    std::vector<int32_t> values;
+
+    void decodeValues(int frame);
+
+public:
+    explicit VertexDecoder(const CompressedAnimation& animation);
+
+    // Fills positions and normals (resized as needed); false if 'frame' is out of range
+    bool decodeFrame(int frame, std::vector<Vec3>& positions, std::vector<Vec3>& normals);
+    int getCurrentFrame() const { return currentFrame; }
+};
+
+#endif
@@ -1,10 +1,24 @@
 #include <GL/glut.h>
+#include <GL/freeglut_ext.h>
 #include <iostream>
 #include <chrono>
 #include <cstdlib>
+#include <cstdio>
+#include <vector>
 #include <algorithm> // For std::min/max
+#include <cmath>
+#include <cctype>
 #include "ObjLoader.h"
 #include "AnimationLoader.h"
+#include "Bvh.h"
+#include "OcclusionCuller.h"
+#include "GLExtensions.h"
+#include "GLStateCache.h"
+#include "BackendBench.h"
+#include "InstanceRenderer.h"
+#include "RedrawScheduler.h"
+#include "FrameStats.h"
+#include "Trace.h"
 
 // Global variables
 ObjLoader* objModel = nullptr;
@@ -20,6 +34,15 @@ bool isRotating = false;
 bool showWireframe = false;
 bool enableLighting = true;
 bool showAxis = false;
+bool frustumCulling = true;
+bool occlusionCulling = false;
+RenderBackendType renderBackend = RENDER_BUFFERS;
+OcclusionCuller occlusionCuller;  // Depth buffer software 256x128, dipakai bila occlusionCulling aktif
+float farPlane = 100.0f;
+
+// --- Instancing (--instances / --stress-instances) ---
+InstanceRenderer instanceRenderer;  // Kosong = model digambar sekali seperti biasa
+Material instanceTint;              // Material override untuk sebagian instance
 
 // Posisi LIGHT3 (Point Light) global
 GLfloat light3_Position[] = { -0.5f, -0.2f, -0.2f, 1.0f };
@@ -39,20 +62,134 @@ float spotLightExponent = 30.0f;  // Diambil dari spotlight.cpp
 
 // Variabel showLightMarker DIHAPUS
 
+// --- Mouse picking ---
+Bvh pickBvh;                 // Dibangun saat pick pertama untuk model yang sedang tampil, ulang bila vertexnya berubah
+int pickedFace = -1;         // Face yang sedang di-highlight (-1 = tidak ada)
+int mouseDownX = 0;
+int mouseDownY = 0;
+GLdouble pickModelview[16];  // Modelview termasuk transformasi model (center/scale)
+GLdouble pickProjection[16];
+GLint pickViewport[4];
+bool pickMatricesValid = false;
+
 // Time tracking for animation
 auto lastTime = std::chrono::high_resolution_clock::now();
 
+// --- Redraw sesuai kebutuhan (tanpa glutIdleFunc) ---
+RedrawScheduler redrawScheduler;
+bool animationTimerActive = false;  // glutTimerFunc tidak bisa dibatalkan, jadi cukup satu yang pending
+const int kInterpolatedTickMs = 16; // Saat interpolasi setiap tick menghasilkan gambar baru (~60 Hz)
+const int kLoadPollMs = 100;        // Saat pause hanya mengambil frame yang sudah dimuat loader
+
+// --- Statistik per frame (HUD 'H' dan --frame-log file.csv) ---
+FrameStatsRecorder frameStats;
+
 // Function prototypes
 void display();
+void renderScene();
 void reshape(int w, int h);
 void keyboard(unsigned char key, int x, int y);
 void specialKeyboard(int key, int x, int y);
 void mouse(int button, int state, int x, int y);
 void motion(int x, int y);
 void initLighting();
+ObjLoader* getVisibleModel();
+void pickAt(int x, int y);
+void applyRenderBackend(RenderBackendType type);
+void renderBenchView(int view, int viewCount);
+void setupInstances(int count);
+void requestRedraw();
+void scheduleAnimationTick();
+void animationTick(int value);
+void setAnimationPlaying(bool play);
+void printCpuUsage();
+void recordFrameStats(float intervalMs, float cpuMs);
+void drawStatsOverlay();
+void runInstanceStress(int frames);
+void stopTrace();
+
+// glutGetProcAddress may use a different calling convention than GLProcLoader
+GLProc getGLProc(const char* name) {
+    return (GLProc)glutGetProcAddress(name);
+}
 
 int main(int argc, char** argv) {
     glutInit(&argc, argv);
+
+    // Opsi (boleh di posisi mana saja): --backend <immediate|arrays|lists|vbo>, --bench-backends [views],
+    // --instances <n>, --stress-instances <n> [frames], --frame-log <file.csv>, --trace <file.json>,
+    // --load-threads <n>, --stream [window], --decimate [tolerance], --interpolate
+    bool benchBackends = false;
+    int loadThreads = 0;
+    int streamWindow = 0;
+    float decimateTolerance = 0.0f;
+    bool interpolateFrames = false;
+    int benchViews = 120;
+    int instanceCount = 0;
+    int stressFrames = 0;
+    int positional = 1;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--backend" && i + 1 < argc) {
+            if (!parseRenderBackend(argv[++i], renderBackend)) {
+                std::cerr << "Unknown backend '" << argv[i] << "' (immediate, arrays, lists, vbo)" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--bench-backends") {
+            benchBackends = true;
+            if (i + 1 < argc && std::isdigit((unsigned char)argv[i + 1][0])) {
+                benchViews = std::atoi(argv[++i]);
+            }
+        }
+        else if (arg == "--frame-log" && i + 1 < argc) {
+            if (!frameStats.openLog(argv[++i])) {
+                return 1;
+            }
+        }
+        else if (arg == "--trace" && i + 1 < argc) {
+            // Dimulai sebelum load supaya zona load ikut terekam; ditulis saat program keluar
+            traceRecorder.start(argv[++i]);
+            std::atexit(stopTrace);
+        }
+        else if (arg == "--load-threads" && i + 1 < argc) {
+            // 0 = sesuai jumlah core, 1 = frame dimuat satu per satu
+            loadThreads = std::atoi(argv[++i]);
+        }
+        else if (arg == "--stream") {
+            // Animasi .anim di-stream: hanya 'window' frame di depan posisi playback yang ada di memori
+            streamWindow = 8;
+            if (i + 1 < argc && std::isdigit((unsigned char)argv[i + 1][0])) {
+                streamWindow = std::max(1, std::atoi(argv[++i]));
+            }
+        }
+        else if (arg == "--decimate") {
+            // Buang frame yang bisa direkonstruksi dari tetangganya; toleransi relatif terhadap ukuran model
+            decimateTolerance = 0.001f;
+            if (i + 1 < argc && (std::isdigit((unsigned char)argv[i + 1][0]) || argv[i + 1][0] == '.')) {
+                decimateTolerance = (float)std::atof(argv[++i]);
+            }
+            interpolateFrames = true;
+        }
+        else if (arg == "--interpolate") {
+            interpolateFrames = true;
+        }
+        else if (arg == "--instances" && i + 1 < argc) {
+            instanceCount = std::atoi(argv[++i]);
+        }
+        else if (arg == "--stress-instances" && i + 1 < argc) {
+            instanceCount = std::atoi(argv[++i]);
+            stressFrames = 100;
+            if (i + 1 < argc && std::isdigit((unsigned char)argv[i + 1][0])) {
+                stressFrames = std::max(2, std::atoi(argv[++i]));
+            }
+        }
+        else {
+            argv[positional++] = argv[i];
+        }
+    }
+    argc = positional;
+
     glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH);
     glutInitWindowSize(800, 600);
     glutInitWindowPosition(100, 100);
@@ -69,12 +206,22 @@ int main(int argc, char** argv) {
 
     initLighting();
 
+    // VBO dipakai bila driver mendukung, selain itu display list / immediate mode
+    if (loadGLExtensions(getGLProc)) {
+        std::cout << "Buffer objects available (OpenGL " << glGetString(GL_VERSION) << ")" << std::endl;
+    }
+
     // Parse command line arguments
     if (argc < 2) {
         std::cerr << "Error: No OBJ file specified!" << std::endl;
-        std::cerr << "Usage: " << argv[0] << " <objfile> [-a startFrame endFrame fps]" << std::endl;
+        std::cerr << "Usage: " << argv[0] << " <objfile|file.anim> [-a startFrame endFrame fps]"
+                  << " [--backend immediate|arrays|lists|vbo] [--bench-backends [views]]"
+                  << " [--instances n] [--stress-instances n [frames]] [--frame-log file.csv]"
+                  << " [--trace file.json] [--load-threads n] [--stream [window], .anim only]"
+                  << " [--decimate [tolerance]] [--interpolate]" << std::endl;
         std::cerr << "Example: " << argv[0] << " Models/cube.obj" << std::endl;
         std::cerr << "Example: " << argv[0] << " Models/Anim/Allanim -a 0 60 30" << std::endl;
+        std::cerr << "Example: " << argv[0] << " Models/Anim/AnimatedObject.anim -a 0 0 30" << std::endl;
         return 1;
     }
 
@@ -82,8 +229,17 @@ int main(int argc, char** argv) {
     int startFrame = 0, endFrame = 60;
     float fps = 30.0f;
 
+    // File .anim (Tools/AnimPack) selalu animasi; rentang frame -a diabaikan, fps tetap dipakai
+    bool containerFile = filename.size() > 5 && filename.compare(filename.size() - 5, 5, ".anim") == 0;
+    if (streamWindow > 0 && !containerFile) {
+        // Parse satu frame OBJ (~160 ms) jauh lebih lama dari satu frame playback
+        std::cerr << "Warning: --stream needs a .anim file (pack the sequence with AnimPack);"
+                  << " loading the OBJ frames instead" << std::endl;
+        streamWindow = 0;
+    }
+
     // Check if animation flag is present
-    if (argc > 2 && std::string(argv[2]) == "-a") {
+    if (containerFile || (argc > 2 && std::string(argv[2]) == "-a")) {
         useAnimation = true;
         
         // Parse animation parameters if provided
@@ -92,7 +248,9 @@ int main(int argc, char** argv) {
         if (argc > 5) fps = std::atof(argv[5]);
         
         std::cout << "Loading animation: " << filename << std::endl;
-        std::cout << "  Frames: " << startFrame << " to " << endFrame << std::endl;
+        if (!containerFile) {
+            std::cout << "  Frames: " << startFrame << " to " << endFrame << std::endl;
+        }
         std::cout << "  FPS: " << fps << std::endl;
     }
     else {
@@ -102,8 +260,25 @@ int main(int argc, char** argv) {
     // Load animation or static model
     if (useAnimation) {
         animation = new AnimationLoader();
-
-        if (animation->loadAnimationSequence(filename, startFrame, endFrame)) {
+        animation->setLoadThreads(loadThreads);
+        // Frame pertama langsung tampil, sisanya dimuat di background
+        animation->setProgressiveLoading(true);
+
+        bool loaded;
+        if (containerFile) {
+            loaded = streamWindow > 0 ? animation->openContainerStream(filename, streamWindow)
+                                      : animation->loadAnimationContainer(filename);
+        }
+        else {
+            loaded = animation->loadAnimationSequence(filename, startFrame, endFrame);
+        }
+        if (loaded) {
+            if (decimateTolerance > 0.0f) {
+                animation->decimateFrames(decimateTolerance);
+            }
+            if (interpolateFrames) {
+                animation->setInterpolation(true);
+            }
             animation->setFPS(fps);
             animation->setLoop(true);
             animation->play();
@@ -127,20 +302,62 @@ int main(int argc, char** argv) {
         }
     }
 
+    applyRenderBackend(renderBackend);
+
+    // Mode benchmark: orbit kamera tetap per backend di framebuffer offscreen, lalu keluar
+    if (benchBackends) {
+        if (animation) animation->pause();
+        reshape(800, 600);
+        BackendBench bench(800, 600, benchViews);
+        bool ok = bench.run(applyRenderBackend, renderBenchView);
+        bench.printReport(std::cout);
+        delete objModel;
+        delete animation;
+        return ok ? 0 : 2;
+    }
+
+    if (instanceCount > 0) {
+        if (!objModel) {
+            std::cerr << "Instancing needs a static model (no -a)" << std::endl;
+            delete animation;
+            return 1;
+        }
+        setupInstances(instanceCount);
+
+        // Mode stress test: N instance per mode instancing, lalu keluar
+        if (stressFrames > 0) {
+            runInstanceStress(stressFrames);
+            delete objModel;
+            return 0;
+        }
+    }
+
     // --- Tampilan Kontrol Diperbarui ---
     std::cout << "\n=== View Controls ===" << std::endl;
     std::cout << "Mouse drag: Rotate model" << std::endl;
+    std::cout << "Mouse click: Pick face/object" << std::endl;
     std::cout << "W/S: Zoom in/out" << std::endl;
     std::cout << "L: Toggle lighting" << std::endl;
     std::cout << "F: Toggle wireframe" << std::endl;
     std::cout << "R: Reset view" << std::endl;
     std::cout << "A: Toggle axis" << std::endl;
+    std::cout << "C: Toggle frustum culling" << std::endl;
+    std::cout << "X: Toggle CPU occlusion culling" << std::endl;
+    std::cout << "V: Cycle render backend (immediate, arrays, lists, vbo)" << std::endl;
+    std::cout << "I: Print draw statistics (objects/triangles drawn vs culled)" << std::endl;
+    std::cout << "H: Toggle frame statistics overlay" << std::endl;
+    std::cout << "U: Print memory usage per category" << std::endl;
+    if (instanceRenderer.getInstanceCount() > 0) {
+        std::cout << "N: Cycle instancing mode (hardware, batched, per instance)" << std::endl;
+    }
     // Baris untuk tombol 'B' DIHAPUS
     if (useAnimation) {
         std::cout << "SPACE: Play/Pause animation" << std::endl;
         std::cout << "P: Play animation" << std::endl;
         std::cout << "O: Stop animation" << std::endl;
         std::cout << "]/[: Increase/Decrease FPS" << std::endl;
+        std::cout << "E: Reverse playback direction" << std::endl;
+        std::cout << "J: Toggle interpolation between frames" << std::endl;
     }
     std::cout << "\n=== Lighting Controls ===" << std::endl;
     std::cout << "M/m: Increase/Decrease Global Ambient" << std::endl;
@@ -160,8 +377,11 @@ int main(int argc, char** argv) {
     // --- Selesai Tampilan Kontrol ---
 
 
+    // Tidak ada idle callback: GLUT tidur sampai ada input atau timer frame animasi berikutnya
+    redrawScheduler.resetUsage();
     if (useAnimation) {
-        glutIdleFunc([]() { glutPostRedisplay(); });
+        lastTime = std::chrono::high_resolution_clock::now();
+        scheduleAnimationTick();
     }
 
     glutMainLoop();
@@ -255,89 +475,218 @@ void initLighting() {
     glEnable(GL_NORMALIZE);
 }
 
-void display() {
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    glClearColor(0.1f, 0.1f, 0.15f, 1.0f);
-
-    // Update Global Ambient Light
-    GLfloat currentGlobalAmbient[] = { globalAmbientLevel, globalAmbientLevel, globalAmbientLevel, 1.0f };
-    glLightModelfv(GL_LIGHT_MODEL_AMBIENT, currentGlobalAmbient);
-
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
+void applyRenderBackend(RenderBackendType type) {
+    renderBackend = type;
+    if (objModel) objModel->setRenderBackend(type);
+    if (animation) animation->setRenderBackend(type);
+}
 
-    glTranslatef(0.0f, 0.0f, zoom);
-    glRotatef(angleX, 1.0f, 0.0f, 0.0f);
-    glRotatef(angleY, 0.0f, 1.0f, 0.0f);
+// Grid instance dari model statis; tiap instance ke-7 memakai material merah
+void setupInstances(int count) {
+    instanceTint.name = "instance_tint";
+    instanceTint.ambient = Vec3(0.3f, 0.05f, 0.05f);
+    instanceTint.diffuse = Vec3(0.9f, 0.15f, 0.1f);
+    instanceTint.specular = Vec3(0.3f, 0.3f, 0.3f);
+
+    const float spacing = 2.5f;
+    instanceRenderer.setModel(objModel);
+    instanceRenderer.addGrid(count, spacing, 1.0f, &instanceTint, 7);
+
+    // Kamera mundur sampai seluruh grid terlihat
+    float extent = std::ceil(std::sqrt((float)count)) * spacing;
+    zoom = -std::max(5.0f, extent * 1.2f);
+    angleX = 30.0f;
+    farPlane = std::max(100.0f, extent * 3.0f);
+    std::cout << "Instances: " << count << " copies of the model" << std::endl;
+}
 
-    // Update posisi LIGHT3 (Point Light)
-    glLightfv(GL_LIGHT3, GL_POSITION, light3_Position);
-    // Update posisi LIGHT5 (Point Light 2)
-    glLightfv(GL_LIGHT5, GL_POSITION, light5_Position);
+// Waktu frame (glFinish, tanpa swap) untuk tiap mode instancing
+void runInstanceStress(int frames) {
+    reshape(800, 600);
+    const InstanceRenderer::Mode modes[] = {
+        InstanceRenderer::MODE_HARDWARE, InstanceRenderer::MODE_BATCHED, InstanceRenderer::MODE_PER_INSTANCE
+    };
 
-    // Update Spotlight (Posisi, Arah, Intensitas, Angle, Exponent)
-    glLightfv(GL_LIGHT4, GL_POSITION, spotLightPosition);
-    glLightfv(GL_LIGHT4, GL_SPOT_DIRECTION, spotLightDirection);
-    glLightf(GL_LIGHT4, GL_SPOT_CUTOFF, spotLightAngle);
-    glLightf(GL_LIGHT4, GL_SPOT_EXPONENT, spotLightExponent);
+    std::cout << "Instance stress test, " << instanceRenderer.getInstanceCount() << " instances, "
+              << frames << " frames per mode (ms per frame, glFinish included)" << std::endl;
+    for (InstanceRenderer::Mode mode : modes) {
+        instanceRenderer.setMode(mode);
+        std::vector<float> frameMs;
+        for (int f = 0; f < frames; f++) {
+            auto start = std::chrono::high_resolution_clock::now();
+            angleY = 360.0f * f / frames;
+            renderScene();
+            glFinish();
+            frameMs.push_back(std::chrono::duration<float, std::milli>(
+                std::chrono::high_resolution_clock::now() - start).count());
+        }
 
-    GLfloat currentSpotDiffuse[] = {
-        spotLightColor[0] * spotLightIntensity,
-        spotLightColor[1] * spotLightIntensity,
-        spotLightColor[2] * spotLightIntensity,
-        1.0f
-    };
-    GLfloat currentSpotSpecular[] = {
-        spotLightColor[0] * spotLightIntensity * 0.5f,
-        spotLightColor[1] * spotLightIntensity * 0.5f,
-        spotLightColor[2] * spotLightIntensity * 0.5f,
-        1.0f
-    };
+        // Frame pertama (build batch / upload) dilaporkan terpisah
+        float firstMs = frameMs[0];
+        std::vector<float> sorted(frameMs.begin() + 1, frameMs.end());
+        std::sort(sorted.begin(), sorted.end());
+        float sum = 0.0f;
+        for (float ms : sorted) sum += ms;
+
+        const InstanceStats& stats = instanceRenderer.getStats();
+        char line[200];
+        snprintf(line, sizeof(line), "  %-20s first %8.2f  avg %8.2f  median %8.2f  p95 %8.2f | %d draw calls, %d triangles",
+                 InstanceRenderer::getModeName(instanceRenderer.getMode()), firstMs, sum / sorted.size(),
+                 sorted[sorted.size() / 2], sorted[std::min(sorted.size() - 1, sorted.size() * 95 / 100)],
+                 stats.drawCalls, stats.trianglesDrawn);
+        std::cout << line << std::endl;
+    }
+}
 
-    glLightfv(GL_LIGHT4, GL_DIFFUSE, currentSpotDiffuse);
-    glLightfv(GL_LIGHT4, GL_SPECULAR, currentSpotSpecular);
+// Satu-satunya jalan untuk meminta redraw (input, frame animasi maju, load selesai).
+// Permintaan saat redraw masih pending digabung dan hanya dihitung.
+void requestRedraw() {
+    if (redrawScheduler.requestRedraw()) {
+        glutPostRedisplay();
+    }
+}
 
-    if (showWireframe) {
-        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+// Timer tepat di deadline frame animasi berikutnya; saat pause hanya dipasang
+// selama frame masih dimuat, agar frame yang tiba tetap diambil dan ditampilkan
+void scheduleAnimationTick() {
+    if (animationTimerActive || !animation) {
+        return;
+    }
+    int delayMs;
+    if (animation->isAnimationPlaying()) {
+        delayMs = animation->isInterpolating() ? kInterpolatedTickMs
+                                               : (int)std::ceil(animation->getTimeToNextFrame() * 1000.0f);
+        if (animation->isLoading()) {
+            // Menunggu frame berikutnya dari loader: cukup dicek sekali per ~frame layar
+            delayMs = std::max(delayMs, kInterpolatedTickMs);
+        }
+    }
+    else if (animation->isLoading()) {
+        delayMs = kLoadPollMs;
     }
     else {
-        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+        return;
     }
+    glutTimerFunc(std::max(1, delayMs), animationTick, 0);
+    animationTimerActive = true;
+}
 
-    if (enableLighting) {
-        glEnable(GL_LIGHTING);
+void animationTick(int) {
+    animationTimerActive = false;
+    if (!animation) {
+        return;
     }
-    else {
-        glDisable(GL_LIGHTING);
+    bool playing = animation->isAnimationPlaying();
+    bool loading = animation->isLoading();
+    if (!playing && !loading) {
+        return;
     }
+    TRACE_SCOPE("animation update");
 
-    // --- Gambar Model ---
-    if (useAnimation && animation && animation->hasFrames()) {
-        auto currentTime = std::chrono::high_resolution_clock::now();
-        float deltaTime = std::chrono::duration<float>(currentTime - lastTime).count();
-        lastTime = currentTime;
+    auto currentTime = std::chrono::high_resolution_clock::now();
+    float deltaTime = std::chrono::duration<float>(currentTime - lastTime).count();
+    lastTime = currentTime;
 
-        animation->update(deltaTime);
-        animation->drawWithMaterials();
+    // Dengan interpolasi posisi pecahan pun menghasilkan gambar baru
+    auto shownPosition = [&]() {
+        return animation->isInterpolating() ? animation->getPlaybackPosition() : (float)animation->getCurrentFrame();
+    };
+    float positionBefore = shownPosition();
+    int readyBefore = animation->getKeptFrameCount();
+    animation->update(playing ? deltaTime : 0.0f);  // Saat pause hanya mengambil frame yang tiba
+    // Frame baru atau load selesai mengubah HUD (jumlah frame siap) meski posisi tetap
+    if (shownPosition() != positionBefore || animation->getKeptFrameCount() != readyBefore ||
+        animation->isLoading() != loading) {
+        requestRedraw();
     }
-    else if (objModel) {
-        if (objModel->hasMaterials()) {
-            objModel->drawWithMaterials();
-        }
-        else {
-            glColor3f(0.7f, 0.7f, 0.9f);
-            objModel->draw();
-        }
+
+    if (animation->isAnimationPlaying() || animation->isLoading()) {
+        scheduleAnimationTick();
+    }
+    if (playing && !animation->isAnimationPlaying()) {
+        redrawScheduler.sample(true);  // Animasi selesai (tanpa loop)
+    }
+}
+
+void stopTrace() {
+    traceRecorder.stop();
+}
+
+void setAnimationPlaying(bool play) {
+    redrawScheduler.sample(animation->isAnimationPlaying());
+    if (play) {
+        animation->play();
+        lastTime = std::chrono::high_resolution_clock::now();  // Waktu pause tidak ikut dihitung
+        scheduleAnimationTick();
     }
     else {
-        glColor3f(1.0f, 0.5f, 0.0f);
-        glutSolidCube(1.0);
+        animation->pause();
+    }
+}
+
+void printCpuUsage() {
+    bool playing = animation && animation->isAnimationPlaying();
+    redrawScheduler.sample(playing);
+
+    const CpuUsage& play = redrawScheduler.getPlayingUsage();
+    const CpuUsage& idle = redrawScheduler.getPausedUsage();
+    char line[200];
+    snprintf(line, sizeof(line), "CPU: playing %.1f%% over %.1f s, paused/idle %.1f%% over %.1f s | %d redraws, %d requests coalesced",
+             play.getPercent(), play.wallSeconds, idle.getPercent(), idle.wallSeconds,
+             redrawScheduler.getFramesDrawn(), redrawScheduler.getCoalescedRequests());
+    std::cout << line << std::endl;
+}
+
+// Satu view orbit untuk --bench-backends (kamera tetap, tanpa alat bantu)
+void renderBenchView(int view, int viewCount) {
+    angleX = 20.0f;
+    angleY = 360.0f * view / viewCount;
+    renderScene();
+}
+
+void display() {
+    TRACE_SCOPE("frame");
+    redrawScheduler.beginFrame();
+
+    // Tanpa HUD dan tanpa log tidak ada yang diukur
+    bool collectStats = frameStats.isActive();
+    float intervalMs = 0.0f;
+    auto frameStart = std::chrono::high_resolution_clock::now();
+    if (collectStats) {
+        intervalMs = frameStats.beginFrame();
+    }
+
+    renderScene();
+
+    // Simpan matriks untuk picking (setelah update animasi, jadi frame-nya sama dengan yang digambar)
+    ObjLoader* visibleModel = instanceRenderer.getInstanceCount() > 0 ? nullptr : getVisibleModel();
+    if (visibleModel) {
+        Vec3 c = visibleModel->getCenter();
+        float s = visibleModel->getScale();
+        glPushMatrix();
+        glScalef(s, s, s);
+        glTranslatef(-c.x, -c.y, -c.z);
+        glGetDoublev(GL_MODELVIEW_MATRIX, pickModelview);
+        glPopMatrix();
+        glGetDoublev(GL_PROJECTION_MATRIX, pickProjection);
+        glGetIntegerv(GL_VIEWPORT, pickViewport);
+        pickMatricesValid = true;
     }
 
     // --- BLOK ALAT BANTU (HELPER) ---
 
     // Matikan pencahayaan SATU KALI untuk semua alat bantu
-    glDisable(GL_LIGHTING);
+    glState.disable(GL_LIGHTING);
+
+    // Highlight face hasil picking (selalu di atas model)
+    if (visibleModel && pickedFace >= 0) {
+        glState.disable(GL_DEPTH_TEST);
+        glLineWidth(2.0f);
+        glColor3f(1.0f, 1.0f, 0.0f);
+        visibleModel->drawFaceHighlight(pickedFace);
+        glLineWidth(1.0f);
+        glState.enable(GL_DEPTH_TEST);
+    }
 
     // Blok "if (showLightMarker)" DIHAPUS
 
@@ -361,25 +710,201 @@ void display() {
 
     // Kembalikan status lighting ke status awal (yang diatur di atas)
     if (enableLighting) {
-        glEnable(GL_LIGHTING);
+        glState.enable(GL_LIGHTING);
     }
     // --- SELESAI BLOK ALAT BANTU ---
 
+    if (collectStats) {
+        recordFrameStats(intervalMs, std::chrono::duration<float, std::milli>(
+            std::chrono::high_resolution_clock::now() - frameStart).count());
+        if (frameStats.isOverlayVisible()) {
+            drawStatsOverlay();
+        }
+    }
 
     glutSwapBuffers();
 }
 
+void recordFrameStats(float intervalMs, float cpuMs) {
+    FrameRecord frame;
+    frame.intervalMs = intervalMs;
+    frame.cpuMs = cpuMs;
+
+    const GLStateStats& state = glState.getStats();
+    frame.stateCalls = state.issued;
+    frame.stateFiltered = state.filtered;
+
+    if (instanceRenderer.getInstanceCount() > 0) {
+        const InstanceStats& inst = instanceRenderer.getStats();
+        frame.drawCalls = inst.drawCalls;
+        frame.trianglesDrawn = inst.trianglesDrawn;
+        frame.objectsDrawn = inst.instancesDrawn;
+    }
+    else if (ObjLoader* model = getVisibleModel()) {
+        const DrawStats& stats = model->getDrawStats();
+        frame.drawCalls = stats.drawCalls;
+        frame.trianglesDrawn = stats.trianglesDrawn;
+        frame.objectsDrawn = stats.objectsDrawn;
+        frame.objectsCulled = stats.objectsCulled;
+    }
+    if (useAnimation && animation) {
+        frame.animationFrame = animation->getCurrentFrame();
+    }
+    frameStats.record(frame);
+}
+
+// Teks HUD di pojok kiri atas (bitmap font GLUT, proyeksi ortho sementara)
+void drawStatsOverlay() {
+    TRACE_SCOPE("stats overlay");
+    const FrameRecord* frame = frameStats.getLastFrame();
+    if (!frame) {
+        return;
+    }
+    FramePercentiles interval = frameStats.getIntervalPercentiles();
+    FramePercentiles cpu = frameStats.getCpuPercentiles();
+
+    char lines[6][128];
+    int lineCount = 0;
+    snprintf(lines[lineCount++], 128, "Frame %d | CPU %.2f ms (p50 %.2f, p95 %.2f)",
+             frameStats.getFrameCount(), frame->cpuMs, cpu.p50Ms, cpu.p95Ms);
+    if (interval.samples > 0) {
+        snprintf(lines[lineCount++], 128, "FPS median %.1f | 5%% low %.1f | 1%% low %.1f (%d frames)",
+                 1000.0f / interval.p50Ms, 1000.0f / interval.p95Ms, 1000.0f / interval.p99Ms, interval.samples);
+    }
+    else {
+        snprintf(lines[lineCount++], 128, "FPS -- (redrawn on demand)");
+    }
+    snprintf(lines[lineCount++], 128, "Draw calls %d | Triangles %d", frame->drawCalls, frame->trianglesDrawn);
+    snprintf(lines[lineCount++], 128, "GL state calls %d (%d filtered)", frame->stateCalls, frame->stateFiltered);
+    snprintf(lines[lineCount++], 128, "Objects drawn %d | culled %d", frame->objectsDrawn, frame->objectsCulled);
+    if (frame->animationFrame >= 0) {
+        if (const AnimationStream* stream = animation->getStream()) {
+            snprintf(lines[lineCount++], 128, "Animation frame %d / %d | streamed, %d resident, %d dropped",
+                     frame->animationFrame + 1, animation->getTotalFrames(), stream->getResidentFrames(),
+                     stream->getDroppedFrames());
+        }
+        else if (animation->isLoading()) {
+            snprintf(lines[lineCount++], 128, "Animation frame %d / %d | loading, %d ready",
+                     frame->animationFrame + 1, animation->getTotalFrames(), animation->getKeptFrameCount());
+        }
+        else {
+            snprintf(lines[lineCount++], 128, "Animation frame %d / %d", frame->animationFrame + 1,
+                     animation->getTotalFrames());
+        }
+    }
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    gluOrtho2D(0, viewport[2], 0, viewport[3]);
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+
+    glState.disable(GL_LIGHTING);
+    glState.disable(GL_DEPTH_TEST);
+    glColor3f(0.9f, 0.95f, 0.6f);
+    for (int i = 0; i < lineCount; i++) {
+        glRasterPos2i(10, viewport[3] - 20 - i * 16);
+        glutBitmapString(GLUT_BITMAP_8_BY_13, (const unsigned char*)lines[i]);
+    }
+    glState.enable(GL_DEPTH_TEST);
+    if (enableLighting) {
+        glState.enable(GL_LIGHTING);
+    }
+
+    glPopMatrix();
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+}
+
+// Kamera, lampu dan model; dipakai display() dan benchmark backend
+void renderScene() {
+    TRACE_SCOPE("render scene");
+    glState.resetStats();
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glClearColor(0.1f, 0.1f, 0.15f, 1.0f);
+
+    // State lewat glState: nilai yang tidak berubah sejak frame lalu tidak dikirim ulang ke GL
+    // Update Global Ambient Light
+    GLfloat currentGlobalAmbient[] = { globalAmbientLevel, globalAmbientLevel, globalAmbientLevel, 1.0f };
+    glState.lightModelAmbient(currentGlobalAmbient);
+
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+
+    glTranslatef(0.0f, 0.0f, zoom);
+    glRotatef(angleX, 1.0f, 0.0f, 0.0f);
+    glRotatef(angleY, 0.0f, 1.0f, 0.0f);
+
+    // Update posisi LIGHT3 (Point Light) - posisi selalu dikirim (ikut modelview kamera)
+    glState.lightfv(GL_LIGHT3, GL_POSITION, light3_Position);
+    // Update posisi LIGHT5 (Point Light 2)
+    glState.lightfv(GL_LIGHT5, GL_POSITION, light5_Position);
+
+    // Update Spotlight (Posisi, Arah, Intensitas, Angle, Exponent)
+    glState.lightfv(GL_LIGHT4, GL_POSITION, spotLightPosition);
+    glState.lightfv(GL_LIGHT4, GL_SPOT_DIRECTION, spotLightDirection);
+    glState.lightf(GL_LIGHT4, GL_SPOT_CUTOFF, spotLightAngle);
+    glState.lightf(GL_LIGHT4, GL_SPOT_EXPONENT, spotLightExponent);
+
+    GLfloat currentSpotDiffuse[] = {
+        spotLightColor[0] * spotLightIntensity,
+        spotLightColor[1] * spotLightIntensity,
+        spotLightColor[2] * spotLightIntensity,
+        1.0f
+    };
+    GLfloat currentSpotSpecular[] = {
+        spotLightColor[0] * spotLightIntensity * 0.5f,
+        spotLightColor[1] * spotLightIntensity * 0.5f,
+        spotLightColor[2] * spotLightIntensity * 0.5f,
+        1.0f
+    };
+
+    glState.lightfv(GL_LIGHT4, GL_DIFFUSE, currentSpotDiffuse);
+    glState.lightfv(GL_LIGHT4, GL_SPECULAR, currentSpotSpecular);
+
+    glState.polygonMode(showWireframe ? GL_LINE : GL_FILL);
+    glState.setEnabled(GL_LIGHTING, enableLighting);
+
+    // --- Gambar Model ---
+    // Frame animasi dimajukan oleh animationTick(), di sini hanya digambar
+    if (useAnimation && animation && animation->hasFrames()) {
+        animation->drawWithMaterials();
+    }
+    else if (instanceRenderer.getInstanceCount() > 0) {
+        instanceRenderer.draw();
+    }
+    else if (objModel) {
+        if (objModel->hasMaterials()) {
+            objModel->drawWithMaterials();
+        }
+        else {
+            glColor3f(0.7f, 0.7f, 0.9f);
+            objModel->draw();
+        }
+    }
+    else {
+        glColor3f(1.0f, 0.5f, 0.0f);
+        glutSolidCube(1.0);
+    }
+}
+
 void reshape(int w, int h) {
     glViewport(0, 0, w, h);
     glMatrixMode(GL_PROJECTION);
     glLoadIdentity();
-    gluPerspective(45.0, (double)w / (double)h, 0.1, 100.0);
+    gluPerspective(45.0, (double)w / (double)h, 0.1, farPlane);
     glMatrixMode(GL_MODELVIEW);
 }
 
 void keyboard(unsigned char key, int x, int y) {
     switch (key) {
     case 27: // ESC
+        printCpuUsage();
         exit(0);
         break;
     case 'w': case 'W':
@@ -407,19 +932,103 @@ void keyboard(unsigned char key, int x, int y) {
         std::cout << "Axis: " << (showAxis ? "ON" : "OFF") << std::endl;
         break;
 
+    case 'c': case 'C':
+        frustumCulling = !frustumCulling;
+        if (objModel) objModel->setFrustumCulling(frustumCulling);
+        if (animation) animation->setFrustumCulling(frustumCulling);
+        std::cout << "Frustum culling: " << (frustumCulling ? "ON" : "OFF") << std::endl;
+        break;
+    case 'i': case 'I':
+        if (ObjLoader* model = getVisibleModel()) {
+            const DrawStats& stats = model->getDrawStats();
+            std::cout << "Objects drawn/culled: " << stats.objectsDrawn << "/" << stats.objectsCulled
+                      << " | Triangles drawn/culled: " << stats.trianglesDrawn << "/" << stats.trianglesCulled
+                      << " | Material changes: " << stats.materialChanges
+                      << " (file order: " << model->getFileOrderMaterialChanges() << ")" << std::endl;
+            const RenderBackend* backend = model->getRenderBackend();
+            std::cout << "Draw submit: " << stats.submitMs << " ms (backend "
+                      << getRenderBackendName(model->getRenderBackendType()) << ", "
+                      << (backend ? backend->getRetainedBytes() / 1024 : 0) << " KB retained)" << std::endl;
+            const GLStateStats& state = glState.getStats();
+            std::cout << "GL state calls: " << state.issued << " issued, " << state.filtered
+                      << " filtered as redundant" << std::endl;
+            printCpuUsage();
+            if (model->getTransparentTriangleCount() > 0) {
+                std::cout << "Transparent: " << stats.transparentTriangles << " triangles sorted back-to-front in "
+                          << stats.transparentSortMs << " ms" << std::endl;
+            }
+            if (instanceRenderer.getInstanceCount() > 0) {
+                const InstanceStats& inst = instanceRenderer.getStats();
+                std::cout << "Instances: " << inst.instancesDrawn << " (" << InstanceRenderer::getModeName(instanceRenderer.getMode())
+                          << ") | " << inst.drawCalls << " draw calls, " << inst.trianglesDrawn << " triangles | submit "
+                          << inst.submitMs << " ms" << std::endl;
+            }
+            if (occlusionCulling) {
+                const OcclusionStats& occ = occlusionCuller.getStats();
+                std::cout << "Occlusion: " << stats.objectsOccluded << " objects / " << stats.trianglesOccluded
+                          << " triangles hidden | " << occ.occluderCount << " occluders, "
+                          << occ.occluderTriangles << " triangles rasterized | raster " << occ.rasterMs
+                          << " ms, test " << occ.testMs << " ms (" << occlusionCuller.getThreadCount()
+                          << " threads)" << std::endl;
+            }
+        }
+        break;
+    case 'x': case 'X':
+        occlusionCulling = !occlusionCulling;
+        if (objModel) objModel->setOcclusionCuller(occlusionCulling ? &occlusionCuller : nullptr);
+        if (animation) animation->setOcclusionCuller(occlusionCulling ? &occlusionCuller : nullptr);
+        std::cout << "Occlusion culling: " << (occlusionCulling ? "ON" : "OFF") << std::endl;
+        break;
+    case 'v': case 'V':
+        applyRenderBackend((RenderBackendType)((renderBackend + 1) % RENDER_BACKEND_COUNT));
+        std::cout << "Render backend: " << getRenderBackendName(renderBackend)
+                  << (isRenderBackendSupported(renderBackend) ? "" : " (not supported, falls back)") << std::endl;
+        break;
+
+    case 'h': case 'H':
+        frameStats.setOverlayVisible(!frameStats.isOverlayVisible());
+        std::cout << "Stats overlay: " << (frameStats.isOverlayVisible() ? "ON" : "OFF") << std::endl;
+        break;
+    case 'u': case 'U':
+        // Memori model/animasi per kategori (dihitung saat tombol ditekan)
+        if (useAnimation && animation && animation->isStreaming()) {
+            const AnimationStream* stream = animation->getStream();
+            std::cout << "Memory (" << stream->getResidentFrames() << " of " << animation->getTotalFrames()
+                      << " animation frames resident, " << stream->getDroppedFrames() << " dropped):" << std::endl;
+            animation->getMemoryUsage().print(std::cout);
+        }
+        else if (useAnimation && animation) {
+            std::cout << "Memory (" << animation->getTotalFrames() << " animation frames):" << std::endl;
+            animation->getMemoryUsage().print(std::cout);
+        }
+        else if (objModel) {
+            std::cout << "Memory:" << std::endl;
+            objModel->getMemoryUsage().print(std::cout);
+        }
+        break;
+    case 'n': case 'N':
+        if (instanceRenderer.getInstanceCount() > 0) {
+            InstanceRenderer::Mode mode = (InstanceRenderer::Mode)((instanceRenderer.getMode() + 1) % 3);
+            instanceRenderer.setMode(mode);
+            std::cout << "Instancing mode: " << InstanceRenderer::getModeName(mode) << std::endl;
+        }
+        break;
+
         // Case untuk 'b' / 'B' DIHAPUS
 
     case ' ':
         if (useAnimation && animation) {
-            if (animation->isAnimationPlaying()) animation->pause();
-            else animation->play();
+            setAnimationPlaying(!animation->isAnimationPlaying());
         }
         break;
     case 'p': case 'P':
-        if (useAnimation && animation) animation->play();
+        if (useAnimation && animation) setAnimationPlaying(true);
         break;
     case 'o': case 'O':
-        if (useAnimation && animation) animation->stop();
+        if (useAnimation && animation) {
+            redrawScheduler.sample(animation->isAnimationPlaying());
+            animation->stop();
+        }
         break;
 
     case '[':
@@ -431,6 +1040,12 @@ void keyboard(unsigned char key, int x, int y) {
     case ']':
         if (useAnimation && animation) animation->setFPS(animation->getFPS() + 5.0f);
         break;
+    case 'e': case 'E':
+        if (useAnimation && animation) animation->setReverse(!animation->isReversed());
+        break;
+    case 'j': case 'J':
+        if (useAnimation && animation) animation->setInterpolation(!animation->isInterpolating());
+        break;
 
         // --- Kontrol Spotlight Intensity ---
     case '-':
@@ -491,7 +1106,7 @@ void keyboard(unsigned char key, int x, int y) {
         std::cout << "Light3 Pos Z: " << light3_Position[2] << std::endl;
         break;
     }
-    glutPostRedisplay();
+    requestRedraw();
 }
 
 void specialKeyboard(int key, int x, int y) {
@@ -532,19 +1147,87 @@ void specialKeyboard(int key, int x, int y) {
         std::cout << "Light5 Pos Z: " << light5_Position[2] << std::endl;
         break;
     }
-    glutPostRedisplay();
+    requestRedraw();
 }
 
 
+ObjLoader* getVisibleModel() {
+    if (useAnimation && animation && animation->hasFrames()) {
+        return animation->getCurrentModel();
+    }
+    return objModel;
+}
+
+void pickAt(int x, int y) {
+    TRACE_SCOPE("pick");
+    ObjLoader* model = getVisibleModel();
+    if (!model || !pickMatricesValid) {
+        return;
+    }
+
+    if (!pickBvh.isBuiltFor(model)) {
+        auto buildStart = std::chrono::high_resolution_clock::now();
+        pickBvh.build(*model);
+        float buildMs = std::chrono::duration<float, std::milli>(
+            std::chrono::high_resolution_clock::now() - buildStart).count();
+        std::cout << "Pick BVH built: " << pickBvh.getTriangleCount() << " triangles, "
+                  << pickBvh.getNodeCount() << " nodes (" << buildMs << " ms)" << std::endl;
+    }
+
+    auto pickStart = std::chrono::high_resolution_clock::now();
+
+    // Unproject kursor ke near/far plane dalam ruang model
+    GLdouble winX = x;
+    GLdouble winY = pickViewport[3] - y;
+    GLdouble nx, ny, nz, fx, fy, fz;
+    gluUnProject(winX, winY, 0.0, pickModelview, pickProjection, pickViewport, &nx, &ny, &nz);
+    gluUnProject(winX, winY, 1.0, pickModelview, pickProjection, pickViewport, &fx, &fy, &fz);
+
+    Vec3 origin((float)nx, (float)ny, (float)nz);
+    Vec3 direction((float)(fx - nx), (float)(fy - ny), (float)(fz - nz));
+    float length = std::sqrt(direction.x * direction.x + direction.y * direction.y + direction.z * direction.z);
+    if (length > 0.0f) {
+        direction = Vec3(direction.x / length, direction.y / length, direction.z / length);
+    }
+
+    RayHit hit;
+    bool found = pickBvh.intersect(origin, direction, hit);
+
+    float pickMs = std::chrono::duration<float, std::milli>(
+        std::chrono::high_resolution_clock::now() - pickStart).count();
+
+    if (!found) {
+        pickedFace = -1;
+        std::cout << "Pick: nothing (" << pickMs << " ms)" << std::endl;
+        return;
+    }
+
+    pickedFace = hit.faceIndex;
+    const Face& face = model->getFaces()[hit.faceIndex];
+    std::string objectName = face.objectIndex >= 0 ? model->getObjects()[face.objectIndex].name : "default";
+    std::cout << "Pick: face " << hit.faceIndex
+              << " | object '" << objectName << "'"
+              << " | material '" << (face.materialName.empty() ? "(none)" : face.materialName) << "'"
+              << " | " << pickMs << " ms" << std::endl;
+}
+
 void mouse(int button, int state, int x, int y) {
     if (button == GLUT_LEFT_BUTTON) {
         if (state == GLUT_DOWN) {
             isRotating = true;
             lastMouseX = x;
             lastMouseY = y;
+            mouseDownX = x;
+            mouseDownY = y;
         }
         else {
             isRotating = false;
+
+            // Klik tanpa drag = picking
+            if (std::abs(x - mouseDownX) <= 2 && std::abs(y - mouseDownY) <= 2) {
+                pickAt(x, y);
+                requestRedraw();
+            }
         }
     }
 }
@@ -557,6 +1240,7 @@ void motion(int x, int y) {
         lastMouseX = x;
         lastMouseY = y;
 
-        glutPostRedisplay();
+        // Sudut langsung diakumulasi; semua event motion sebelum display() berikutnya jadi satu redraw
+        requestRedraw();
     }
 }
\ No newline at end of file
@@ -0,0 +1,76 @@
+// Packs a frame range of an OBJ sequence into one .anim container
+// (AnimContainer.h) that the viewer loads or streams without parsing.
+// All frames must share the first frame's faces and materials. With
+// --decimate T only the frames decimation keeps are stored, with their
+// frame numbers, and the viewer interpolates between them. Identical frames
+// share one block.
+// Textures are not stored: keep them beside the .anim file.
+//
+// Usage: AnimPack base start end out.anim [--decimate T] [--load-threads N]
+
+#include <iostream>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "AnimationLoader.h"
+#include "AnimContainer.h"
+
+int main(int argc, char** argv) {
+    if (argc < 5) {
+        std::cerr << "Usage: " << argv[0] << " base start end out.anim [--decimate T] [--load-threads N]" << std::endl;
+        std::cerr << "Example: " << argv[0] << " Models/Anim/AnimatedObject 1 50 Models/Anim/AnimatedObject.anim"
+                  << std::endl;
+        return 1;
+    }
+    std::string base = argv[1];
+    int startFrame = std::atoi(argv[2]);
+    int endFrame = std::atoi(argv[3]);
+    std::string output = argv[4];
+    float decimateTolerance = 0.0f;
+    int loadThreads = 0;
+
+    for (int i = 5; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--decimate" && i + 1 < argc) {
+            decimateTolerance = (float)std::atof(argv[++i]);
+        }
+        else if (arg == "--load-threads" && i + 1 < argc) {
+            loadThreads = std::atoi(argv[++i]);
+        }
+        else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    AnimationLoader animation;
+    animation.setVerbose(false);
+    animation.setLoadThreads(loadThreads);
+    animation.setTextureLoading(TEXTURES_SKIP);
+    if (!animation.loadAnimationSequence(base, startFrame, endFrame)) {
+        return 1;
+    }
+    if (decimateTolerance > 0.0f) {
+        animation.decimateFrames(decimateTolerance);
+    }
+
+    std::vector<const ObjLoader*> frames;
+    std::vector<int> frameNumbers;
+    for (int i = 0; i < animation.getKeptFrameCount(); i++) {
+        frames.push_back(animation.getFrame(i));
+        frameNumbers.push_back(animation.getFrameNumber(i));
+    }
+    if (!writeAnimContainer(output, frames, frameNumbers)) {
+        return 1;
+    }
+
+    AnimContainer container;
+    if (!container.open(output)) {
+        return 1;
+    }
+    std::cout << "Packed " << container.getFrameCount() << " of " << animation.getTotalFrames() << " frames, "
+              << animation.getUniqueFrameCount() << " unique ("
+              << container.getVertexCount() << " positions, " << container.getNormalCount()
+              << " normals each) into " << output << ", " << container.getFileSize() / 1024 << " KB" << std::endl;
+    return 0;
+}
@@ -0,0 +1,64 @@
+@echo off
+echo ================================
+echo OBJ Viewer Benchmarks
+echo ================================
+echo.
+
+cd /d "%~dp0"
+
+REM Add local MinGW to PATH if it exists
+if exist "%~dp0mingw64\bin" set PATH=%~dp0mingw64\bin;%PATH%
+if exist "C:\MinGW\bin" set PATH=C:\MinGW\bin;%PATH%
+if exist "C:\msys64\mingw64\bin" set PATH=C:\msys64\mingw64\bin;%PATH%
+
+REM Benchmarks are headless: no window is opened, GL is only linked
+echo Compiling benchmarks...
+g++ -O2 -c Core\ObjLoader.cpp -o Core\ObjLoader.o -ICore -DFREEGLUT_STATIC
+g++ -O2 -c Core\AnimationLoader.cpp -o Core\AnimationLoader.o -ICore -DFREEGLUT_STATIC
+g++ -O2 -c Core\AnimationStream.cpp -o Core\AnimationStream.o -ICore -DFREEGLUT_STATIC
+g++ -O2 -c Core\AnimContainer.cpp -o Core\AnimContainer.o -ICore -DFREEGLUT_STATIC
+g++ -O2 -c Core\Frustum.cpp -o Core\Frustum.o -ICore -DFREEGLUT_STATIC
+g++ -O2 -c Core\OcclusionCuller.cpp -o Core\OcclusionCuller.o -ICore -DFREEGLUT_STATIC
+g++ -O2 -c Core\DepthSorter.cpp -o Core\DepthSorter.o -ICore -DFREEGLUT_STATIC
+g++ -O2 -c Core\GLExtensions.cpp -o Core\GLExtensions.o -ICore -DFREEGLUT_STATIC
+g++ -O2 -c Core\GLStateCache.cpp -o Core\GLStateCache.o -ICore -DFREEGLUT_STATIC
+g++ -O2 -c Core\Trace.cpp -o Core\Trace.o -ICore -DFREEGLUT_STATIC
+g++ -O2 -c Core\VertexCodec.cpp -o Core\VertexCodec.o -ICore -DFREEGLUT_STATIC
+g++ -O2 -c Core\MeshBuffers.cpp -o Core\MeshBuffers.o -ICore -DFREEGLUT_STATIC
+g++ -O2 -c Core\RenderBackend.cpp -o Core\RenderBackend.o -ICore -DFREEGLUT_STATIC
+g++ -O2 -o OcclusionBench.exe Bench\OcclusionBench.cpp Core\ObjLoader.o Core\Frustum.o Core\OcclusionCuller.o Core\DepthSorter.o Core\GLExtensions.o Core\GLStateCache.o Core\MeshBuffers.o Core\RenderBackend.o Core\Trace.o -ICore -DFREEGLUT_STATIC -lopengl32 -lglu32 -static
+g++ -O2 -o DepthSortBench.exe Bench\DepthSortBench.cpp Core\DepthSorter.o -ICore -static
+g++ -O2 -o LoadBench.exe Bench\LoadBench.cpp Core\ObjLoader.o Core\Frustum.o Core\OcclusionCuller.o Core\DepthSorter.o Core\GLExtensions.o Core\GLStateCache.o Core\MeshBuffers.o Core\RenderBackend.o Core\Trace.o -ICore -DFREEGLUT_STATIC -lopengl32 -lglu32 -lpsapi -static
+g++ -O2 -o AnimLoadBench.exe Bench\AnimLoadBench.cpp Core\AnimationLoader.o Core\AnimationStream.o Core\AnimContainer.o Core\ObjLoader.o Core\Frustum.o Core\OcclusionCuller.o Core\DepthSorter.o Core\GLExtensions.o Core\GLStateCache.o Core\MeshBuffers.o Core\RenderBackend.o Core\Trace.o -ICore -DFREEGLUT_STATIC -lopengl32 -lglu32 -lpsapi -static
+g++ -O2 -o CodecBench.exe Bench\CodecBench.cpp Core\AnimationLoader.o Core\AnimationStream.o Core\AnimContainer.o Core\VertexCodec.o Core\ObjLoader.o Core\Frustum.o Core\OcclusionCuller.o Core\DepthSorter.o Core\GLExtensions.o Core\GLStateCache.o Core\MeshBuffers.o Core\RenderBackend.o Core\Trace.o -ICore -DFREEGLUT_STATIC -lopengl32 -lglu32 -static
+g++ -O2 -o ContainerBench.exe Bench\ContainerBench.cpp Core\AnimationLoader.o Core\AnimationStream.o Core\AnimContainer.o Core\ObjLoader.o Core\Frustum.o Core\OcclusionCuller.o Core\DepthSorter.o Core\GLExtensions.o Core\GLStateCache.o Core\MeshBuffers.o Core\RenderBackend.o Core\Trace.o -ICore -DFREEGLUT_STATIC -lopengl32 -lglu32 -lpsapi -static
+g++ -O2 -o AnimPack.exe Tools\AnimPack.cpp Core\AnimationLoader.o Core\AnimationStream.o Core\AnimContainer.o Core\ObjLoader.o Core\Frustum.o Core\OcclusionCuller.o Core\DepthSorter.o Core\GLExtensions.o Core\GLStateCache.o Core\MeshBuffers.o Core\RenderBackend.o Core\Trace.o -ICore -DFREEGLUT_STATIC -lopengl32 -lglu32 -static
+
+if %ERRORLEVEL% NEQ 0 (
+    echo.
+    echo Compilation failed!
+    pause
+    exit /b 1
+)
+
+echo.
+echo --- Occlusion culling (CPU rasterizer) ---
+OcclusionBench.exe Models\All.obj 120
+echo.
+echo --- Transparent depth sort (100k triangles) ---
+DepthSortBench.exe 100000 300 1
+DepthSortBench.exe 100000 300 0
+echo.
+echo --- OBJ load time (Models, Models\Anim) ---
+LoadBench.exe --reps 5 --json load.json
+echo.
+echo --- Animation load, 1..N threads ---
+AnimLoadBench.exe --json anim_load.json
+echo.
+echo --- Animation container (.anim) vs OBJ sequence ---
+ContainerBench.exe --anim AnimatedObject.anim --json container.json
+echo.
+echo --- Vertex animation codec ---
+CodecBench.exe --json codec.json
+echo.
+pause
@@ -0,0 +1,51 @@
+#!/bin/sh
+# Linux counterpart of bench.bat: builds the headless benchmarks and runs them.
+# RenderBench needs EGL with EGL_MESA_platform_surfaceless (Mesa llvmpipe is
+# enough, no GPU or display). Packages on Debian/Ubuntu:
+#   g++ freeglut3-dev libglu1-mesa-dev libegl1-mesa-dev
+# "./bench.sh build" only builds (e.g. before running bench_build/PerfGate).
+set -e
+cd "$(dirname "$0")"
+
+CXXFLAGS="-O2 -fpermissive -ICore"
+OUT=bench_build
+mkdir -p $OUT
+
+echo "Compiling benchmarks..."
+for src in ObjLoader AnimationLoader AnimationStream AnimContainer Frustum OcclusionCuller DepthSorter GLExtensions GLStateCache MeshBuffers RenderBackend Trace VertexCodec; do
+    g++ $CXXFLAGS -c Core/$src.cpp -o $OUT/$src.o
+done
+LOADER_OBJS="$OUT/ObjLoader.o $OUT/Frustum.o $OUT/OcclusionCuller.o $OUT/DepthSorter.o $OUT/GLExtensions.o $OUT/GLStateCache.o $OUT/MeshBuffers.o $OUT/RenderBackend.o $OUT/Trace.o"
+
+g++ $CXXFLAGS -o $OUT/OcclusionBench Bench/OcclusionBench.cpp $LOADER_OBJS -lGLU -lGL -lpthread
+g++ $CXXFLAGS -o $OUT/DepthSortBench Bench/DepthSortBench.cpp $OUT/DepthSorter.o -lpthread
+g++ $CXXFLAGS -o $OUT/LoadBench Bench/LoadBench.cpp $LOADER_OBJS -lGLU -lGL -lpthread
+g++ $CXXFLAGS -o $OUT/AnimLoadBench Bench/AnimLoadBench.cpp $LOADER_OBJS $OUT/AnimationLoader.o $OUT/AnimationStream.o $OUT/AnimContainer.o -lGLU -lGL -lpthread
+g++ $CXXFLAGS -o $OUT/CodecBench Bench/CodecBench.cpp $LOADER_OBJS $OUT/AnimationLoader.o $OUT/AnimationStream.o $OUT/AnimContainer.o $OUT/VertexCodec.o -lGLU -lGL -lpthread
+g++ $CXXFLAGS -o $OUT/RenderBench Bench/RenderBench.cpp $LOADER_OBJS $OUT/AnimationLoader.o $OUT/AnimationStream.o $OUT/AnimContainer.o -lEGL -lGLU -lGL -lpthread
+g++ $CXXFLAGS -o $OUT/ContainerBench Bench/ContainerBench.cpp $LOADER_OBJS $OUT/AnimationLoader.o $OUT/AnimationStream.o $OUT/AnimContainer.o -lGLU -lGL -lpthread
+g++ $CXXFLAGS -o $OUT/PerfGate Bench/PerfGate.cpp
+g++ $CXXFLAGS -o $OUT/AnimPack Tools/AnimPack.cpp $LOADER_OBJS $OUT/AnimationLoader.o $OUT/AnimationStream.o $OUT/AnimContainer.o -lGLU -lGL -lpthread
+
+if [ "$1" = "build" ]; then
+    exit 0
+fi
+
+echo
+echo "--- OBJ load time (Models, Models/Anim) ---"
+$OUT/LoadBench --reps 3 --json $OUT/load.json
+echo
+echo "--- Animation load, 1..N threads ---"
+$OUT/AnimLoadBench --json $OUT/anim_load.json
+echo
+echo "--- Animation container (.anim) vs OBJ sequence ---"
+$OUT/ContainerBench --anim $OUT/AnimatedObject.anim --json $OUT/container.json
+echo
+echo "--- Vertex animation codec ---"
+$OUT/CodecBench --json $OUT/codec.json
+echo
+echo "--- Render, static model ---"
+$OUT/RenderBench Models/All.obj --frames 240 --json $OUT/render.json
+echo
+echo "--- Render, animation ---"
+$OUT/RenderBench -a Models/Anim/AnimatedObject 1 50 --frames 240 --json $OUT/render_anim.json
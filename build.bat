@@ -15,12 +15,28 @@ echo Compiling with static libraries (no DLL dependencies)...
 echo.
 echo [          ] 0%%
 g++ -c Core\main.cpp -o Core\main.o -ICore -DFREEGLUT_STATIC -static-libgcc -static-libstdc++ 2>nul
-echo [===       ] 33%% - Compiling main.cpp
+echo [==        ] 25%% - Compiling main.cpp
 g++ -c Core\ObjLoader.cpp -o Core\ObjLoader.o -ICore -DFREEGLUT_STATIC -static-libgcc -static-libstdc++ 2>nul
-echo [======    ] 66%% - Compiling ObjLoader.cpp
+echo [=====     ] 50%% - Compiling ObjLoader.cpp
 g++ -c Core\AnimationLoader.cpp -o Core\AnimationLoader.o -ICore -DFREEGLUT_STATIC -static-libgcc -static-libstdc++ 2>nul
-echo [=========-] 90%% - Compiling AnimationLoader.cpp
-g++ -o ObjViewer.exe Core\main.o Core\ObjLoader.o Core\AnimationLoader.o -lfreeglut_static -lopengl32 -lglu32 -lwinmm -lgdi32 -static-libgcc -static-libstdc++ -static 2>nul
+g++ -c Core\AnimationStream.cpp -o Core\AnimationStream.o -ICore -DFREEGLUT_STATIC -static-libgcc -static-libstdc++ 2>nul
+g++ -c Core\AnimContainer.cpp -o Core\AnimContainer.o -ICore -DFREEGLUT_STATIC -static-libgcc -static-libstdc++ 2>nul
+echo [=======   ] 70%% - Compiling AnimationLoader.cpp, AnimationStream.cpp, AnimContainer.cpp
+g++ -c Core\Bvh.cpp -o Core\Bvh.o -ICore -DFREEGLUT_STATIC -static-libgcc -static-libstdc++ 2>nul
+g++ -c Core\Frustum.cpp -o Core\Frustum.o -ICore -DFREEGLUT_STATIC -static-libgcc -static-libstdc++ 2>nul
+g++ -O2 -c Core\OcclusionCuller.cpp -o Core\OcclusionCuller.o -ICore -DFREEGLUT_STATIC -static-libgcc -static-libstdc++ 2>nul
+g++ -O2 -c Core\DepthSorter.cpp -o Core\DepthSorter.o -ICore -DFREEGLUT_STATIC -static-libgcc -static-libstdc++ 2>nul
+g++ -c Core\GLExtensions.cpp -o Core\GLExtensions.o -ICore -DFREEGLUT_STATIC -static-libgcc -static-libstdc++ 2>nul
+g++ -O2 -c Core\GLStateCache.cpp -o Core\GLStateCache.o -ICore -DFREEGLUT_STATIC -static-libgcc -static-libstdc++ 2>nul
+g++ -O2 -c Core\MeshBuffers.cpp -o Core\MeshBuffers.o -ICore -DFREEGLUT_STATIC -static-libgcc -static-libstdc++ 2>nul
+g++ -c Core\RenderBackend.cpp -o Core\RenderBackend.o -ICore -DFREEGLUT_STATIC -static-libgcc -static-libstdc++ 2>nul
+g++ -c Core\BackendBench.cpp -o Core\BackendBench.o -ICore -DFREEGLUT_STATIC -static-libgcc -static-libstdc++ 2>nul
+g++ -O2 -c Core\InstanceRenderer.cpp -o Core\InstanceRenderer.o -ICore -DFREEGLUT_STATIC -static-libgcc -static-libstdc++ 2>nul
+g++ -c Core\RedrawScheduler.cpp -o Core\RedrawScheduler.o -ICore -DFREEGLUT_STATIC -static-libgcc -static-libstdc++ 2>nul
+g++ -c Core\FrameStats.cpp -o Core\FrameStats.o -ICore -DFREEGLUT_STATIC -static-libgcc -static-libstdc++ 2>nul
+g++ -c Core\Trace.cpp -o Core\Trace.o -ICore -DFREEGLUT_STATIC -static-libgcc -static-libstdc++ 2>nul
+echo [=========-] 90%% - Compiling Bvh.cpp, Frustum.cpp, OcclusionCuller.cpp, DepthSorter.cpp, GLExtensions.cpp, GLStateCache.cpp, MeshBuffers.cpp, RenderBackend.cpp, BackendBench.cpp, InstanceRenderer.cpp, RedrawScheduler.cpp, FrameStats.cpp, Trace.cpp
+g++ -o ObjViewer.exe Core\main.o Core\ObjLoader.o Core\AnimationLoader.o Core\AnimationStream.o Core\AnimContainer.o Core\Bvh.o Core\Frustum.o Core\OcclusionCuller.o Core\DepthSorter.o Core\GLExtensions.o Core\GLStateCache.o Core\MeshBuffers.o Core\RenderBackend.o Core\BackendBench.o Core\InstanceRenderer.o Core\RedrawScheduler.o Core\FrameStats.o Core\Trace.o -lfreeglut_static -lopengl32 -lglu32 -lwinmm -lgdi32 -static-libgcc -static-libstdc++ -static 2>nul
 echo [==========] 100%% - Linking executable
 echo.
 